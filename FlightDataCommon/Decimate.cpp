@@ -0,0 +1,71 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// Decimate.cpp
+// Per-pixel-column min/max reduction of plotted data series.
+// ==============================================================
+
+#include "Decimate.h"
+
+MinMaxDecimator::MinMaxDecimator ()
+{
+	bkt = 0;
+	nhist = ncol = span = nbkt = 0;
+	total = 0;
+}
+
+MinMaxDecimator::~MinMaxDecimator ()
+{
+	if (bkt) delete []bkt;
+}
+
+void MinMaxDecimator::Setup (int _nhist, int _ncol)
+{
+	if (_ncol < 1) _ncol = 1;
+	if (_nhist == nhist && _ncol == ncol) return;
+	nhist = _nhist;
+	ncol  = _ncol;
+	span  = (nhist+ncol-1)/ncol;
+	if (span < 1) span = 1;
+	// a partial bucket at either end of the history
+	nbkt  = nhist/span + 2;
+	if (bkt) delete []bkt;
+	bkt = new Bucket[nbkt];
+	Reset();
+}
+
+void MinMaxDecimator::Reset ()
+{
+	total = 0;
+}
+
+void MinMaxDecimator::Append (float x, float y)
+{
+	if (!nbkt) return;
+	Bucket &b = bkt[(total/span) % nbkt];
+	DecPoint p = {x, y, total};
+	if (!(total % span)) b.lo = b.hi = p;
+	else if (y < b.lo.y) b.lo = p;
+	else if (y > b.hi.y) b.hi = p;
+	total++;
+}
+
+// Writes the reduced series to out (at least MaxPoints() entries) and
+// returns the number of points. A bucket whose oldest sample has left the
+// history is dropped, so at most span-1 of the oldest samples are hidden.
+int MinMaxDecimator::Reduce (DecPoint *out) const
+{
+	if (!total) return 0;
+	long first = total-nhist;
+	if (first < 0) first = 0;
+	long k, k0 = (first+span-1)/span, k1 = (total-1)/span;
+	int n = 0;
+	for (k = k0; k <= k1; k++) {
+		const Bucket &b = bkt[k % nbkt];
+		if (b.lo.n == b.hi.n) out[n++] = b.lo;
+		else if (b.lo.n < b.hi.n) out[n++] = b.lo, out[n++] = b.hi;
+		else out[n++] = b.hi, out[n++] = b.lo;
+	}
+	return n;
+}
@@ -0,0 +1,46 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// Decimate.h
+// Per-pixel-column min/max reduction of plotted data series.
+// ==============================================================
+
+#ifndef __DECIMATE_H
+#define __DECIMATE_H
+
+struct DecPoint {
+	float x, y;  // point coordinates
+	long n;      // absolute sample number
+};
+
+// Reduces the most recent nhist samples of a series to at most two points
+// (the minimum and maximum of y) per pixel column, in chronological order.
+// Buckets are aligned on the absolute sample number, so appending a sample
+// only updates the newest bucket and the reduction stays valid between
+// frames. Reduce() costs O(ncol), independent of the history length.
+class MinMaxDecimator {
+public:
+	MinMaxDecimator ();
+	~MinMaxDecimator ();
+	void Setup (int _nhist, int _ncol);
+	void Reset ();
+	void Append (float x, float y);
+	int  Reduce (DecPoint *out) const;
+	int  MaxPoints () const { return 2*nbkt; }
+	int  Columns () const { return ncol; }
+	int  Span () const { return span; }
+	long Total () const { return total; }
+
+private:
+	struct Bucket {
+		DecPoint lo, hi;  // samples with minimum and maximum y
+	} *bkt;
+	int nhist;    // number of samples in the history
+	int ncol;     // number of pixel columns
+	int span;     // samples per bucket
+	int nbkt;     // bucket ring size
+	long total;   // samples appended since the last reset
+};
+
+#endif // !__DECIMATE_H
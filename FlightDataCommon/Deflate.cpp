@@ -0,0 +1,218 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// Deflate.cpp
+// Small streaming zlib (RFC 1950/1951) compressor.
+// ==============================================================
+
+#include <cstring>
+#include "Deflate.h"
+
+static const int len_base[29] = {
+	3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258
+};
+static const int len_extra[29] = {
+	0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0
+};
+static const int dist_base[30] = {
+	1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,
+	4097,6145,8193,12289,16385,24577
+};
+static const int dist_extra[30] = {
+	0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13
+};
+
+unsigned int Crc32 (unsigned int crc, const unsigned char *buf, size_t n)
+{
+	static unsigned int table[256];
+	static bool init = false;
+	if (!init) {
+		for (unsigned int i = 0; i < 256; i++) {
+			unsigned int c = i;
+			for (int k = 0; k < 8; k++) c = (c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1);
+			table[i] = c;
+		}
+		init = true;
+	}
+	crc = ~crc;
+	for (size_t i = 0; i < n; i++) crc = table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+unsigned int Adler32 (unsigned int adler, const unsigned char *buf, size_t n)
+{
+	unsigned int a = adler & 0xffff, b = adler >> 16;
+	while (n) {
+		size_t k = (n < 5552 ? n : 5552);  // no overflow before the modulo
+		n -= k;
+		while (k--) a += *buf++, b += a;
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+// reverse the lowest n bits of v (Huffman codes are sent MSB first)
+static unsigned int Reverse (unsigned int v, int n)
+{
+	unsigned int r = 0;
+	for (int i = 0; i < n; i++, v >>= 1) r = (r << 1) | (v & 1);
+	return r;
+}
+
+Deflater::Deflater ()
+{
+	win  = new unsigned char[2*WSIZE];
+	head = new int[1 << HBITS];
+	prev = new int[WSIZE];
+	for (int i = 0; i < (1 << HBITS); i++) head[i] = -1;
+	fill = pos = 0;
+	bitbuf = 0;
+	nbits = 0;
+	adler = 1;
+	nin = 0;
+	started = false;
+}
+
+Deflater::~Deflater ()
+{
+	delete []win;
+	delete []head;
+	delete []prev;
+}
+
+void Deflater::PutBits (unsigned int v, int n, std::vector<unsigned char> &out)
+{
+	bitbuf |= v << nbits;
+	nbits += n;
+	while (nbits >= 8) {
+		out.push_back ((unsigned char)bitbuf);
+		bitbuf >>= 8;
+		nbits -= 8;
+	}
+}
+
+void Deflater::PutLiteral (int c, std::vector<unsigned char> &out)
+{
+	if (c < 144)      PutBits (Reverse (0x30+c, 8), 8, out);
+	else if (c < 256) PutBits (Reverse (0x190+c-144, 9), 9, out);
+	else if (c < 280) PutBits (Reverse (c-256, 7), 7, out);
+	else              PutBits (Reverse (0xc0+c-280, 8), 8, out);
+}
+
+void Deflater::PutMatch (int len, int dist, std::vector<unsigned char> &out)
+{
+	int i;
+	for (i = 28; len_base[i] > len; i--);
+	PutLiteral (257+i, out);
+	if (len_extra[i]) PutBits (len-len_base[i], len_extra[i], out);
+	for (i = 29; dist_base[i] > dist; i--);
+	PutBits (Reverse (i, 5), 5, out);
+	if (dist_extra[i]) PutBits (dist-dist_base[i], dist_extra[i], out);
+}
+
+unsigned int Deflater::Hash (int p) const
+{
+	unsigned int h = (win[p] << 16) | (win[p+1] << 8) | win[p+2];
+	return (h*2654435761u) >> (32-HBITS);
+}
+
+// drop the oldest half of the window
+void Deflater::Slide ()
+{
+	memmove (win, win+WSIZE, WSIZE);
+	fill -= WSIZE;
+	pos  -= WSIZE;
+	for (int i = 0; i < (1 << HBITS); i++)
+		head[i] = (head[i] >= WSIZE ? head[i]-WSIZE : -1);
+	for (int i = 0; i < WSIZE; i++)
+		prev[i] = (prev[i] >= WSIZE ? prev[i]-WSIZE : -1);
+}
+
+// encode the window contents up to the lookahead limit, or all of it
+void Deflater::Compress (bool flush, std::vector<unsigned char> &out)
+{
+	int limit = (flush ? fill : fill-MAXMATCH);
+	while (pos < limit) {
+		int best = 0, dist = 0;
+		if (pos+3 <= fill) {
+			unsigned int h = Hash (pos);
+			int cand = head[h], chain = MAXCHAIN;
+			int maxlen = (fill-pos < MAXMATCH ? fill-pos : MAXMATCH);
+			while (cand >= 0 && pos-cand <= WSIZE && chain--) {
+				if (win[cand+best] == win[pos+best]) {
+					int len = 0;
+					while (len < maxlen && win[cand+len] == win[pos+len]) len++;
+					if (len > best) {
+						best = len, dist = pos-cand;
+						if (len == maxlen) break;
+					}
+				}
+				cand = prev[cand & (WSIZE-1)];
+			}
+			prev[pos & (WSIZE-1)] = head[h];
+			head[h] = pos;
+		}
+		if (best >= 3) {
+			PutMatch (best, dist, out);
+			// index the skipped positions so later matches can find them
+			for (int k = 1; k < best && pos+k+3 <= fill; k++) {
+				unsigned int h = Hash (pos+k);
+				prev[(pos+k) & (WSIZE-1)] = head[h];
+				head[h] = pos+k;
+			}
+			pos += best;
+		} else {
+			PutLiteral (win[pos], out);
+			pos++;
+		}
+	}
+}
+
+void Deflater::Write (const void *data, size_t n, std::vector<unsigned char> &out)
+{
+	const unsigned char *src = (const unsigned char*)data;
+	if (!started) {
+		out.push_back (0x78);        // deflate, 32K window
+		out.push_back (0x01);
+		PutBits (0x2, 3, out);       // not final, fixed Huffman block
+		started = true;
+	}
+	adler = Adler32 (adler, src, n);
+	nin += n;
+	while (n) {
+		if (fill == 2*WSIZE) {
+			Compress (false, out);
+			if (pos >= WSIZE) Slide();
+		}
+		size_t k = 2*WSIZE-fill;
+		if (k > n) k = n;
+		memcpy (win+fill, src, k);
+		fill += (int)k;
+		src += k;
+		n -= k;
+	}
+	Compress (false, out);
+}
+
+void Deflater::Finish (std::vector<unsigned char> &out)
+{
+	if (!started) Write (0, 0, out);
+	Compress (true, out);
+	PutLiteral (256, out);       // end of block
+	PutBits (0x3, 3, out);       // final, fixed Huffman block
+	PutLiteral (256, out);       // empty
+	if (nbits) PutBits (0, 8-nbits, out);
+	out.push_back ((unsigned char)(adler >> 24));
+	out.push_back ((unsigned char)(adler >> 16));
+	out.push_back ((unsigned char)(adler >> 8));
+	out.push_back ((unsigned char)adler);
+}
+
+void ZlibCompress (const void *data, size_t n, std::vector<unsigned char> &out)
+{
+	Deflater z;
+	z.Write (data, n, out);
+	z.Finish (out);
+}
@@ -0,0 +1,54 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// Deflate.h
+// Small streaming zlib (RFC 1950/1951) compressor.
+// ==============================================================
+
+#ifndef __DEFLATE_H
+#define __DEFLATE_H
+
+#include <cstddef>
+#include <vector>
+
+unsigned int Crc32 (unsigned int crc, const unsigned char *buf, size_t n);
+unsigned int Adler32 (unsigned int adler, const unsigned char *buf, size_t n);
+
+// Streaming zlib compressor using LZ77 with hash chains and the fixed
+// Huffman code. Compressed output is appended to the caller's vector by
+// Write and Finish; the caller may drain it between calls. Good enough
+// for the text logs and plot images here, and has no dependencies.
+class Deflater {
+public:
+	Deflater ();
+	~Deflater ();
+	void Write (const void *data, size_t n, std::vector<unsigned char> &out);
+	void Finish (std::vector<unsigned char> &out);
+	size_t In () const { return nin; }
+
+private:
+	enum { WSIZE = 32768, MAXMATCH = 258, HBITS = 15, MAXCHAIN = 32 };
+	void Compress (bool flush, std::vector<unsigned char> &out);
+	void Slide ();
+	void PutBits (unsigned int v, int n, std::vector<unsigned char> &out);
+	void PutLiteral (int c, std::vector<unsigned char> &out);
+	void PutMatch (int len, int dist, std::vector<unsigned char> &out);
+	unsigned int Hash (int p) const;
+
+	unsigned char *win;  // sliding window, 2*WSIZE bytes
+	int *head;           // most recent position per hash
+	int *prev;           // previous position with the same hash
+	int fill;            // bytes in the window
+	int pos;             // next position to encode
+	unsigned int bitbuf; // pending output bits
+	int nbits;
+	unsigned int adler;
+	size_t nin;          // bytes written
+	bool started;
+};
+
+// compress a whole buffer into a zlib stream
+void ZlibCompress (const void *data, size_t n, std::vector<unsigned char> &out);
+
+#endif // !__DEFLATE_H
@@ -0,0 +1,104 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// ImageIO.cpp
+// PNG and PPM export of RGBA images, PPM import.
+// ==============================================================
+
+#include <cstdio>
+#include <vector>
+#include "Deflate.h"
+#include "ImageIO.h"
+
+bool WritePPM (const char *path, const unsigned char *rgba, int w, int h)
+{
+	FILE *f = fopen (path, "wb");
+	if (!f) return false;
+	fprintf (f, "P6\n%d %d\n255\n", w, h);
+	std::vector<unsigned char> row(3*w);
+	for (int y = 0; y < h; y++) {
+		const unsigned char *p = rgba + 4*(size_t)w*y;
+		for (int x = 0; x < w; x++) {
+			row[3*x]   = p[4*x];
+			row[3*x+1] = p[4*x+1];
+			row[3*x+2] = p[4*x+2];
+		}
+		fwrite (row.data(), 1, row.size(), f);
+	}
+	return fclose (f) == 0;
+}
+
+bool ReadPPM (const char *path, std::vector<unsigned char> &rgba, int &w, int &h)
+{
+	FILE *f = fopen (path, "rb");
+	if (!f) return false;
+	int maxval;
+	bool ok = (fscanf (f, "P6 %d %d %d", &w, &h, &maxval) == 3 && maxval == 255
+		&& w > 0 && h > 0 && fgetc (f) != EOF);  // one blank after the header
+	if (ok) {
+		std::vector<unsigned char> row(3*w);
+		rgba.resize (4*(size_t)w*h);
+		for (int y = 0; y < h && ok; y++) {
+			ok = (fread (row.data(), 1, row.size(), f) == row.size());
+			unsigned char *p = rgba.data() + 4*(size_t)w*y;
+			for (int x = 0; x < w; x++) {
+				p[4*x]   = row[3*x];
+				p[4*x+1] = row[3*x+1];
+				p[4*x+2] = row[3*x+2];
+				p[4*x+3] = 0xff;
+			}
+		}
+	}
+	fclose (f);
+	return ok;
+}
+
+static void Put32 (std::vector<unsigned char> &v, unsigned int x)
+{
+	v.push_back ((unsigned char)(x >> 24));
+	v.push_back ((unsigned char)(x >> 16));
+	v.push_back ((unsigned char)(x >> 8));
+	v.push_back ((unsigned char)x);
+}
+
+static void PutChunk (FILE *f, const char *type, const std::vector<unsigned char> &data)
+{
+	std::vector<unsigned char> c;
+	Put32 (c, (unsigned int)data.size());
+	c.insert (c.end(), type, type+4);
+	c.insert (c.end(), data.begin(), data.end());
+	Put32 (c, Crc32 (0, c.data()+4, c.size()-4));
+	fwrite (c.data(), 1, c.size(), f);
+}
+
+bool WritePNG (const char *path, const unsigned char *rgba, int w, int h)
+{
+	static const unsigned char sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	FILE *f = fopen (path, "wb");
+	if (!f) return false;
+	fwrite (sig, 1, 8, f);
+
+	std::vector<unsigned char> hdr;
+	Put32 (hdr, w);
+	Put32 (hdr, h);
+	hdr.push_back (8);  // bit depth
+	hdr.push_back (6);  // RGBA
+	hdr.push_back (0);  // deflate
+	hdr.push_back (0);  // adaptive filtering
+	hdr.push_back (0);  // no interlace
+	PutChunk (f, "IHDR", hdr);
+
+	// rows with filter type 0, compressed row by row
+	Deflater z;
+	std::vector<unsigned char> idat;
+	unsigned char ftype = 0;
+	for (int y = 0; y < h; y++) {
+		z.Write (&ftype, 1, idat);
+		z.Write (rgba + 4*(size_t)w*y, 4*(size_t)w, idat);
+	}
+	z.Finish (idat);
+	PutChunk (f, "IDAT", idat);
+	PutChunk (f, "IEND", std::vector<unsigned char>());
+	return fclose (f) == 0;
+}
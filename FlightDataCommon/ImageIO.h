@@ -0,0 +1,21 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// ImageIO.h
+// PNG and PPM export of RGBA images, PPM import.
+// ==============================================================
+
+#ifndef __IMAGEIO_H
+#define __IMAGEIO_H
+
+#include <vector>
+
+// rgba: w*h pixels, 4 bytes each, rows top to bottom
+bool WritePPM (const char *path, const unsigned char *rgba, int w, int h);
+bool WritePNG (const char *path, const unsigned char *rgba, int w, int h);
+
+// read a binary (P6, 8 bit) PPM into rgba, alpha 0xff
+bool ReadPPM (const char *path, std::vector<unsigned char> &rgba, int &w, int &h);
+
+#endif // !__IMAGEIO_H
@@ -0,0 +1,415 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// Journal.cpp
+// Crash-safe block writing of text flight logs and tail recovery.
+// ==============================================================
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include "Deflate.h"
+#include "Journal.h"
+#include "MappedFile.h"
+
+static double NowMs ()
+{
+	return std::chrono::duration<double, std::milli> (
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static unsigned int FrameCheck (const JournalFrame &f)
+{
+	return Crc32 (0, (const unsigned char*)&f, offsetof (JournalFrame, check));
+}
+
+std::string JournalPath (const char *logpath)
+{
+	return std::filesystem::path (logpath).replace_extension (JOURNAL_EXT).string();
+}
+
+// ==============================================================
+// platform file access
+
+#ifdef _WIN32
+
+static void *OpenAppend (const char *path, long long &size)
+{
+	HANDLE h = CreateFileA (path, FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+		OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	LARGE_INTEGER sz;
+	if (h == INVALID_HANDLE_VALUE) return 0;
+	size = (GetFileSizeEx (h, &sz) ? sz.QuadPart : 0);
+	return h;
+}
+
+static bool WriteAll (void *h, const char *p, size_t n)
+{
+	while (n) {
+		DWORD w = 0, chunk = (DWORD)(n > (1u << 30) ? (1u << 30) : n);
+		if (!WriteFile ((HANDLE)h, p, chunk, &w, 0) || !w) return false;
+		p += w, n -= w;
+	}
+	return true;
+}
+
+static void SyncFile (void *h) { FlushFileBuffers ((HANDLE)h); }
+static void CloseFile (void *h) { CloseHandle ((HANDLE)h); }
+
+#else
+
+static int OpenAppend (const char *path, long long &size)
+{
+	int fd = open (path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+	struct stat st;
+	if (fd < 0) return -1;
+	size = (fstat (fd, &st) ? 0 : (long long)st.st_size);
+	return fd;
+}
+
+static bool WriteAll (int fd, const char *p, size_t n)
+{
+	while (n) {
+		ssize_t w = write (fd, p, n);
+		if (w <= 0) return false;
+		p += w, n -= (size_t)w;
+	}
+	return true;
+}
+
+static void SyncFile (int fd)
+{
+#if defined(__APPLE__)
+	fsync (fd);
+#else
+	fdatasync (fd);
+#endif
+}
+
+static void CloseFile (int fd) { close (fd); }
+
+#endif
+
+// ==============================================================
+// JournalWriter
+
+JournalWriter::JournalWriter ()
+{
+	active = failed = false;
+	pending = 0;
+	unsynced = 0;
+	tfirst = tsync = 0.0;
+	rows = 32, flush_ms = 200, sync_blocks = 0, sync_ms = 0;
+	logpos = 0;
+	nblock = nsync = nrow = 0;
+#ifdef _WIN32
+	hlog = hjnl = 0;
+#else
+	flog = fjnl = -1;
+#endif
+}
+
+JournalWriter::~JournalWriter ()
+{
+	Close();
+}
+
+bool JournalWriter::Open (const char *logpath, int _rows, int _flush_ms, int _sync_blocks, int _sync_ms)
+{
+	long long jsize;
+	Close();
+	rows = (_rows < 1 ? 1 : _rows);
+	flush_ms = _flush_ms;
+	sync_blocks = _sync_blocks;
+	sync_ms = _sync_ms;
+	path = logpath;
+	std::string jpath = JournalPath (logpath);
+#ifdef _WIN32
+	if (!(hlog = OpenAppend (logpath, logpos))) return false;
+	if (!(hjnl = OpenAppend (jpath.c_str(), jsize))) { CloseFile (hlog); hlog = 0; return false; }
+#else
+	if ((flog = OpenAppend (logpath, logpos)) < 0) return false;
+	if ((fjnl = OpenAppend (jpath.c_str(), jsize)) < 0) { CloseFile (flog); flog = -1; return false; }
+#endif
+	buf.reserve ((size_t)rows*256);
+	buf.clear();
+	pending = 0;
+	unsynced = 0;
+	nblock = nsync = nrow = 0;
+	failed = false;
+	active = true;
+	tsync = NowMs();
+	WriteFrame (JF_OPEN, logpos, 0, 0, 0);
+	return true;
+}
+
+void JournalWriter::Close ()
+{
+	if (!active) return;
+	Flush (false);
+	if (!failed) WriteFrame (JF_CLOSE, logpos, 0, 0, 0);
+	Sync();
+	active = false;
+#ifdef _WIN32
+	CloseFile (hlog), CloseFile (hjnl);
+	hlog = hjnl = 0;
+#else
+	CloseFile (flog), CloseFile (fjnl);
+	flog = fjnl = -1;
+#endif
+}
+
+void JournalWriter::Append (const char *line, int len)
+{
+	if (!active || failed) return;
+	if (!pending) tfirst = NowMs();
+	buf.insert (buf.end(), line, line+len);
+	pending++;
+	nrow++;
+	if (pending >= rows) Flush (false);
+}
+
+void JournalWriter::Poll ()
+{
+	if (!active) return;
+	if (!pending && !unsynced) return;
+	double t = NowMs();
+	if (pending && flush_ms > 0 && t-tfirst >= flush_ms) Flush (false);
+	else if (unsynced && sync_ms > 0 && t-tsync >= sync_ms) Sync();
+}
+
+void JournalWriter::Flush (bool sync)
+{
+	if (!active || failed) return;
+	if (pending) {
+		// the block goes first, so a frame never precedes its data. After
+		// a failed write the log position is unknown: stop writing
+#ifdef _WIN32
+		if (!WriteAll (hlog, buf.data(), buf.size())) failed = true;
+#else
+		if (!WriteAll (flog, buf.data(), buf.size())) failed = true;
+#endif
+		else WriteFrame (JF_BLOCK, logpos, buf.data(), (unsigned int)buf.size(), pending);
+		logpos += (long long)buf.size();
+		buf.clear();
+		pending = 0;
+		nblock++;
+		unsynced++;
+	}
+	if (unsynced && (sync || (sync_blocks > 0 && unsynced >= sync_blocks) ||
+		(sync_ms > 0 && NowMs()-tsync >= sync_ms))) Sync();
+}
+
+bool JournalWriter::WriteFrame (int type, long long ofs, const char *data, unsigned int len, unsigned int nrows)
+{
+	JournalFrame f;
+	memset (&f, 0, sizeof(f));
+	f.magic = JOURNAL_MAGIC;
+	f.type = type;
+	f.offset = ofs;
+	f.length = len;
+	f.rows = nrows;
+	f.crc = (len ? Crc32 (0, (const unsigned char*)data, len) : 0);
+	f.check = FrameCheck (f);
+#ifdef _WIN32
+	if (!WriteAll (hjnl, (const char*)&f, sizeof(f))) return failed = true, false;
+#else
+	if (!WriteAll (fjnl, (const char*)&f, sizeof(f))) return failed = true, false;
+#endif
+	return true;
+}
+
+void JournalWriter::Sync ()
+{
+#ifdef _WIN32
+	SyncFile (hlog), SyncFile (hjnl);
+#else
+	SyncFile (flog), SyncFile (fjnl);
+#endif
+	nsync++;
+	unsynced = 0;
+	tsync = NowMs();
+}
+
+// ==============================================================
+// recovery
+
+// a complete sample line: 'ncol' numeric fields
+static bool SampleLine (const char *s, const char *e, int ncol, char delim)
+{
+	auto isdelim = [delim](char c) {
+		if (c == '\r') return true;
+		return delim ? c == delim : (c == ' ' || c == '\t' || c == ',' || c == ';' || c == '|');
+	};
+	char field[64];
+	int n = 0;
+	while (s < e) {
+		while (s < e && isdelim (*s)) s++;
+		if (s == e) break;
+		const char *t = s;
+		while (t < e && !isdelim (*t)) t++;
+		if (t-s >= (int)sizeof(field) || ++n > ncol) return false;
+		memcpy (field, s, t-s);
+		field[t-s] = '\0';
+		char *end;
+		strtod (field, &end);
+		if (end == field || *end) return false;
+		s = t;
+	}
+	return n == ncol;
+}
+
+bool JournalClosed (const char *logpath)
+{
+	std::string jpath = JournalPath (logpath);
+	std::error_code ec;
+	std::uintmax_t jsize = std::filesystem::file_size (jpath, ec);
+	if (ec || jsize < sizeof(JournalFrame) || jsize % sizeof(JournalFrame)) return false;
+	std::uintmax_t size = std::filesystem::file_size (logpath, ec);
+	if (ec) return false;
+	FILE *f = fopen (jpath.c_str(), "rb");
+	if (!f) return false;
+	JournalFrame jf;
+	bool ok = (fseek (f, -(long)sizeof(jf), SEEK_END) == 0 && fread (&jf, sizeof(jf), 1, f) == 1);
+	fclose (f);
+	return ok && jf.magic == JOURNAL_MAGIC && jf.check == FrameCheck (jf) &&
+		jf.type == JF_CLOSE && jf.offset == (long long)size;
+}
+
+bool TruncateJournal (const char *logpath, long long pos)
+{
+	std::string jpath = JournalPath (logpath);
+	std::error_code ec;
+	if (!std::filesystem::exists (jpath, ec)) return true;
+	FILE *f = fopen (jpath.c_str(), "rb");
+	if (!f) return false;
+	JournalFrame jf;
+	long long keep = 0;
+	bool closed = false;   // the last frame kept closes the log at pos
+	while (fread (&jf, sizeof(jf), 1, f) == 1) {
+		if (jf.magic != JOURNAL_MAGIC || jf.check != FrameCheck (jf)) break;
+		if ((jf.type == JF_BLOCK ? jf.offset+jf.length : jf.offset) > pos) break;
+		closed = (jf.type == JF_CLOSE && jf.offset == pos);
+		keep++;
+	}
+	fclose (f);
+	std::filesystem::resize_file (jpath, (std::uintmax_t)keep*sizeof(JournalFrame), ec);
+	if (ec) return false;
+	if (closed) return true;
+	if (!(f = fopen (jpath.c_str(), "ab"))) return false;
+	memset (&jf, 0, sizeof(jf));
+	jf.magic = JOURNAL_MAGIC;
+	jf.type = JF_CLOSE;
+	jf.offset = pos;
+	jf.check = FrameCheck (jf);
+	bool wr = fwrite (&jf, sizeof(jf), 1, f) == 1;
+	if (fclose (f)) wr = false;
+	return wr;
+}
+
+bool RecoverJournal (const char *logpath, int ncol, char delim, bool repair, JournalReport &r)
+{
+	memset (&r, 0, sizeof(r));
+	std::string jpath = JournalPath (logpath);
+	std::error_code ec;
+	if (!std::filesystem::exists (jpath, ec)) return false;
+	r.journal = true;
+
+	std::vector<JournalFrame> fr;
+	FILE *f = fopen (jpath.c_str(), "rb");
+	if (!f) return false;
+	JournalFrame jf;
+	size_t got;
+	while ((got = fread (&jf, 1, sizeof(jf), f)) == sizeof(jf)) {
+		if (jf.magic != JOURNAL_MAGIC || jf.check != FrameCheck (jf)) break;
+		fr.push_back (jf);
+	}
+	// the rest of the journal after the first bad frame is a torn tail
+	long long jsize = std::filesystem::file_size (jpath, ec);
+	r.bad_frames = (jsize - (long long)(fr.size()*sizeof(JournalFrame)) + sizeof(JournalFrame)-1)/sizeof(JournalFrame);
+	fclose (f);
+
+	MappedFile mf;
+	if (!mf.Open (logpath)) return false;
+	const char *log = mf.Data();
+	long long size = mf.Size();
+
+	// verify the blocks; the frames after the last verified one belong
+	// to the torn tail
+	std::vector<char> ok (fr.size(), 0);
+	long long k, last = -1;
+	for (k = 0; k < (long long)fr.size(); k++) {
+		const JournalFrame &b = fr[k];
+		if (b.type != JF_BLOCK) ok[k] = (b.offset <= size);
+		else ok[k] = (b.offset+b.length <= size &&
+			Crc32 (0, (const unsigned char*)log+b.offset, b.length) == b.crc);
+		if (ok[k]) last = k;
+	}
+	long long cover = 0;   // end of the framed part of the log
+	for (k = 0; k <= last; k++) {
+		const JournalFrame &b = fr[k];
+		if (b.type == JF_BLOCK) {
+			if (ok[k]) r.verified += b.rows;
+			else r.bad_blocks++;
+			cover = b.offset+b.length;
+		} else if (b.offset > cover) cover = b.offset;
+	}
+	r.bad_frames += (long long)fr.size()-1 - last;
+	r.clean = (last >= 0 && last == (long long)fr.size()-1 && fr[last].type == JF_CLOSE &&
+		fr[last].offset == size && !r.bad_frames && !r.bad_blocks);
+
+	// keep the complete sample lines after the framed part
+	long long end = cover;
+	const char *s = log+cover, *e = log+size;
+	while (s < e) {
+		const char *nl = (const char*)memchr (s, '\n', e-s);
+		if (!nl || !SampleLine (s, nl, ncol, delim)) break;
+		r.salvaged++;
+		s = nl+1;
+		end = s-log;
+	}
+	r.dropped = size-end;
+	r.logsize = end;
+	unsigned int tailcrc = (end > cover ? Crc32 (0, (const unsigned char*)log+cover, (size_t)(end-cover)) : 0);
+	mf.Close();
+	if (!repair || r.clean) return true;
+
+	// cut the log and the journal, frame the salvaged lines and close
+	if (end < size) {
+		std::filesystem::resize_file (logpath, (std::uintmax_t)end, ec);
+		if (ec) return false;
+	}
+	std::filesystem::resize_file (jpath, (std::uintmax_t)(last+1)*sizeof(JournalFrame), ec);
+	if (ec || !(f = fopen (jpath.c_str(), "ab"))) return false;
+	bool wr = true;
+	if (end > cover) {
+		memset (&jf, 0, sizeof(jf));
+		jf.magic = JOURNAL_MAGIC;
+		jf.type = JF_BLOCK;
+		jf.offset = cover;
+		jf.length = (unsigned int)(end-cover);
+		jf.rows = (unsigned int)r.salvaged;
+		jf.crc = tailcrc;
+		jf.check = FrameCheck (jf);
+		wr = fwrite (&jf, sizeof(jf), 1, f) == 1;
+	}
+	memset (&jf, 0, sizeof(jf));
+	jf.magic = JOURNAL_MAGIC;
+	jf.type = JF_CLOSE;
+	jf.offset = end;
+	jf.check = FrameCheck (jf);
+	if (wr) wr = fwrite (&jf, sizeof(jf), 1, f) == 1;
+	if (fclose (f)) wr = false;
+	return wr;
+}
@@ -0,0 +1,116 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// Journal.h
+// Crash-safe block writing of text flight logs and tail recovery.
+// ==============================================================
+
+#ifndef __JOURNAL_H
+#define __JOURNAL_H
+
+#include <string>
+#include <vector>
+
+#define JOURNAL_EXT ".fdj"
+
+// frame types
+enum {
+	JF_OPEN = 1,   // writer opened the log; offset = log size at that time
+	JF_BLOCK = 2,  // block of sample lines at offset
+	JF_CLOSE = 3   // writer closed the log cleanly; offset = log size
+};
+
+// Journal file: a sequence of fixed-size frames, one per block written to
+// the log. Each frame carries the position, length, sample count and
+// CRC-32 of its block, and a CRC-32 of its own fields, so a torn frame
+// or block is recognised as such.
+struct JournalFrame {
+	unsigned int magic;       // JOURNAL_MAGIC
+	unsigned int type;        // JF_*
+	long long offset;         // byte offset of the block in the log
+	unsigned int length;      // bytes in the block
+	unsigned int rows;        // sample lines in the block
+	unsigned int crc;         // CRC-32 of the block
+	unsigned int check;       // CRC-32 of the fields above
+};
+
+const unsigned int JOURNAL_MAGIC = 0x464a4446;  // "FDJF"
+
+// Appends sample lines to a text log in blocks. A block is written when it
+// holds 'rows' lines, or when its first line is older than 'flush_ms', and
+// is followed by its frame in the journal next to the log. The log and
+// the journal are forced to disk every 'sync_blocks' blocks and at least
+// every 'sync_ms' ms while blocks are written (0 = never); with neither,
+// the data is left to the operating system once written, which survives
+// a crash of the process but not of the machine.
+class JournalWriter {
+public:
+	JournalWriter ();
+	~JournalWriter ();
+	bool Open (const char *logpath, int rows, int flush_ms, int sync_blocks, int sync_ms);
+	void Close ();
+	bool Active () const { return active; }
+	const std::string &Path () const { return path; }
+	void Append (const char *line, int len);  // one line, newline included
+	void Poll ();                             // write a block that is due
+	void Flush (bool sync);                   // write the pending block
+
+	long long Blocks () const { return nblock; }
+	long long Syncs () const { return nsync; }
+	long long Rows () const { return nrow; }
+	bool Failed () const { return failed; }   // a write failed; nothing more is written
+
+private:
+	bool WriteFrame (int type, long long ofs, const char *data, unsigned int len, unsigned int rows);
+	void Sync ();
+	std::string path;
+	std::vector<char> buf;    // pending block
+	int pending;              // lines in buf
+	double tfirst;            // wall time of the first pending line (ms)
+	double tsync;             // wall time of the last sync (ms)
+	int rows, flush_ms, sync_blocks, sync_ms;
+	int unsynced;             // blocks written since the last sync
+	long long logpos;         // log size
+	long long nblock, nsync, nrow;
+	bool active, failed;
+#ifdef _WIN32
+	void *hlog, *hjnl;
+#else
+	int flog, fjnl;
+#endif
+};
+
+// outcome of checking or recovering a log against its journal
+struct JournalReport {
+	bool journal;             // a journal was found
+	bool clean;               // the writer closed the log
+	long long verified;       // samples in blocks that match their frames
+	long long salvaged;       // complete samples after the last frame
+	long long bad_blocks;     // framed blocks whose checksum fails
+	long long bad_frames;     // torn or unreadable frames at the end of the journal
+	long long dropped;        // bytes cut from the tail of the log
+	long long logsize;        // log size after recovery
+};
+
+// Checks the log against its journal. A torn tail is cut at the end of
+// the last complete sample line with 'ncol' fields; the complete lines
+// after the last frame are kept and framed. The journal is cut after its
+// last valid frame and closed, so the writer may append again. With
+// repair false the log and the journal are only checked.
+bool RecoverJournal (const char *logpath, int ncol, char delim, bool repair, JournalReport &r);
+
+// Cuts the log's journal back to its frames of the first 'pos' bytes of
+// the log and closes the log at 'pos', for a log cut back to that size.
+// The frames of a block that ends after 'pos' go, and all after it. True
+// if there is no journal.
+bool TruncateJournal (const char *logpath, long long pos);
+
+// true if the last frame of the log's journal closes the log at its
+// current size; reads one frame, so all journals can be checked at start
+bool JournalClosed (const char *logpath);
+
+// journal next to a log
+std::string JournalPath (const char *logpath);
+
+#endif // !__JOURNAL_H
@@ -0,0 +1,197 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// LogRotation.cpp
+// Background compression of closed log segments and their manifest.
+// ==============================================================
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+#include "Deflate.h"
+#include "Journal.h"
+#include "LogRotation.h"
+
+// lowest CPU (and on Windows I/O) priority for the calling thread
+static void LowerPriority ()
+{
+#ifdef _WIN32
+	if (!SetThreadPriority (GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN))
+		SetThreadPriority (GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+	setpriority (PRIO_PROCESS, (id_t)syscall (SYS_gettid), 19);
+#endif
+}
+
+static long long FileBytes (const std::string &path)
+{
+	std::error_code ec;
+	std::uintmax_t n = std::filesystem::file_size (path, ec);
+	return ec ? -1 : (long long)n;
+}
+
+static void Put32 (std::vector<unsigned char> &v, unsigned int x)
+{
+	for (int i = 0; i < 4; i++) v.push_back ((unsigned char)(x >> (8*i)));
+}
+
+// The deflater writes a zlib stream: a 2-byte header, the deflate data
+// and an Adler-32 trailer. The gzip file takes the deflate data between
+// its own header and a CRC-32/length trailer.
+bool GzipFile (const char *src, const char *dst, const std::atomic<bool> *stop, long long *in, long long *out)
+{
+	const size_t BLOCK = 1 << 18;
+	FILE *f = fopen (src, "rb");
+	if (!f) return false;
+	FILE *g = fopen (dst, "wb");
+	if (!g) { fclose (f); return false; }
+
+	static const unsigned char hdr[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255};
+	std::vector<unsigned char> buf (BLOCK), z;
+	Deflater d;
+	unsigned int crc = 0;
+	long long nin = 0, nout = sizeof(hdr);
+	size_t skip = 2, n;
+	bool ok = fwrite (hdr, sizeof(hdr), 1, g) == 1;
+	z.reserve (BLOCK + BLOCK/8);
+	while (ok && (n = fread (buf.data(), 1, BLOCK, f)) > 0) {
+		if (stop && stop->load (std::memory_order_relaxed)) { ok = false; break; }
+		crc = Crc32 (crc, buf.data(), n);
+		nin += n;
+		d.Write (buf.data(), n, z);
+		if (z.size() > skip) {
+			ok = fwrite (z.data()+skip, 1, z.size()-skip, g) == z.size()-skip;
+			nout += z.size()-skip;
+			z.clear();
+			skip = 0;
+		}
+	}
+	if (ferror (f)) ok = false;
+	if (ok) {
+		d.Finish (z);
+		z.resize (z.size()-4);                    // Adler-32 of the zlib stream
+		Put32 (z, crc);
+		Put32 (z, (unsigned int)nin);
+		ok = fwrite (z.data()+skip, 1, z.size()-skip, g) == z.size()-skip;
+		nout += z.size()-skip;
+	}
+	fclose (f);
+	if (fclose (g)) ok = false;
+	if (!ok) { remove (dst); return false; }
+	if (in) *in = nin;
+	if (out) *out = nout;
+	return true;
+}
+
+SegmentCompressor::SegmentCompressor ()
+{
+	busy = false;
+	compress = true;
+	run = abort = false;
+	ndone = nin = nout = 0;
+}
+
+SegmentCompressor::~SegmentCompressor ()
+{
+	Stop();
+}
+
+void SegmentCompressor::Start (bool _compress)
+{
+	Stop();
+	compress = _compress;
+	abort = false;
+	run = true;
+	th = std::thread (&SegmentCompressor::Worker, this);
+}
+
+void SegmentCompressor::Stop ()
+{
+	if (!run) return;
+	{
+		std::lock_guard<std::mutex> lk (mtx);
+		run = false;
+		abort = true;
+	}
+	cv.notify_all();
+	th.join();
+	// what is left stays as it is, but still goes into the manifest
+	while (!queue.empty()) {
+		const SegmentInfo &s = queue.front();
+		List (s, std::filesystem::path (s.path).filename().string(), FileBytes (s.path));
+		queue.pop_front();
+	}
+}
+
+// the worker is not woken: it polls the queue, so queueing a segment
+// never hands the CPU to the worker in the writer's time slice
+void SegmentCompressor::Close (const SegmentInfo &s)
+{
+	std::lock_guard<std::mutex> lk (mtx);
+	queue.push_back (s);
+}
+
+int SegmentCompressor::Pending ()
+{
+	std::lock_guard<std::mutex> lk (mtx);
+	return (int)queue.size() + (busy ? 1 : 0);
+}
+
+void SegmentCompressor::Worker ()
+{
+	LowerPriority();
+	for (;;) {
+		SegmentInfo s;
+		{
+			std::unique_lock<std::mutex> lk (mtx);
+			while (run && queue.empty()) cv.wait_for (lk, std::chrono::milliseconds (POLL_MS));
+			if (!run) return;
+			s = queue.front();
+			busy = true;
+		}
+		std::string gz = s.path + ".gz";
+		long long in = 0, out = 0;
+		std::error_code ec;
+		bool ok = compress && GzipFile (s.path.c_str(), gz.c_str(), &abort, &in, &out);
+		{
+			// an aborted segment is left in the queue for Stop() to list
+			std::lock_guard<std::mutex> lk (mtx);
+			busy = false;
+			if (!ok && abort) return;
+			queue.pop_front();
+		}
+		if (ok) {
+			std::filesystem::remove (s.path, ec);
+			std::filesystem::remove (JournalPath (s.path.c_str()), ec);
+			List (s, std::filesystem::path (gz).filename().string(), out);
+			nin += in, nout += out;
+		} else
+			List (s, std::filesystem::path (s.path).filename().string(), FileBytes (s.path));
+		ndone++;
+	}
+}
+
+void SegmentCompressor::List (const SegmentInfo &s, const std::string &stored, long long stored_bytes)
+{
+	std::filesystem::path mp = std::filesystem::path (s.path).parent_path() / SEGMENT_MANIFEST;
+	std::error_code ec;
+	bool fresh = !std::filesystem::exists (mp, ec);
+	FILE *f = fopen (mp.string().c_str(), "a");
+	if (!f) return;
+	if (fresh) fprintf (f, "# flight\tpart\tfile\tsamples\tt_start\tt_end\tbytes\tstored\tstored_bytes\n");
+	fprintf (f, "%s\t%d\t%s\t%lld\t%.3f\t%.3f\t%lld\t%s\t%lld\n", s.flight.c_str(), s.part,
+		std::filesystem::path (s.path).filename().string().c_str(), s.samples, s.t_start, s.t_end,
+		s.bytes, stored.c_str(), stored_bytes);
+	fclose (f);
+}
@@ -0,0 +1,71 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// LogRotation.h
+// Background compression of closed log segments and their manifest.
+// ==============================================================
+
+#ifndef __LOGROTATION_H
+#define __LOGROTATION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define SEGMENT_MANIFEST "segments.fdm"
+
+// A closed segment of a flight log. A flight is a run of segments cut by
+// size or sim time; it is named after its first segment.
+struct SegmentInfo {
+	std::string flight;     // file name of the first segment
+	int part;               // 0 for the first segment
+	std::string path;       // segment file
+	long long samples;
+	long long bytes;
+	double t_start, t_end;  // sim time of the first/last sample
+};
+
+// Compresses closed segments into gzip files (the built-in deflater) on a
+// background thread at low priority, oldest first, removes the segment
+// and its journal once the compressed copy is complete, and appends each
+// segment to the manifest in its directory. Close() only queues the
+// segment, so the writer of the active segment never waits for it.
+// Segments still queued at Stop() stay uncompressed and are listed as
+// such.
+class SegmentCompressor {
+public:
+	SegmentCompressor ();
+	~SegmentCompressor ();
+	void Start (bool compress);
+	void Stop ();
+	void Close (const SegmentInfo &s);
+	int Pending ();
+	long long Done () const { return ndone.load(); }
+	long long BytesIn () const { return nin.load(); }
+	long long BytesOut () const { return nout.load(); }
+
+private:
+	enum { POLL_MS = 250 };   // queue poll interval of the worker
+	void Worker ();
+	void List (const SegmentInfo &s, const std::string &stored, long long stored_bytes);
+
+	std::thread th;
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::deque<SegmentInfo> queue;
+	bool busy;                  // worker holds a segment
+	bool compress;
+	std::atomic<bool> run, abort;
+	std::atomic<long long> ndone, nin, nout;
+};
+
+// gzip one file with the built-in deflater; 'stop' is polled between
+// blocks and aborts the copy
+bool GzipFile (const char *src, const char *dst, const std::atomic<bool> *stop,
+	long long *in = 0, long long *out = 0);
+
+#endif // !__LOGROTATION_H
@@ -0,0 +1,89 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// MappedFile.cpp
+// Read-only memory mapping of a whole file.
+// ==============================================================
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "MappedFile.h"
+
+MappedFile::MappedFile ()
+{
+	data = 0;
+	size = 0;
+#ifdef _WIN32
+	hfile = hmap = 0;
+#endif
+}
+
+MappedFile::~MappedFile ()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open (const char *path)
+{
+	LARGE_INTEGER sz;
+	Close();
+	hfile = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (hfile == INVALID_HANDLE_VALUE) { hfile = 0; return false; }
+	if (!GetFileSizeEx ((HANDLE)hfile, &sz)) { Close(); return false; }
+	size = sz.QuadPart;
+	if (!size) return true;
+	hmap = CreateFileMappingA ((HANDLE)hfile, 0, PAGE_READONLY, 0, 0, 0);
+	if (!hmap || !(data = (const char*)MapViewOfFile ((HANDLE)hmap, FILE_MAP_READ, 0, 0, 0))) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close ()
+{
+	if (data) UnmapViewOfFile (data);
+	if (hmap) CloseHandle ((HANDLE)hmap);
+	if (hfile) CloseHandle ((HANDLE)hfile);
+	data = 0, hmap = hfile = 0;
+	size = 0;
+}
+
+#else
+
+bool MappedFile::Open (const char *path)
+{
+	struct stat st;
+	Close();
+	int fd = open (path, O_RDONLY);
+	if (fd < 0) return false;
+	if (fstat (fd, &st)) { close (fd); return false; }
+	size = st.st_size;
+	if (size) {
+		void *p = mmap (0, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) { close (fd); size = 0; return false; }
+		data = (const char*)p;
+		madvise (p, (size_t)size, MADV_SEQUENTIAL);
+	}
+	close (fd);
+	return true;
+}
+
+void MappedFile::Close ()
+{
+	if (data) munmap ((void*)data, (size_t)size);
+	data = 0;
+	size = 0;
+}
+
+#endif
@@ -0,0 +1,29 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// MappedFile.h
+// Read-only memory mapping of a whole file.
+// ==============================================================
+
+#ifndef __MAPPEDFILE_H
+#define __MAPPEDFILE_H
+
+class MappedFile {
+public:
+	MappedFile ();
+	~MappedFile ();
+	bool Open (const char *path);
+	void Close ();
+	const char *Data () const { return data; }
+	long long Size () const { return size; }
+
+private:
+	const char *data;
+	long long size;
+#ifdef _WIN32
+	void *hfile, *hmap;
+#endif
+};
+
+#endif // !__MAPPEDFILE_H
@@ -0,0 +1,80 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// OrbitElements.cpp
+// Orbital elements of state vectors relative to a reference body.
+// ==============================================================
+
+#include <cmath>
+#include "OrbitElements.h"
+
+static const double PI2 = 6.283185307179586;
+static const double DEG = 57.29577951308232;  // deg per rad
+
+// Two passes over blocks of NBLOCK vectors. The arithmetic, with square
+// roots only, goes into arrays on the stack, which cannot overlap the
+// caller's, and vectorises; the angles need atan2 and acos, which have no
+// vector form in most math libraries, and take a short scalar pass that
+// also copies the block out. Every result is computed and the unbound
+// ones are masked, so neither pass branches.
+static const int NBLOCK = 64;
+
+void OrbitElements (const OrbitBody &b, const StateVectors &sv, int n, double *const out[NORBIT])
+{
+	const double gm = b.gm, R = b.radius, px = b.pole[0], py = b.pole[1], pz = b.pole[2];
+	double blk[NORBIT][NBLOCK], ec[NBLOCK], es[NBLOCK], ci[NBLOCK];
+	int i;
+
+	for (int i0 = 0; i0 < n; i0 += NBLOCK) {
+		int m = (n-i0 < NBLOCK ? n-i0 : NBLOCK);
+		const double *rx = sv.rx+i0, *ry = sv.ry+i0, *rz = sv.rz+i0;
+		const double *vx = sv.vx+i0, *vy = sv.vy+i0, *vz = sv.vz+i0;
+
+		for (i = 0; i < m; i++) {
+			double x = rx[i], y = ry[i], z = rz[i];
+			double u = vx[i], v = vy[i], w = vz[i];
+			double r = sqrt (x*x + y*y + z*z);
+			double v2 = u*u + v*v + w*w;
+			double rv = x*u + y*v + z*w;
+
+			// angular momentum; v x r points north for a prograde orbit in
+			// the left-handed frame
+			double hx = v*z - w*y, hy = w*x - u*z, hz = u*y - v*x;
+			double h2 = hx*hx + hy*hy + hz*hz;
+			double h = sqrt (h2);
+
+			double eps = 0.5*v2 - gm/r;
+			double e2 = 1.0 + 2.0*eps*h2/(gm*gm);
+			double e = sqrt (fabs (e2));              // e2 < 0 by rounding only
+			double bound = (eps < 0.0 ? 1.0 : 0.0);
+
+			// semi-major axis, mean motion and the eccentric anomaly as
+			// e*cos(E), e*sin(E); an unbound orbit takes a stand-in energy
+			// that keeps them finite, and its results are masked to 0
+			double a = -0.5*gm/(eps < -1e-30 ? eps : -1e-30);
+			double na = sqrt (gm/(a*a*a));
+			ec[i] = 1.0 - r/a;
+			es[i] = bound*rv/sqrt (gm*a);
+
+			double c = (hx*px + hy*py + hz*pz)/(h + 1e-300);
+			ci[i] = (c > 1.0 ? 1.0 : c < -1.0 ? -1.0 : c);
+
+			blk[OE_APO][i]    = bound*(a*(1.0+e) - R)*1e-3;
+			blk[OE_PERI][i]   = (h2/(gm*(1.0+e)) - R)*1e-3;
+			blk[OE_ECC][i]    = e;
+			blk[OE_PERIOD][i] = bound*PI2/na;
+			blk[OE_ENERGY][i] = eps*1e-6;
+		}
+		for (i = 0; i < m; i++) {
+			// Kepler's equation M = E - e*sin(E); 0 when unbound
+			out[OE_MANOM][i0+i]  = (atan2 (es[i], ec[i]) - es[i])*DEG;
+			out[OE_INC][i0+i]    = acos (ci[i])*DEG;
+			out[OE_APO][i0+i]    = blk[OE_APO][i];
+			out[OE_PERI][i0+i]   = blk[OE_PERI][i];
+			out[OE_ECC][i0+i]    = blk[OE_ECC][i];
+			out[OE_PERIOD][i0+i] = blk[OE_PERIOD][i];
+			out[OE_ENERGY][i0+i] = blk[OE_ENERGY][i];
+		}
+	}
+}
@@ -0,0 +1,50 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// OrbitElements.h
+// Orbital elements of state vectors relative to a reference body.
+// ==============================================================
+
+#ifndef __ORBITELEMENTS_H
+#define __ORBITELEMENTS_H
+
+// element channels (in logged units)
+enum {
+	OE_APO,      // apoapsis altitude (km, 0 when unbound)
+	OE_PERI,     // periapsis altitude (km)
+	OE_ECC,      // eccentricity
+	OE_INC,      // inclination to the body's equator (deg)
+	OE_MANOM,    // mean anomaly (deg, wraps at +-180; 0 when unbound)
+	OE_PERIOD,   // orbit period (s, 0 when unbound)
+	OE_ENERGY,   // specific orbital energy (MJ/kg)
+	NORBIT
+};
+
+// constants of the reference body, looked up once per body
+struct OrbitBody {
+	double gm;       // gravitational parameter (m^3/s^2)
+	double radius;   // mean radius (m)
+	double pole[3];  // unit rotation axis (north) in the frame of the vectors
+};
+
+// state vectors relative to the body, one per index (m, m/s), in Orbiter's
+// left-handed frame
+struct StateVectors {
+	const double *rx, *ry, *rz;
+	const double *vx, *vy, *vz;
+};
+
+// Elements of n state vectors into out[OE_*][0..n). The loop body has no
+// branches and reads and writes the channels as separate arrays, so the
+// compiler can vectorise it over the batch; a single vector (n = 1) goes
+// through the same code.
+void OrbitElements (const OrbitBody &b, const StateVectors &sv, int n, double *const out[NORBIT]);
+
+// time to the next apoapsis from the mean anomaly (deg) and the period (s)
+inline double TimeToApoapsis (double manom, double period)
+{
+	return (180.0-manom)/360.0*period;
+}
+
+#endif // !__ORBITELEMENTS_H
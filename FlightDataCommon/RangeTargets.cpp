@@ -0,0 +1,134 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// RangeTargets.cpp
+// Range and bearing from the vessel to a set of surface targets.
+// ==============================================================
+
+#include <cmath>
+#include "RangeTargets.h"
+
+static const double PI2 = 6.283185307179586;
+
+RangeTargets::RangeTargets ()
+{
+	Clear();
+}
+
+void RangeTargets::Clear ()
+{
+	name.clear(), kind.clear(), obj.clear();
+	ux.clear(), uy.clear(), uz.clear();
+	hmin.clear(), tmin.clear();
+	have_pos = false;
+}
+
+int RangeTargets::Add (const char *_name, int _kind, void *_obj, double lon, double lat)
+{
+	name.push_back (_name);
+	kind.push_back (_kind);
+	obj.push_back (_obj);
+	ux.push_back (0.0), uy.push_back (0.0), uz.push_back (0.0);
+	hmin.push_back (1.0), tmin.push_back (0.0);
+	int k = Count()-1;
+	Move (k, lon, lat);
+	return k;
+}
+
+void RangeTargets::Move (int k, double lon, double lat)
+{
+	double clat = cos (lat);
+	ux[k] = clat*cos (lon);
+	uy[k] = clat*sin (lon);
+	uz[k] = sin (lat);
+}
+
+void RangeTargets::Remove (int k)
+{
+	name.erase (name.begin()+k), kind.erase (kind.begin()+k), obj.erase (obj.begin()+k);
+	ux.erase (ux.begin()+k), uy.erase (uy.begin()+k), uz.erase (uz.begin()+k);
+	hmin.erase (hmin.begin()+k), tmin.erase (tmin.begin()+k);
+}
+
+void RangeTargets::ResetClosest ()
+{
+	for (int k = 0; k < Count(); k++) hmin[k] = 1.0, tmin[k] = 0.0;
+}
+
+void RangeTargets::Update (double t, double lon, double lat)
+{
+	double clat = cos (lat), slat = sin (lat), clon = cos (lon), slon = sin (lon);
+	vx = clat*clon, vy = clat*slon, vz = slat;
+	east[0] = -slon, east[1] = clon, east[2] = 0.0;
+	north[0] = -slat*clon, north[1] = -slat*slon, north[2] = clat;
+	have_pos = true;
+
+	const double *x = ux.data(), *y = uy.data(), *z = uz.data();
+	const double px = vx, py = vy, pz = vz;   // not reloaded after each store
+	double *hm = hmin.data(), *tm = tmin.data();
+	int n = Count();
+	for (int k = 0; k < n; k++) {
+		double dx = x[k]-px, dy = y[k]-py, dz = z[k]-pz;
+		double h = 0.25*(dx*dx + dy*dy + dz*dz);
+		// one comparison feeding two selects is turned back into a branch,
+		// so the new minimum is blended in with a 0/1 mask (exact to a
+		// rounding of the stored value)
+		double m = hm[k], tk = tm[k];
+		double c = (h < m ? 1.0 : 0.0);
+		hm[k] = m + c*(h-m);
+		tm[k] = tk + c*(t-tk);
+	}
+}
+
+// hav(theta) = (1-cos(theta))/2 = |u-v|^2/4; from the difference of the
+// vectors it keeps its precision down to metres
+double RangeTargets::Hav (int k) const
+{
+	double dx = ux[k]-vx, dy = uy[k]-vy, dz = uz[k]-vz;
+	return 0.25*(dx*dx + dy*dy + dz*dz);
+}
+
+// theta = 2*asin(sqrt(hav)); hav is at most 1 but for rounding
+static double Angle (double h)
+{
+	return 2.0*asin (sqrt (h < 1.0 ? h : 1.0));
+}
+
+double RangeTargets::Range (int k, double radius) const
+{
+	return radius*Angle (Hav (k));
+}
+
+void RangeTargets::Ranges (double radius, double *out) const
+{
+	for (int k = 0; k < Count(); k++) out[k] = radius*Angle (Hav (k));
+}
+
+double RangeTargets::Closest (int k, double radius) const
+{
+	return radius*Angle (hmin[k]);
+}
+
+double RangeTargets::Bearing (int k) const
+{
+	double e = ux[k]*east[0] + uy[k]*east[1] + uz[k]*east[2];
+	double n = ux[k]*north[0] + uy[k]*north[1] + uz[k]*north[2];
+	double b = atan2 (e, n);
+	return (b < 0.0 ? b + PI2 : b);
+}
+
+std::vector<std::string> SplitTargetList (const std::string &list)
+{
+	std::vector<std::string> out;
+	size_t p = 0;
+	while (p <= list.size()) {
+		size_t q = list.find (',', p);
+		if (q == std::string::npos) q = list.size();
+		size_t a = list.find_first_not_of (" \t", p), b = list.find_last_not_of (" \t", q ? q-1 : 0);
+		if (a != std::string::npos && a < q && b != std::string::npos && b >= a)
+			out.push_back (list.substr (a, b-a+1));
+		p = q+1;
+	}
+	return out;
+}
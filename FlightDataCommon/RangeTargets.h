@@ -0,0 +1,62 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// RangeTargets.h
+// Range and bearing from the vessel to a set of surface targets.
+// ==============================================================
+
+#ifndef __RANGETARGETS_H
+#define __RANGETARGETS_H
+
+#include <string>
+#include <vector>
+
+// kinds of range target, in the order they are looked up by name
+enum { TGT_BASE, TGT_VESSEL, TGT_STATION, NTGTKIND };
+
+// Targets on the surface of the reference body, each held as the unit
+// vector of its position, so the trig of a target is taken once when it
+// is added (or moves) rather than once per sample. The haversine of the
+// central angle from the vessel to a target is |u_vessel - u_target|^2/4.
+// Update() takes it for every target to keep the closest approaches; the
+// loop has neither trig nor branches, and the targets are laid out as
+// separate arrays so it vectorises. The asin and atan2 that turn it into
+// a range and a bearing are left to the targets that are shown or logged.
+class RangeTargets {
+public:
+	RangeTargets ();
+	void Clear ();
+	int Add (const char *name, int kind, void *obj, double lon, double lat);  // rad; returns index
+	void Move (int k, double lon, double lat);      // new position of a moving target
+	void Remove (int k);
+	int Count () const { return (int)name.size(); }
+	const char *Name (int k) const { return name[k].c_str(); }
+	int Kind (int k) const { return kind[k]; }
+	void *Object (int k) const { return obj[k]; }  // handle of the caller's object
+
+	void Update (double t, double lon, double lat);  // vessel position (rad) at time t
+	void ResetClosest ();
+	bool Valid () const { return have_pos; }
+	double Range (int k, double radius) const;       // great circle distance, in units of radius
+	double Bearing (int k) const;                    // initial course to the target (rad, 0..2pi)
+	void Ranges (double radius, double *out) const;  // Range() of all targets
+	double Closest (int k, double radius) const;     // closest approach since the reset
+	double ClosestTime (int k) const { return tmin[k]; }
+
+private:
+	double Hav (int k) const;
+	std::vector<std::string> name;
+	std::vector<int> kind;
+	std::vector<void*> obj;
+	std::vector<double> ux, uy, uz;  // target unit vectors
+	std::vector<double> hmin, tmin;  // closest approach and its time
+	double vx, vy, vz;               // vessel unit vector
+	double east[3], north[3];        // local horizon directions at the vessel
+	bool have_pos;
+};
+
+// split a comma separated list of target names, trimming blanks
+std::vector<std::string> SplitTargetList (const std::string &list);
+
+#endif // !__RANGETARGETS_H
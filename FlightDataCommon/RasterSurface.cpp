@@ -0,0 +1,254 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// RasterSurface.cpp
+// Portable software rasterizer into an in-memory RGBA buffer.
+// ==============================================================
+
+#include <cstring>
+#include "ImageIO.h"
+#include "RasterSurface.h"
+
+// 5x7 font for characters 32..126, one byte per column, bit 0 at the top
+// (bit 7 is the descender row)
+static const unsigned char font5x7[95][5] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00},  //  
+	{0x00, 0x00, 0x5f, 0x00, 0x00},  // !
+	{0x00, 0x07, 0x00, 0x07, 0x00},  // "
+	{0x14, 0x7f, 0x14, 0x7f, 0x14},  // #
+	{0x24, 0x2a, 0x7f, 0x2a, 0x12},  // $
+	{0x23, 0x13, 0x08, 0x64, 0x62},  // %
+	{0x36, 0x49, 0x56, 0x20, 0x50},  // &
+	{0x00, 0x08, 0x07, 0x03, 0x00},  // quote
+	{0x00, 0x1c, 0x22, 0x41, 0x00},  // (
+	{0x00, 0x41, 0x22, 0x1c, 0x00},  // )
+	{0x2a, 0x1c, 0x7f, 0x1c, 0x2a},  // *
+	{0x08, 0x08, 0x3e, 0x08, 0x08},  // +
+	{0x00, 0x80, 0x70, 0x30, 0x00},  // ,
+	{0x08, 0x08, 0x08, 0x08, 0x08},  // -
+	{0x00, 0x00, 0x60, 0x60, 0x00},  // .
+	{0x20, 0x10, 0x08, 0x04, 0x02},  // /
+	{0x3e, 0x51, 0x49, 0x45, 0x3e},  // 0
+	{0x00, 0x42, 0x7f, 0x40, 0x00},  // 1
+	{0x72, 0x49, 0x49, 0x49, 0x46},  // 2
+	{0x21, 0x41, 0x49, 0x4d, 0x33},  // 3
+	{0x18, 0x14, 0x12, 0x7f, 0x10},  // 4
+	{0x27, 0x45, 0x45, 0x45, 0x39},  // 5
+	{0x3c, 0x4a, 0x49, 0x49, 0x31},  // 6
+	{0x41, 0x21, 0x11, 0x09, 0x07},  // 7
+	{0x36, 0x49, 0x49, 0x49, 0x36},  // 8
+	{0x46, 0x49, 0x49, 0x29, 0x1e},  // 9
+	{0x00, 0x00, 0x14, 0x00, 0x00},  // :
+	{0x00, 0x40, 0x34, 0x00, 0x00},  // ;
+	{0x00, 0x08, 0x14, 0x22, 0x41},  // <
+	{0x14, 0x14, 0x14, 0x14, 0x14},  // =
+	{0x00, 0x41, 0x22, 0x14, 0x08},  // >
+	{0x02, 0x01, 0x59, 0x09, 0x06},  // ?
+	{0x3e, 0x41, 0x5d, 0x59, 0x4e},  // @
+	{0x7c, 0x12, 0x11, 0x12, 0x7c},  // A
+	{0x7f, 0x49, 0x49, 0x49, 0x36},  // B
+	{0x3e, 0x41, 0x41, 0x41, 0x22},  // C
+	{0x7f, 0x41, 0x41, 0x41, 0x3e},  // D
+	{0x7f, 0x49, 0x49, 0x49, 0x41},  // E
+	{0x7f, 0x09, 0x09, 0x09, 0x01},  // F
+	{0x3e, 0x41, 0x41, 0x51, 0x73},  // G
+	{0x7f, 0x08, 0x08, 0x08, 0x7f},  // H
+	{0x00, 0x41, 0x7f, 0x41, 0x00},  // I
+	{0x20, 0x40, 0x41, 0x3f, 0x01},  // J
+	{0x7f, 0x08, 0x14, 0x22, 0x41},  // K
+	{0x7f, 0x40, 0x40, 0x40, 0x40},  // L
+	{0x7f, 0x02, 0x1c, 0x02, 0x7f},  // M
+	{0x7f, 0x04, 0x08, 0x10, 0x7f},  // N
+	{0x3e, 0x41, 0x41, 0x41, 0x3e},  // O
+	{0x7f, 0x09, 0x09, 0x09, 0x06},  // P
+	{0x3e, 0x41, 0x51, 0x21, 0x5e},  // Q
+	{0x7f, 0x09, 0x19, 0x29, 0x46},  // R
+	{0x26, 0x49, 0x49, 0x49, 0x32},  // S
+	{0x03, 0x01, 0x7f, 0x01, 0x03},  // T
+	{0x3f, 0x40, 0x40, 0x40, 0x3f},  // U
+	{0x1f, 0x20, 0x40, 0x20, 0x1f},  // V
+	{0x3f, 0x40, 0x38, 0x40, 0x3f},  // W
+	{0x63, 0x14, 0x08, 0x14, 0x63},  // X
+	{0x03, 0x04, 0x78, 0x04, 0x03},  // Y
+	{0x61, 0x59, 0x49, 0x4d, 0x43},  // Z
+	{0x00, 0x7f, 0x41, 0x41, 0x41},  // [
+	{0x02, 0x04, 0x08, 0x10, 0x20},  // backslash
+	{0x00, 0x41, 0x41, 0x41, 0x7f},  // ]
+	{0x04, 0x02, 0x01, 0x02, 0x04},  // ^
+	{0x40, 0x40, 0x40, 0x40, 0x40},  // _
+	{0x00, 0x03, 0x07, 0x08, 0x00},  // `
+	{0x20, 0x54, 0x54, 0x78, 0x40},  // a
+	{0x7f, 0x28, 0x44, 0x44, 0x38},  // b
+	{0x38, 0x44, 0x44, 0x44, 0x28},  // c
+	{0x38, 0x44, 0x44, 0x28, 0x7f},  // d
+	{0x38, 0x54, 0x54, 0x54, 0x18},  // e
+	{0x00, 0x08, 0x7e, 0x09, 0x02},  // f
+	{0x18, 0xa4, 0xa4, 0x9c, 0x78},  // g
+	{0x7f, 0x08, 0x04, 0x04, 0x78},  // h
+	{0x00, 0x44, 0x7d, 0x40, 0x00},  // i
+	{0x20, 0x40, 0x40, 0x3d, 0x00},  // j
+	{0x7f, 0x10, 0x28, 0x44, 0x00},  // k
+	{0x00, 0x41, 0x7f, 0x40, 0x00},  // l
+	{0x7c, 0x04, 0x78, 0x04, 0x78},  // m
+	{0x7c, 0x08, 0x04, 0x04, 0x78},  // n
+	{0x38, 0x44, 0x44, 0x44, 0x38},  // o
+	{0xfc, 0x18, 0x24, 0x24, 0x18},  // p
+	{0x18, 0x24, 0x24, 0x18, 0xfc},  // q
+	{0x7c, 0x08, 0x04, 0x04, 0x08},  // r
+	{0x48, 0x54, 0x54, 0x54, 0x24},  // s
+	{0x04, 0x04, 0x3f, 0x44, 0x24},  // t
+	{0x3c, 0x40, 0x40, 0x20, 0x7c},  // u
+	{0x1c, 0x20, 0x40, 0x20, 0x1c},  // v
+	{0x3c, 0x40, 0x30, 0x40, 0x3c},  // w
+	{0x44, 0x28, 0x10, 0x28, 0x44},  // x
+	{0x4c, 0x90, 0x90, 0x90, 0x7c},  // y
+	{0x44, 0x64, 0x54, 0x4c, 0x44},  // z
+	{0x00, 0x08, 0x36, 0x41, 0x00},  // {
+	{0x00, 0x00, 0x77, 0x00, 0x00},  // |
+	{0x00, 0x41, 0x36, 0x08, 0x00},  // }
+	{0x02, 0x01, 0x02, 0x04, 0x02},  // ~
+};
+
+RasterSurface::RasterSurface (int _w, int _h)
+{
+	w = (_w > 0 ? _w : 1);
+	h = (_h > 0 ? _h : 1);
+	px = new unsigned char[4*(size_t)w*h];
+	memset (px, 0xff, 4*(size_t)w*h);
+	ox = oy = 0;
+}
+
+RasterSurface::~RasterSurface ()
+{
+	delete []px;
+}
+
+void RasterSurface::Fill (int x, int y, int _w, int _h, SurfColor col)
+{
+	int x0 = x+ox, y0 = y+oy, x1 = x0+_w, y1 = y0+_h;
+	if (x0 < 0) x0 = 0;
+	if (y0 < 0) y0 = 0;
+	if (x1 > w) x1 = w;
+	if (y1 > h) y1 = h;
+	if (x1 <= x0 || y1 <= y0) return;
+	// the first row pixel by pixel, the others copied from it
+	for (int i = x0; i < x1; i++) Plot (i, y0, col);
+	const unsigned char *row = px + 4*((size_t)y0*w + x0);
+	for (int j = y0+1; j < y1; j++)
+		memcpy (px + 4*((size_t)j*w + x0), row, 4*(size_t)(x1-x0));
+}
+
+// Liang-Barsky
+bool ClipSegment (double &x0, double &y0, double &x1, double &y1, int w, int h)
+{
+	double t0 = 0.0, t1 = 1.0, dx = x1-x0, dy = y1-y0;
+	double p[4] = {-dx, dx, -dy, dy};
+	double q[4] = {x0, w-1-x0, y0, h-1-y0};
+	for (int i = 0; i < 4; i++) {
+		if (p[i] == 0.0) {
+			if (q[i] < 0.0) return false;
+		} else {
+			double r = q[i]/p[i];
+			if (p[i] < 0.0) { if (r > t1) return false; if (r > t0) t0 = r; }
+			else            { if (r < t0) return false; if (r < t1) t1 = r; }
+		}
+	}
+	double ax = x0, ay = y0;
+	x0 = ax + t0*dx, y0 = ay + t0*dy;
+	x1 = ax + t1*dx, y1 = ay + t1*dy;
+	return true;
+}
+
+// GDI convention: the last point of a line is not drawn
+void RasterSurface::Line (int x0, int y0, int x1, int y1, SurfColor col)
+{
+	x0 += ox, y0 += oy, x1 += ox, y1 += oy;
+	int ex = x1, ey = y1;
+	if ((unsigned)x0 >= (unsigned)w || (unsigned)y0 >= (unsigned)h ||
+		(unsigned)x1 >= (unsigned)w || (unsigned)y1 >= (unsigned)h) {
+		double fx0 = x0, fy0 = y0, fx1 = x1, fy1 = y1;
+		if (!ClipSegment (fx0, fy0, fx1, fy1, w, h)) return;
+		x0 = (int)(fx0+0.5), y0 = (int)(fy0+0.5);
+		x1 = (int)(fx1+0.5), y1 = (int)(fy1+0.5);
+	}
+	int dx = (x1 > x0 ? x1-x0 : x0-x1), sx = (x0 < x1 ? 1 : -1);
+	int dy = (y1 > y0 ? y0-y1 : y1-y0), sy = (y0 < y1 ? 1 : -1);
+	int err = dx+dy;
+	for (;;) {
+		if (x0 == ex && y0 == ey) break;
+		Plot (x0, y0, col);
+		if (x0 == x1 && y0 == y1) break;
+		int e2 = 2*err;
+		if (e2 >= dy) err += dy, x0 += sx;
+		if (e2 <= dx) err += dx, y0 += sy;
+	}
+}
+
+void RasterSurface::Polyline (const SurfPoint *pt, int n, SurfColor col)
+{
+	for (int i = 1; i < n; i++)
+		Line (pt[i-1].x, pt[i-1].y, pt[i].x, pt[i].y, col);
+}
+
+int RasterSurface::TextWidth (const char *str)
+{
+	int n = (int)strlen (str);
+	return (n ? n*CHAR_W-1 : 0);
+}
+
+void RasterSurface::Text (int x, int y, const char *str, SurfColor col, int align, bool vertical)
+{
+	int len = TextWidth (str);
+	int ofs = (align == TXT_CENTER ? len/2 : align == TXT_RIGHT ? len : 0);
+	x += ox, y += oy;
+	if (vertical) y += ofs;
+	else x -= ofs;
+
+	for (int i = 0; str[i]; i++) {
+		unsigned char c = (unsigned char)str[i];
+		if (c < 32 || c > 126) c = '?';
+		const unsigned char *g = font5x7[c-32];
+		for (int cx = 0; cx < 5; cx++)
+			for (int r = 0; r < 8; r++)
+				if (g[cx] & (1 << r)) {
+					// vertical text reads bottom to top, glyph tops to the left
+					if (vertical) Plot (x+r, y-(i*CHAR_W+cx), col);
+					else Plot (x+i*CHAR_W+cx, y+r, col);
+				}
+	}
+}
+
+Surface *RasterSurface::CreateLayer (int _w, int _h)
+{
+	return new RasterSurface (_w, _h);
+}
+
+void RasterSurface::Blit (Surface *layer, int x, int y)
+{
+	const RasterSurface *src = static_cast<RasterSurface*>(layer);
+	x += ox, y += oy;
+	int i0 = (x < 0 ? -x : 0), i1 = (x+src->w > w ? w-x : src->w);
+	if (i1 <= i0) return;
+	for (int j = 0; j < src->h; j++) {
+		if (y+j < 0 || y+j >= h) continue;
+		memcpy (px + 4*((size_t)(y+j)*w + x+i0), src->px + 4*((size_t)j*src->w + i0), 4*(size_t)(i1-i0));
+	}
+}
+
+SurfColor RasterSurface::Pixel (int x, int y) const
+{
+	if ((unsigned)x >= (unsigned)w || (unsigned)y >= (unsigned)h) return 0;
+	const unsigned char *p = px + 4*((size_t)y*w + x);
+	return p[0] | (p[1] << 8) | (p[2] << 16);
+}
+
+bool RasterSurface::WritePPM (const char *path) const
+{
+	return ::WritePPM (path, px, w, h);
+}
+
+bool RasterSurface::WritePNG (const char *path) const
+{
+	return ::WritePNG (path, px, w, h);
+}
@@ -0,0 +1,60 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// RasterSurface.h
+// Portable software rasterizer into an in-memory RGBA buffer.
+// ==============================================================
+
+#ifndef __RASTERSURFACE_H
+#define __RASTERSURFACE_H
+
+#include "Surface.h"
+
+// Surface drawing into a w*h RGBA buffer (4 bytes per pixel, rows top to
+// bottom). Lines are clipped and drawn with Bresenham's algorithm; text
+// uses a built-in 5x7 bitmap font in 6x9 pixel cells. Needs no window
+// system, so graphs can be rendered headless, compared against golden
+// images and benchmarked on any platform.
+class RasterSurface: public Surface {
+public:
+	RasterSurface (int _w, int _h);
+	~RasterSurface ();
+	int  Width () const { return w; }
+	int  Height () const { return h; }
+	void SetOrigin (int x, int y) { ox = x, oy = y; }
+	void Fill (int x, int y, int _w, int _h, SurfColor col);
+	void Line (int x0, int y0, int x1, int y1, SurfColor col);
+	void Polyline (const SurfPoint *pt, int n, SurfColor col);
+	void Text (int x, int y, const char *str, SurfColor col, int align, bool vertical = false);
+	Surface *CreateLayer (int _w, int _h);
+	void Blit (Surface *layer, int x, int y);
+
+	const unsigned char *Pixels () const { return px; }
+	SurfColor Pixel (int x, int y) const;
+	bool WritePPM (const char *path) const;
+	bool WritePNG (const char *path) const;
+
+	static int TextWidth (const char *str);
+	enum { CHAR_W = 6, CHAR_H = 9 };
+
+private:
+	void Plot (int x, int y, SurfColor col)
+	{
+		if ((unsigned)x < (unsigned)w && (unsigned)y < (unsigned)h) {
+			unsigned char *p = px + 4*((size_t)y*w + x);
+			p[0] = (unsigned char)col;
+			p[1] = (unsigned char)(col >> 8);
+			p[2] = (unsigned char)(col >> 16);
+			p[3] = 0xff;
+		}
+	}
+	unsigned char *px;  // RGBA pixels
+	int w, h;           // size
+	int ox, oy;         // origin
+};
+
+// clip a segment to [0,w-1]x[0,h-1]; false if it lies outside
+bool ClipSegment (double &x0, double &y0, double &x1, double &y1, int w, int h);
+
+#endif // !__RASTERSURFACE_H
@@ -0,0 +1,149 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// RefTrajectory.cpp
+// Altitude-indexed reference trajectory from a previous flight log.
+// ==============================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "RefTrajectory.h"
+
+// log columns read (see Column_list.txt)
+#define COL_ALT   2
+#define COL_V_RAD 6
+#define COL_V_TAN 7
+#define COL_DIST  14
+
+#define HYST 0.005f    // turn-round hysteresis, fraction of the altitude range
+
+RefTrajectory::RefTrajectory ()
+{
+	nrun = 0;
+	hasdist = false;
+}
+
+void RefTrajectory::Clear ()
+{
+	for (int r = 0; r < REF_NRUN; r++) run[r].clear();
+	nrun = 0;
+	hasdist = false;
+	path.clear();
+}
+
+static bool ParseLine (char *s, char delim, RefPoint &p)
+{
+	const char *sep = (delim ? 0 : " \t,;|");
+	int c = 0;
+	char *end;
+	p.dist = 0.0f;
+	while (*s && c <= COL_DIST) {
+		while (*s && (delim ? *s == delim : strchr (sep, *s) != 0)) s++;
+		if (!*s || *s == '\r' || *s == '\n') break;
+		float v = strtof (s, &end);
+		if (end == s) return false;
+		switch (c) {
+			case COL_ALT:   p.alt = v; break;
+			case COL_V_RAD: p.v_rad = v; break;
+			case COL_V_TAN: p.v_tan = v; break;
+			case COL_DIST:  p.dist = v; break;
+		}
+		s = end;
+		c++;
+	}
+	return c > COL_V_TAN;
+}
+
+bool RefTrajectory::Load (const char *_path, char delim)
+{
+	std::vector<RefPoint> pt;
+	RefPoint p;
+	char line[1024];
+	size_t i;
+
+	Clear();
+	FILE *f = fopen (_path, "r");
+	if (!f) return false;
+	while (fgets (line, sizeof(line), f))
+		if (ParseLine (line, delim, p) && std::isfinite (p.alt)) pt.push_back (p);
+	fclose (f);
+	if (pt.size() < 2) return false;
+
+	float amin = pt[0].alt, amax = pt[0].alt;
+	for (i = 0; i < pt.size(); i++) {
+		amin = std::min (amin, pt[i].alt), amax = std::max (amax, pt[i].alt);
+		if (pt[i].dist != 0.0f) hasdist = true;
+	}
+	if (!(amax > amin)) return false;
+	const float hyst = HYST*(amax-amin), step = (amax-amin)/REF_MAXPT;
+
+	// split at the turning points: a run ends at its extremum once the
+	// altitude has come back from it by more than the hysteresis
+	struct Span { size_t s, e; int dir; float extent; };
+	std::vector<Span> span;
+	size_t st = 0, ext = 0, lo = 0, hi = 0;
+	int dir = 0;
+	for (i = 1; i < pt.size(); i++) {
+		float a = pt[i].alt;
+		if (!dir) {
+			// level until the altitude has moved by the hysteresis
+			if (a < pt[lo].alt) lo = i;
+			if (a > pt[hi].alt) hi = i;
+			if (pt[hi].alt-pt[lo].alt > hyst) {
+				dir = (hi > lo ? 1 : -1);
+				st = (dir > 0 ? lo : hi), ext = i;
+			}
+		} else if ((dir > 0) ? a > pt[ext].alt : a < pt[ext].alt) ext = i;
+		else if (std::fabs (a-pt[ext].alt) > hyst) {
+			span.push_back (Span{st, ext, dir, std::fabs (pt[ext].alt-pt[st].alt)});
+			st = ext, ext = i, dir = -dir;
+		}
+	}
+	if (dir) span.push_back (Span{st, ext, dir, std::fabs (pt[ext].alt-pt[st].alt)});
+	if (span.empty()) return false;
+
+	// keep the REF_NRUN largest, in flight order
+	if (span.size() > REF_NRUN) {
+		std::vector<Span> big (span);
+		std::nth_element (big.begin(), big.begin()+REF_NRUN-1, big.end(),
+			[](const Span &a, const Span &b) { return a.extent > b.extent; });
+		float cut = big[REF_NRUN-1].extent;
+		std::vector<Span> keep;
+		for (i = 0; i < span.size() && keep.size() < REF_NRUN; i++)
+			if (span[i].extent > cut) keep.push_back (span[i]);
+		for (i = 0; i < span.size() && keep.size() < REF_NRUN; i++)
+			if (span[i].extent == cut) keep.push_back (span[i]);
+		std::sort (keep.begin(), keep.end(), [](const Span &a, const Span &b) { return a.s < b.s; });
+		span = keep;
+	}
+
+	// reduce each run to points with rising altitude, 'step' apart;
+	// jitter within the hysteresis is dropped on the way
+	for (size_t r = 0; r < span.size(); r++) {
+		std::vector<RefPoint> &v = run[nrun];
+		const Span &sp = span[r];
+		for (size_t k = 0; k <= sp.e-sp.s; k++) {
+			const RefPoint &q = pt[sp.dir > 0 ? sp.s+k : sp.e-k];
+			if (v.empty() || q.alt >= v.back().alt+step) v.push_back (q);
+		}
+		if (v.size() >= 2) nrun++;
+		else v.clear();
+	}
+	path = _path;
+	return nrun > 0;
+}
+
+int RefTrajectory::Find (int r, float lo, float hi, int &first) const
+{
+	const std::vector<RefPoint> &v = run[r];
+	auto below = [](const RefPoint &p, float a) { return p.alt < a; };
+	auto above = [](float a, const RefPoint &p) { return a < p.alt; };
+	auto b = std::lower_bound (v.begin(), v.end(), lo, below);
+	auto e = std::upper_bound (b, v.end(), hi, above);
+	first = (int)(b - v.begin());
+	return (int)(e - b);
+}
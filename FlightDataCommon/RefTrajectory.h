@@ -0,0 +1,54 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// RefTrajectory.h
+// Altitude-indexed reference trajectory from a previous flight log.
+// ==============================================================
+
+#ifndef __REFTRAJECTORY_H
+#define __REFTRAJECTORY_H
+
+#include <string>
+#include <vector>
+
+#define REF_NRUN  4       // altitude runs kept
+#define REF_MAXPT 4096    // points per run, at most
+
+struct RefPoint {
+	float alt;     // altitude (km)
+	float v_rad;   // radial velocity (m/s)
+	float v_tan;   // tangential velocity (m/s)
+	float dist;    // range to target base (km)
+};
+
+// A flight log reduced for overlaying on the altitude plots. The flight
+// is split where the altitude turns round (with a hysteresis of a fraction
+// of its range), the longest climbs and descents are kept, and each is
+// reduced to points at least 1/REF_MAXPT of the range apart, in order of
+// altitude. The points of a run inside an altitude window are then a
+// contiguous slice, found by two binary searches.
+class RefTrajectory {
+public:
+	RefTrajectory ();
+	// read a text flight log; delim 0 accepts any of space tab , ; |
+	bool Load (const char *path, char delim);
+	void Clear ();
+	bool Loaded () const { return nrun > 0; }
+	const char *Path () const { return path.c_str(); }
+	int  Runs () const { return nrun; }
+	bool HasDist () const { return hasdist; }     // logged with a target base
+	// slice of run r with lo <= alt <= hi: returns its length, first point
+	// in 'first'; O(log n)
+	int  Find (int r, float lo, float hi, int &first) const;
+	int  Size (int r) const { return (int)run[r].size(); }
+	const RefPoint &Point (int r, int i) const { return run[r][i]; }
+
+private:
+	std::vector<RefPoint> run[REF_NRUN];   // rising altitude
+	int nrun;
+	bool hasdist;
+	std::string path;
+};
+
+#endif // !__REFTRAJECTORY_H
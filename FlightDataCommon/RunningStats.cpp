@@ -0,0 +1,190 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// RunningStats.cpp
+// Streaming moments and quantiles of a channel, over a whole session
+// and over a sliding window of sim time.
+// ==============================================================
+
+#include <algorithm>
+#include <cmath>
+#include "RunningStats.h"
+
+void Moments::Add (float v)
+{
+	if (!n) vmin = vmax = v;
+	else if (v < vmin) vmin = v;
+	else if (v > vmax) vmax = v;
+	n++;
+	double d = v - mean;
+	mean += d/n;
+	m2 += d*(v - mean);
+}
+
+void Moments::Merge (const Moments &o)
+{
+	if (!o.n) return;
+	if (!n) { *this = o; return; }
+	double d = o.mean - mean;
+	long long nn = n + o.n;
+	mean += d*o.n/nn;
+	m2 += o.m2 + d*d*((double)n*o.n/nn);
+	n = nn;
+	if (o.vmin < vmin) vmin = o.vmin;
+	if (o.vmax > vmax) vmax = o.vmax;
+}
+
+double Moments::Sd () const
+{
+	return sqrt (Var());
+}
+
+QuantileSketch::QuantileSketch (int _k)
+{
+	k = (_k < 8 ? 8 : _k);
+	seed = 0x9e3779b9u;
+	Reset();
+}
+
+void QuantileSketch::Reset ()
+{
+	// keep the buffers: a sketch is refilled as often as a window turns
+	for (size_t h = 0; h < level.size(); h++) level[h].clear();
+	if (level.empty()) level.resize (1);
+	n = 0;
+	nitem = 0;
+	SetCapacity();
+}
+
+// capacity of level h: k at the top, 2/3 of that per level below
+int QuantileSketch::LevelCap (int h) const
+{
+	int c = (int)(k*pow (2.0/3.0, (int)level.size()-1-h) + 0.5);
+	return (c < 2 ? 2 : c);
+}
+
+// the capacities only change with the number of levels
+void QuantileSketch::SetCapacity ()
+{
+	capacity = 0;
+	for (int h = 0; h < (int)level.size(); h++) capacity += LevelCap (h);
+}
+
+void QuantileSketch::Add (float v)
+{
+	level[0].push_back (v);
+	n++;
+	if (++nitem >= capacity) Compress();
+}
+
+// compact the lowest level at capacity until the sketch is below its
+// total; some level is at capacity as long as the total is reached
+void QuantileSketch::Compress ()
+{
+	while (nitem >= capacity) {
+		int h;
+		for (h = 0; h < (int)level.size()-1; h++)
+			if ((int)level[h].size() >= LevelCap (h)) break;
+		Compact (h);
+	}
+}
+
+// move every other item of level h up a level; a new top level lowers
+// the capacities of those below
+void QuantileSketch::Compact (int h)
+{
+	if (h+1 == (int)level.size()) {
+		level.resize (h+2);
+		SetCapacity();
+	}
+	std::vector<float> &lv = level[h], &up = level[h+1];
+	std::sort (lv.begin(), lv.end());
+	// an odd item out stays behind with its weight
+	size_t m = lv.size() & ~(size_t)1;
+	seed = seed*1664525u + 1013904223u;
+	for (size_t i = (seed >> 31); i < m; i += 2) up.push_back (lv[i]);
+	nitem -= (int)(m/2);
+	if (m < lv.size()) lv[0] = lv[m], lv.resize (1);
+	else lv.clear();
+}
+
+void QuantileSketch::Merge (const QuantileSketch &o)
+{
+	if (o.level.size() > level.size()) {
+		level.resize (o.level.size());
+		SetCapacity();
+	}
+	for (size_t h = 0; h < o.level.size(); h++)
+		level[h].insert (level[h].end(), o.level[h].begin(), o.level[h].end());
+	n += o.n;
+	nitem += o.nitem;
+	if (nitem >= capacity) Compress();
+}
+
+void QuantileSketch::Quantiles (const double *q, int nq, float *out) const
+{
+	std::vector<std::pair<float, long long> > item;
+	long long w = 0;
+	item.reserve (Items());
+	for (size_t h = 0; h < level.size(); h++)
+		for (float v : level[h]) item.push_back (std::make_pair (v, 1LL << h)), w += 1LL << h;
+	if (item.empty()) {
+		for (int j = 0; j < nq; j++) out[j] = 0.0f;
+		return;
+	}
+	std::sort (item.begin(), item.end());
+	for (int j = 0; j < nq; j++) {
+		double r = q[j]*w;
+		long long c = 0;
+		size_t i;
+		for (i = 0; i+1 < item.size(); i++)
+			if ((c += item[i].second) > r) break;
+		out[j] = item[i].first;
+	}
+}
+
+WindowStats::WindowStats ()
+{
+	span = 60.0;
+	Reset();
+}
+
+void WindowStats::SetSpan (double _span)
+{
+	if (_span > 0.0 && _span != span) {
+		span = _span;
+		Reset();
+	}
+}
+
+void WindowStats::Reset ()
+{
+	for (int i = 0; i < NBUCKET; i++) b[i].Reset();
+	cur = 0;
+	tend = 0.0;
+	started = false;
+}
+
+void WindowStats::Add (double t, float v)
+{
+	double dt = span/NBUCKET;
+	if (!started || t < tend-dt || t >= tend+span) {
+		// first sample, time went back, or nothing of the window is left
+		Reset();
+		started = true;
+		tend = t + dt;
+	}
+	while (t >= tend) {
+		cur = (cur+1) % NBUCKET;
+		b[cur].Reset();
+		tend += dt;
+	}
+	b[cur].Add (v);
+}
+
+void WindowStats::Get (ChannelStats &s) const
+{
+	s.Reset();
+	for (int i = 1; i <= NBUCKET; i++) s.Merge (b[(cur+i) % NBUCKET]);
+}
@@ -0,0 +1,94 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// RunningStats.h
+// Streaming moments and quantiles of a channel, over a whole session
+// and over a sliding window of sim time.
+// ==============================================================
+
+#ifndef __RUNNINGSTATS_H
+#define __RUNNINGSTATS_H
+
+#include <vector>
+
+// Count, min, max, mean and variance by Welford's update; two sets merge
+// exactly (Chan et al.).
+struct Moments {
+	long long n;
+	double mean, m2;
+	float vmin, vmax;
+
+	void Reset () { n = 0; mean = m2 = 0.0; vmin = vmax = 0.0f; }
+	void Add (float v);
+	void Merge (const Moments &o);
+	double Var () const { return (n > 1 ? m2/(n-1) : 0.0); }
+	double Sd () const;
+};
+
+// Mergeable quantile sketch after Karnin, Lang and Liberty (KLL): level h
+// holds items of weight 2^h. The top level may hold k items and each one
+// below it 2/3 of the one above (at least 2), so the sketch holds under
+// 3k items plus 2 per level, whatever the length of the flight. When the
+// sketch is full, its lowest level at capacity is sorted and every other
+// item, starting at a random one of the first two, moves up a level. The
+// rank error stays within a few 1/k.
+class QuantileSketch {
+public:
+	QuantileSketch (int k = 128);
+	void Reset ();
+	void Add (float v);
+	void Merge (const QuantileSketch &o);
+	long long Count () const { return n; }
+	int Items () const { return nitem; }
+	// values at the ranks q[0..nq) (0..1); all from one sort
+	void Quantiles (const double *q, int nq, float *out) const;
+
+private:
+	int LevelCap (int h) const;
+	void SetCapacity ();
+	void Compress ();
+	void Compact (int h);
+	int k;
+	std::vector<std::vector<float> > level;
+	long long n;
+	int nitem;      // items held in all levels
+	int capacity;   // sum of the level capacities
+	unsigned int seed;
+};
+
+// moments and quantile sketch of one channel
+struct ChannelStats {
+	Moments m;
+	QuantileSketch q;
+
+	void Reset () { m.Reset(); q.Reset(); }
+	void Add (float v) { m.Add (v); q.Add (v); }
+	void Merge (const ChannelStats &o) { m.Merge (o.m); q.Merge (o.q); }
+};
+
+// Statistics of the last 'span' seconds of sim time, kept in NBUCKET
+// buckets of span/NBUCKET seconds each. A bucket is started when the
+// sample time passes the end of the current one, and the oldest is
+// dropped; the window is the merge of the buckets, so it covers between
+// span*(1-1/NBUCKET) and span seconds. Memory is that of NBUCKET
+// sketches, and adding a sample costs no more than for the session.
+class WindowStats {
+public:
+	static const int NBUCKET = 8;
+	WindowStats ();
+	void SetSpan (double span);
+	double Span () const { return span; }
+	void Reset ();
+	void Add (double t, float v);
+	void Get (ChannelStats &s) const;   // merge of the buckets in the window
+
+private:
+	ChannelStats b[NBUCKET];
+	double span;
+	double tend;      // sim time the current bucket ends
+	int cur;          // current bucket
+	bool started;
+};
+
+#endif // !__RUNNINGSTATS_H
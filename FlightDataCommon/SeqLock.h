@@ -0,0 +1,58 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// SeqLock.h
+// Sequence lock for publishing recorder data to renderers.
+// ==============================================================
+
+#ifndef __SEQLOCK_H
+#define __SEQLOCK_H
+
+#include <atomic>
+#include <thread>
+
+// Single-writer sequence lock. The writer never waits: it bumps the
+// sequence to an odd value before modifying the protected data and back
+// to even afterwards. Readers copy the data and retry if the sequence
+// was odd or changed while they were copying, so they always end up with
+// a consistent snapshot without ever holding up the writer.
+//
+//   writer:  lock.WriteBegin(); ...modify...; lock.WriteEnd();
+//   reader:  do { s = lock.ReadBegin(); ...copy...; } while (lock.ReadRetry (s));
+class SeqLock {
+public:
+	SeqLock (): seq(0) {}
+
+	void WriteBegin ()
+	{
+		seq.store (seq.load (std::memory_order_relaxed)+1, std::memory_order_relaxed);
+		std::atomic_thread_fence (std::memory_order_release);
+	}
+
+	void WriteEnd ()
+	{
+		seq.store (seq.load (std::memory_order_relaxed)+1, std::memory_order_release);
+	}
+
+	unsigned ReadBegin () const
+	{
+		unsigned s;
+		while ((s = seq.load (std::memory_order_acquire)) & 1)
+			std::this_thread::yield();
+		return s;
+	}
+
+	bool ReadRetry (unsigned s) const
+	{
+		std::atomic_thread_fence (std::memory_order_acquire);
+		return seq.load (std::memory_order_relaxed) != s;
+	}
+
+	unsigned Sequence () const { return seq.load (std::memory_order_acquire); }
+
+private:
+	std::atomic<unsigned> seq;  // odd while a write is in progress
+};
+
+#endif // !__SEQLOCK_H
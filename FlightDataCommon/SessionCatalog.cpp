@@ -0,0 +1,161 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// SessionCatalog.cpp
+// Catalog of recorded sessions kept in the log directory.
+// ==============================================================
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "SessionCatalog.h"
+
+const char *catchname[NCATCH] = {
+	"alt", "vrad", "vtan", "g", "dynp", "mach", "fuel", "dist"
+};
+
+static void CopyName (char *dst, const char *src, size_t n)
+{
+	strncpy (dst, src ? src : "", n-1);
+	dst[n-1] = '\0';
+}
+
+SessionStats::SessionStats ()
+{
+	memset (&e, 0, sizeof(e));
+	for (int c = 0; c < NCATCH; c++) st[c].Reset();
+	active = false;
+}
+
+void SessionStats::Start (const char *vessel, const char *tgt_base, const char *path)
+{
+	memset (&e, 0, sizeof(e));
+	CopyName (e.vessel, vessel, sizeof(e.vessel));
+	CopyName (e.tgt_base, tgt_base, sizeof(e.tgt_base));
+	CopyName (e.path, path, sizeof(e.path));
+	for (int c = 0; c < NCATCH; c++) st[c].Reset();
+	active = true;
+}
+
+void SessionStats::Add (double simt, double mjd, const float *v)
+{
+	if (!e.samples) {
+		e.t_start = simt, e.mjd_start = mjd;
+		for (int c = 0; c < NCATCH; c++) e.vmin[c] = e.vmax[c] = v[c];
+	}
+	e.t_end = simt, e.mjd_end = mjd;
+	for (int c = 0; c < NCATCH; c++) {
+		if (v[c] < e.vmin[c]) e.vmin[c] = v[c];
+		if (v[c] > e.vmax[c]) e.vmax[c] = v[c];
+		e.vlast[c] = v[c];
+		st[c].Add (v[c]);
+		e.vmean[c] = (float)st[c].m.mean;
+		e.vsd[c] = (float)st[c].m.Sd();
+	}
+	e.samples++;
+}
+
+const CatalogEntry &SessionStats::Summary ()
+{
+	static const double q[3] = {0.5, 0.95, 0.99};
+	float p[3];
+	for (int c = 0; c < NCATCH; c++) {
+		st[c].q.Quantiles (q, 3, p);
+		e.vp50[c] = p[0], e.vp95[c] = p[1], e.vp99[c] = p[2];
+	}
+	return e;
+}
+
+// read the header of a catalog; false if it is not one this code reads
+static bool ReadHeader (FILE *f, CatalogHeader &h)
+{
+	return fread (&h, sizeof(h), 1, f) == 1 && !memcmp (h.magic, "FDCT", 4) &&
+		((h.version == CATALOG_VERSION && h.recsize == sizeof(CatalogEntry)) ||
+		 (h.version == 1 && h.recsize == CATALOG_V1_RECSIZE));
+}
+
+static bool WriteHeader (FILE *f)
+{
+	CatalogHeader h;
+	memcpy (h.magic, "FDCT", 4);
+	h.version = CATALOG_VERSION;
+	h.recsize = sizeof(CatalogEntry);
+	h.reserved = 0;
+	return fwrite (&h, sizeof(h), 1, f) == 1;
+}
+
+// rewrite a catalog of an earlier version in the current one, through a
+// temporary file, so a crash leaves either catalog complete
+static bool UpgradeCatalog (const char *catpath)
+{
+	std::vector<CatalogEntry> e;
+	if (!LoadCatalog (catpath, e)) return false;
+	std::string tmp = std::string (catpath) + ".tmp";
+	FILE *f = fopen (tmp.c_str(), "wb");
+	if (!f) return false;
+	bool ok = WriteHeader (f) && (e.empty() || fwrite (e.data(), sizeof(CatalogEntry), e.size(), f) == e.size());
+	if (fclose (f)) ok = false;
+	if (ok) {
+		remove (catpath);
+		ok = rename (tmp.c_str(), catpath) == 0;
+	}
+	if (!ok) remove (tmp.c_str());
+	return ok;
+}
+
+bool AppendCatalog (const char *catpath, const CatalogEntry &e)
+{
+	CatalogHeader h;
+	FILE *f = fopen (catpath, "rb");
+	if (f) {
+		bool old = ReadHeader (f, h) && h.version != CATALOG_VERSION;
+		fclose (f);
+		if (old && !UpgradeCatalog (catpath)) return false;
+	}
+	f = fopen (catpath, "ab");
+	if (!f) return false;
+	bool ok = true;
+	fseek (f, 0, SEEK_END);
+	long size = ftell (f);
+	if (size == 0) {
+		ok = WriteHeader (f);
+	} else {
+		// realign after a record torn by a crash during an earlier append
+		long tail = (size - (long)sizeof(CatalogHeader)) % (long)sizeof(CatalogEntry);
+		for (; ok && tail > 0 && tail < (long)sizeof(CatalogEntry); tail++)
+			ok = fputc (0, f) != EOF;
+	}
+	if (ok) ok = fwrite (&e, sizeof(e), 1, f) == 1;
+	return (fclose (f) == 0) && ok;
+}
+
+bool LoadCatalog (const char *catpath, std::vector<CatalogEntry> &e)
+{
+	CatalogHeader h;
+	e.clear();
+	FILE *f = fopen (catpath, "rb");
+	if (!f) return false;
+	if (!ReadHeader (f, h)) {
+		fclose (f);
+		return false;
+	}
+	fseek (f, 0, SEEK_END);
+	long n = (ftell (f) - (long)sizeof(h)) / (long)h.recsize;
+	fseek (f, sizeof(h), SEEK_SET);
+	// a record torn by a crash during an append is ignored, or reads
+	// without samples once realigned by AppendCatalog
+	e.resize (n > 0 ? n : 0);
+	size_t got = 0, i, k;
+	if (n > 0 && h.recsize == sizeof(CatalogEntry))
+		got = fread (e.data(), sizeof(CatalogEntry), n, f);
+	else if (n > 0) {
+		memset ((void*)e.data(), 0, n*sizeof(CatalogEntry));
+		for (; (long)got < n && fread (&e[got], h.recsize, 1, f) == 1; got++);
+	}
+	for (i = k = 0; i < got; i++)
+		if (e[i].samples > 0) e[k++] = e[i];
+	e.resize (k);
+	fclose (f);
+	return true;
+}
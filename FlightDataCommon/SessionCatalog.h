@@ -0,0 +1,90 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// SessionCatalog.h
+// Catalog of recorded sessions kept in the log directory.
+// ==============================================================
+
+#ifndef __SESSIONCATALOG_H
+#define __SESSIONCATALOG_H
+
+#include <cstddef>
+#include <vector>
+#include "RunningStats.h"
+
+#define CATALOG_NAME "catalog.fdc"
+
+// channels with summary figures in the catalog
+enum {
+	CAT_ALT,       // altitude (km)
+	CAT_V_RAD,     // radial velocity (m/s)
+	CAT_V_TAN,     // tangential velocity (m/s)
+	CAT_A_G,       // net acceleration (G)
+	CAT_DYNP,      // dynamic pressure (Pa)
+	CAT_MACH,      // Mach number
+	CAT_FUEL,      // fuel mass (kg)
+	CAT_DIST,      // range to target base (km)
+	NCATCH
+};
+
+extern const char *catchname[NCATCH];
+
+// One recorded session: the samples written to one log file between the
+// start of acquisition and its end (pause, file change or exit). Fixed
+// size, so the catalog can be loaded and filtered without parsing.
+struct CatalogEntry {
+	char vessel[32];
+	char tgt_base[32];
+	char path[192];            // log file
+	double t_start, t_end;     // sim time of the first/last sample (s)
+	double mjd_start, mjd_end;
+	long long samples;
+	float vmin[NCATCH], vmax[NCATCH], vlast[NCATCH];
+	float vmean[NCATCH], vsd[NCATCH];              // since version 2
+	float vp50[NCATCH], vp95[NCATCH], vp99[NCATCH];
+};
+
+// size of a version 1 record, which ends with vlast
+#define CATALOG_V1_RECSIZE (offsetof(CatalogEntry, vmean))
+
+// catalog file: header, then CatalogEntry records, native byte order
+struct CatalogHeader {
+	char magic[4];             // "FDCT"
+	unsigned version;          // CATALOG_VERSION
+	unsigned recsize;          // sizeof(CatalogEntry)
+	unsigned reserved;
+};
+
+const unsigned CATALOG_VERSION = 2;
+
+// Accumulates the catalog entry of the session in progress, with the
+// moments and a quantile sketch of each channel; bounded in memory
+// however long the session runs.
+class SessionStats {
+public:
+	SessionStats ();
+	void Start (const char *vessel, const char *tgt_base, const char *path);
+	void Add (double simt, double mjd, const float *v);   // v[NCATCH]
+	bool Active () const { return active; }
+	const char *Path () const { return e.path; }
+	const CatalogEntry &Entry () const { return e; }
+	const CatalogEntry &Summary ();                       // Entry() with the quantiles filled in
+	const ChannelStats &Stats (int c) const { return st[c]; }
+	void Stop () { active = false; }
+
+private:
+	CatalogEntry e;
+	ChannelStats st[NCATCH];
+	bool active;
+};
+
+// append an entry, writing the header first if the catalog is new; a
+// catalog of an earlier version is rewritten in the current one first
+bool AppendCatalog (const char *catpath, const CatalogEntry &e);
+
+// all entries of a catalog, of any version; the figures a version does
+// not hold read as 0. false if missing or not a catalog
+bool LoadCatalog (const char *catpath, std::vector<CatalogEntry> &e);
+
+#endif // !__SESSIONCATALOG_H
@@ -0,0 +1,42 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// Surface.h
+// Abstract 2D drawing surface for the data graphs.
+// ==============================================================
+
+#ifndef __SURFACE_H
+#define __SURFACE_H
+
+typedef unsigned int SurfColor;  // 0x00bbggrr, same layout as a GDI COLORREF
+
+struct SurfPoint {
+	int x, y;
+};
+
+// text alignment relative to the reference point
+enum { TXT_LEFT, TXT_CENTER, TXT_RIGHT };
+
+// Drawing interface the graphs render through. Coordinates are pixels
+// relative to the origin set with SetOrigin, y pointing down. Lines are one
+// pixel wide; text uses a small fixed font, with (x,y) at the top of the
+// text, or at its left edge for vertical text reading bottom to top.
+class Surface {
+public:
+	virtual ~Surface () {}
+	virtual int  Width () const = 0;
+	virtual int  Height () const = 0;
+	virtual void SetOrigin (int x, int y) = 0;
+	virtual void Fill (int x, int y, int w, int h, SurfColor col) = 0;
+	virtual void Line (int x0, int y0, int x1, int y1, SurfColor col) = 0;
+	virtual void Polyline (const SurfPoint *pt, int n, SurfColor col) = 0;
+	virtual void Text (int x, int y, const char *str, SurfColor col, int align, bool vertical = false) = 0;
+
+	// off-screen surface of the same kind, for caching static content
+	virtual Surface *CreateLayer (int w, int h) = 0;
+	// copy a surface obtained from CreateLayer to (x,y)
+	virtual void Blit (Surface *layer, int x, int y) = 0;
+};
+
+#endif // !__SURFACE_H
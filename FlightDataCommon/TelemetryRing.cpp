@@ -0,0 +1,362 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// TelemetryRing.cpp
+// Live samples published in a named shared-memory ring.
+// ==============================================================
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <string>
+#include "TelemetryRing.h"
+
+#define LINE 64    // slots and the slot area are aligned to cache lines
+
+// ==============================================================
+// A named shared-memory object or a mapped file, as the writer or a reader
+
+class SharedRegion {
+public:
+	SharedRegion (): base(0), size(0)
+	{
+#ifdef _WIN32
+		hfile = hmap = 0;
+#endif
+	}
+	~SharedRegion () { Close(); }
+	bool Open (const char *_name, size_t _size, bool write);
+	void Close ();
+	char *Base () const { return base; }
+	size_t Size () const { return size; }
+	const char *Name () const { return name.c_str(); }
+
+private:
+	std::string name;
+	char *base;
+	size_t size;     // mapped bytes; for a reader 0 until known
+#ifdef _WIN32
+	HANDLE hfile, hmap;
+#endif
+};
+
+static bool IsPath (const char *name)
+{
+	return strchr (name, '/') || strchr (name, '\\');
+}
+
+#ifdef _WIN32
+
+bool SharedRegion::Open (const char *_name, size_t _size, bool write)
+{
+	Close();
+	name = _name;
+	DWORD prot = (write ? PAGE_READWRITE : PAGE_READONLY);
+	DWORD acc = (write ? FILE_MAP_WRITE : FILE_MAP_READ);
+	if (IsPath (_name)) {
+		hfile = CreateFileA (_name, write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+			FILE_SHARE_READ | FILE_SHARE_WRITE, 0, write ? OPEN_ALWAYS : OPEN_EXISTING,
+			FILE_ATTRIBUTE_TEMPORARY, 0);
+		if (hfile == INVALID_HANDLE_VALUE) { hfile = 0; return false; }
+		// a writer never shrinks the file: readers may still map all of it
+		LARGE_INTEGER sz;
+		if (!GetFileSizeEx (hfile, &sz)) { Close(); return false; }
+		if (write && (size_t)sz.QuadPart < _size) {
+			sz.QuadPart = (LONGLONG)_size;
+			if (!SetFilePointerEx (hfile, sz, 0, FILE_BEGIN) || !SetEndOfFile (hfile)) { Close(); return false; }
+		}
+		_size = (size_t)sz.QuadPart;
+		if (!_size) { Close(); return false; }
+		hmap = CreateFileMappingA (hfile, 0, prot, 0, 0, 0);
+	} else {
+		std::string obj = std::string ("Local\\") + _name;
+		if (write) hmap = CreateFileMappingA (INVALID_HANDLE_VALUE, 0, PAGE_READWRITE,
+			(DWORD)((unsigned long long)_size >> 32), (DWORD)_size, obj.c_str());
+		else hmap = OpenFileMappingA (FILE_MAP_READ, FALSE, obj.c_str());
+	}
+	if (!hmap || !(base = (char*)MapViewOfFile (hmap, acc, 0, 0, 0))) {
+		Close();
+		return false;
+	}
+	if (!_size) {
+		MEMORY_BASIC_INFORMATION mi;
+		VirtualQuery (base, &mi, sizeof(mi));
+		_size = mi.RegionSize;
+	}
+	size = _size;
+	return true;
+}
+
+void SharedRegion::Close ()
+{
+	if (base) UnmapViewOfFile (base);
+	if (hmap) CloseHandle (hmap);
+	if (hfile) CloseHandle (hfile);
+	base = 0, hmap = hfile = 0;
+	size = 0;
+}
+
+#else
+
+bool SharedRegion::Open (const char *_name, size_t _size, bool write)
+{
+	Close();
+	name = _name;
+	int fd;
+	if (IsPath (_name)) fd = open (_name, write ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+	else fd = shm_open ((std::string ("/") + _name).c_str(), write ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+	if (fd < 0) return false;
+	// a writer never shrinks the region: readers may still map all of it
+	struct stat st;
+	bool ok = (fstat (fd, &st) == 0);
+	if (ok && write && (size_t)st.st_size < _size) ok = (ftruncate (fd, (off_t)_size) == 0);
+	else if (ok) _size = (size_t)st.st_size;
+	if (!ok || !_size) {
+		close (fd);
+		return false;
+	}
+	void *p = mmap (0, _size, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);
+	if (p == MAP_FAILED) return false;
+	base = (char*)p;
+	size = _size;
+	return true;
+}
+
+void SharedRegion::Close ()
+{
+	if (base) munmap (base, size);
+	base = 0;
+	size = 0;
+}
+
+#endif
+
+// ==============================================================
+// Writer
+
+TelemetryWriter::TelemetryWriter ()
+{
+	rgn = new SharedRegion;
+	hdr = 0;
+	slot = 0;
+	mask = size = nchan = 0;
+}
+
+TelemetryWriter::~TelemetryWriter ()
+{
+	Close();
+	delete rgn;
+}
+
+static unsigned Align (unsigned n)
+{
+	return (n + LINE-1) / LINE * LINE;
+}
+
+bool TelemetryWriter::Create (const char *name, const TelemetryChannel *chan, int _nchan, int slots)
+{
+	Close();
+	if (_nchan < 1 || _nchan > TELEMETRY_MAXCHAN || slots < 2) return false;
+	unsigned n = 2;
+	while (n < (unsigned)slots) n <<= 1;
+	unsigned hsize = Align (sizeof(TelemetryHeader) + _nchan*sizeof(TelemetryChannel));
+	unsigned ssize = Align (sizeof(TelemetrySlot) + _nchan*sizeof(float));
+	if (!rgn->Open (name, (size_t)hsize + (size_t)n*ssize, true)) return false;
+
+	// the region may still hold the ring of an earlier writer: take the
+	// magic away while the schema changes, and start a new epoch
+	TelemetryHeader *h = (TelemetryHeader*)rgn->Base();
+	unsigned epoch = (!memcmp (h->magic, TELEMETRY_MAGIC, 4) ? h->epoch+1 : 1);
+	memset (h->magic, 0, 4);
+	std::atomic_thread_fence (std::memory_order_release);
+	h->version = TELEMETRY_VERSION;
+	h->header_size = hsize;
+	h->slot_size = ssize;
+	h->slots = n;
+	h->nchan = _nchan;
+	h->epoch = epoch;
+	h->head.store (0, std::memory_order_relaxed);
+	memcpy ((void*)(h+1), chan, _nchan*sizeof(TelemetryChannel));
+	slot = rgn->Base() + hsize;
+	for (unsigned k = 0; k < n; k++)
+		((TelemetrySlot*)(slot + (size_t)k*ssize))->seq.store (0, std::memory_order_relaxed);
+	h->flags.store (TELEMETRY_ALIVE, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_release);
+	memcpy (h->magic, TELEMETRY_MAGIC, 4);
+
+	hdr = h;
+	mask = n-1;
+	size = ssize;
+	nchan = _nchan;
+	return true;
+}
+
+void TelemetryWriter::Close ()
+{
+	// the last samples stay readable; readers see the writer has gone
+	if (hdr) hdr->flags.store (0, std::memory_order_release);
+	hdr = 0;
+	slot = 0;
+	rgn->Close();
+}
+
+bool TelemetryWriter::Remove (const char *name)
+{
+#ifdef _WIN32
+	// a named object goes with its last handle
+	return IsPath (name) ? DeleteFileA (name) != 0 : true;
+#else
+	return (IsPath (name) ? unlink (name) : shm_unlink ((std::string ("/") + name).c_str())) == 0;
+#endif
+}
+
+const char *TelemetryWriter::Name () const
+{
+	return rgn->Name();
+}
+
+void TelemetryWriter::Publish (double simt, const float *v)
+{
+	if (!hdr) return;
+	unsigned long long n = hdr->head.load (std::memory_order_relaxed);
+	TelemetrySlot *s = (TelemetrySlot*)(slot + (size_t)(n & mask)*size);
+	s->seq.store (2*n+1, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_release);
+	s->simt = simt;
+	memcpy ((void*)(s+1), v, nchan*sizeof(float));
+	s->seq.store (2*n+2, std::memory_order_release);
+	hdr->head.store (n+1, std::memory_order_release);
+}
+
+unsigned long long TelemetryWriter::Published () const
+{
+	return hdr ? hdr->head.load (std::memory_order_relaxed) : 0;
+}
+
+// ==============================================================
+// Reader
+
+TelemetryReader::TelemetryReader ()
+{
+	rgn = new SharedRegion;
+	hdr = 0;
+	chan = 0;
+	slot = 0;
+	mask = size = nchan = epoch = 0;
+	cursor = lost = 0;
+}
+
+TelemetryReader::~TelemetryReader ()
+{
+	Close();
+	delete rgn;
+}
+
+bool TelemetryReader::Open (const char *name)
+{
+	Close();
+	if (!rgn->Open (name, 0, false)) return false;
+	const TelemetryHeader *h = (const TelemetryHeader*)rgn->Base();
+	size_t rsize = rgn->Size();
+	if (rsize < sizeof(TelemetryHeader) || memcmp (h->magic, TELEMETRY_MAGIC, 4)) { Close(); return false; }
+	std::atomic_thread_fence (std::memory_order_acquire);
+	if (h->version != TELEMETRY_VERSION || !h->nchan || h->nchan > TELEMETRY_MAXCHAN
+		|| h->slots < 2 || (h->slots & (h->slots-1))
+		|| h->header_size < sizeof(TelemetryHeader) + h->nchan*sizeof(TelemetryChannel)
+		|| h->slot_size < sizeof(TelemetrySlot) + h->nchan*sizeof(float)
+		|| rsize < (size_t)h->header_size + (size_t)h->slots*h->slot_size) {
+		Close();
+		return false;
+	}
+	hdr = h;
+	chan = (const TelemetryChannel*)(h+1);
+	slot = rgn->Base() + h->header_size;
+	mask = h->slots-1;
+	size = h->slot_size;
+	nchan = h->nchan;
+	epoch = h->epoch;
+	cursor = h->head.load (std::memory_order_acquire);
+	lost = 0;
+	return true;
+}
+
+void TelemetryReader::Close ()
+{
+	hdr = 0;
+	chan = 0;
+	slot = 0;
+	rgn->Close();
+}
+
+int TelemetryReader::FindChannel (const char *name) const
+{
+	for (int c = 0; c < Channels(); c++)
+		if (!strncmp (chan[c].name, name, TELEMETRY_NAMELEN)) return c;
+	return -1;
+}
+
+bool TelemetryReader::WriterAlive () const
+{
+	return hdr && (hdr->flags.load (std::memory_order_acquire) & TELEMETRY_ALIVE);
+}
+
+unsigned long long TelemetryReader::Head () const
+{
+	return hdr ? hdr->head.load (std::memory_order_acquire) : 0;
+}
+
+void TelemetryReader::SeekLatest (unsigned back)
+{
+	unsigned long long h = Head();
+	if (back > mask) back = mask;
+	cursor = (h > back ? h-back : 0);
+}
+
+bool TelemetryReader::Next (double &simt, float *v)
+{
+	if (!hdr) return false;
+	for (;;) {
+		unsigned long long h = hdr->head.load (std::memory_order_acquire);
+		if (hdr->epoch != epoch) {
+			// a new writer set the ring up again: follow it from its first
+			// sample, or let the caller open it again if the layout changed
+			if (memcmp (hdr->magic, TELEMETRY_MAGIC, 4)) return false;
+			std::atomic_thread_fence (std::memory_order_acquire);
+			if (hdr->slots != mask+1 || hdr->slot_size != size || hdr->nchan != nchan
+				|| (const char*)hdr + hdr->header_size != slot) {
+				Close();
+				return false;
+			}
+			epoch = hdr->epoch;
+			cursor = 0;
+			continue;
+		}
+		if (cursor >= h) return false;
+		if (h - cursor > mask+1) {
+			lost += h - (mask+1) - cursor;
+			cursor = h - (mask+1);
+		}
+		const TelemetrySlot *s = (const TelemetrySlot*)(slot + (size_t)(cursor & mask)*size);
+		unsigned long long want = 2*cursor+2;
+		if (s->seq.load (std::memory_order_acquire) == want) {
+			simt = s->simt;
+			memcpy (v, s+1, nchan*sizeof(float));
+			std::atomic_thread_fence (std::memory_order_acquire);
+			if (s->seq.load (std::memory_order_relaxed) == want) {
+				cursor++;
+				return true;
+			}
+		}
+		// overwritten by a later sample while we were behind
+		lost++;
+		cursor++;
+	}
+}
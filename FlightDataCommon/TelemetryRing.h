@@ -0,0 +1,120 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// TelemetryRing.h
+// Live samples published in a named shared-memory ring.
+// ==============================================================
+
+#ifndef __TELEMETRYRING_H
+#define __TELEMETRYRING_H
+
+#include <atomic>
+
+// Shared layout, native byte order:
+//
+//   TelemetryHeader, TelemetryChannel[nchan]    padded to header_size
+//   slot[slots]                                 slot_size bytes each
+//
+// A slot holds a TelemetrySlot followed by nchan floats. The writer
+// fills the header last, so a reader that finds the magic sees the
+// complete schema.
+//
+// There is one writer and any number of readers, which never write to
+// the region. Samples are numbered from 0; sample n goes to slot
+// n % slots. The slot sequence is 2n+1 while the writer stores sample
+// n and 2n+2 once it is complete. A reader keeps its own cursor: it
+// copies the slot and checks that the sequence was 2n+2 before and
+// after the copy. A reader that was overtaken skips ahead and counts
+// the lost samples; the writer never waits for anyone.
+
+#define TELEMETRY_MAGIC   "FDTR"
+#define TELEMETRY_NAMELEN 16
+#define TELEMETRY_UNITLEN 8
+#define TELEMETRY_MAXCHAN 64
+
+const unsigned TELEMETRY_VERSION = 1;
+
+enum { TELEMETRY_ALIVE = 1 };   // header flags: writer attached
+
+struct TelemetryChannel {
+	char name[TELEMETRY_NAMELEN];   // log column name (Column_list.txt)
+	char unit[TELEMETRY_UNITLEN];
+};
+
+struct TelemetryHeader {
+	char magic[4];                  // "FDTR"
+	unsigned version;               // TELEMETRY_VERSION
+	unsigned header_size;           // offset of slot 0
+	unsigned slot_size;
+	unsigned slots;                 // power of 2
+	unsigned nchan;
+	unsigned epoch;                 // bumped whenever a writer sets up the ring
+	std::atomic<unsigned> flags;    // TELEMETRY_*
+	std::atomic<unsigned long long> head;   // samples published
+};
+
+struct TelemetrySlot {
+	std::atomic<unsigned long long> seq;
+	double simt;                    // sim time (s)
+	// float v[nchan] follows
+};
+
+class SharedRegion;
+
+class TelemetryWriter {
+public:
+	TelemetryWriter ();
+	~TelemetryWriter ();
+	// A name without path separators is a named shared-memory object;
+	// otherwise it is a file that is mapped, e.g. one on /dev/shm, which
+	// also reaches Linux readers of a simulator running under Wine.
+	bool Create (const char *name, const TelemetryChannel *chan, int nchan, int slots);
+	void Close ();
+	static bool Remove (const char *name);        // delete a closed ring
+	bool Active () const { return hdr != 0; }
+	const char *Name () const;
+	void Publish (double simt, const float *v);   // v[nchan]; wait-free
+	unsigned long long Published () const;
+
+private:
+	SharedRegion *rgn;
+	TelemetryHeader *hdr;
+	char *slot;
+	unsigned mask, size, nchan;
+};
+
+class TelemetryReader {
+public:
+	TelemetryReader ();
+	~TelemetryReader ();
+	bool Open (const char *name);
+	void Close ();
+	bool Active () const { return hdr != 0; }     // false once closed by Next()
+	int  Channels () const { return (int)nchan; }
+	const TelemetryChannel &Channel (int c) const { return chan[c]; }
+	int  FindChannel (const char *name) const;    // -1 if not published
+	unsigned Slots () const { return hdr ? hdr->slots : 0; }
+	unsigned Epoch () const { return epoch; }
+	bool WriterAlive () const;
+	unsigned long long Head () const;
+
+	// continue with the newest 'back' samples
+	void SeekLatest (unsigned back);
+	// copy the next sample into simt and v[Channels()]; false if there
+	// is none yet. A restarted writer is followed from its first sample;
+	// if it changed the layout the reader closes and must be opened again.
+	bool Next (double &simt, float *v);
+	unsigned long long Cursor () const { return cursor; }
+	unsigned long long Lost () const { return lost; }
+
+private:
+	SharedRegion *rgn;
+	const TelemetryHeader *hdr;
+	const TelemetryChannel *chan;
+	const char *slot;
+	unsigned mask, size, nchan, epoch;
+	unsigned long long cursor, lost;
+};
+
+#endif // !__TELEMETRYRING_H
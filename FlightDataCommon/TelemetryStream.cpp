@@ -0,0 +1,419 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// TelemetryStream.cpp
+// Live samples streamed to network clients in batched frames.
+// ==============================================================
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET sock_t;
+#define closesock closesocket
+static bool WouldBlock () { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static void NonBlocking (sock_t s) { unsigned long on = 1; ioctlsocket (s, FIONBIO, &on); }
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int sock_t;
+#define INVALID_SOCKET (-1)
+#define closesock close
+static bool WouldBlock () { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+static void NonBlocking (sock_t s) { fcntl (s, F_SETFL, fcntl (s, F_GETFL) | O_NONBLOCK); }
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include "TelemetryStream.h"
+
+#define SCHEMA_EVERY 50     // UDP: frames between schema frames
+#define UDP_MAXFRAME 60000  // bytes
+#define TEXT_FIELD   16     // bytes reserved per text field
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+struct TelemetryStream::Frame {
+	std::vector<char> buf;   // header and payload; capacity fixed at Start
+	size_t len;
+	unsigned nsample;
+	int refs;                // client queues holding the frame (network thread)
+};
+
+struct TelemetryStream::Client {
+	sock_t s;
+	std::vector<char> pre;   // schema still to send first
+	size_t preofs;
+	std::deque<Frame*> q;
+	size_t ofs;              // bytes of q.front() sent
+	unsigned sent;           // frames sent (UDP: for the schema interval)
+};
+
+TelemetryStream::TelemetryStream ()
+	: run (false), full_head (0), full_tail (0), free_head (0), free_tail (0),
+	  st_samples (0), st_frames (0), st_hdrops (0), st_cdrops (0), st_bytes (0), st_clients (0)
+{
+	pool = 0;
+	cur = 0;
+	lsock = (long long)INVALID_SOCKET;
+	text = udp = false;
+	batch = queue = 1;
+	nframe = 0;
+}
+
+TelemetryStream::~TelemetryStream ()
+{
+	Stop();
+}
+
+bool TelemetryStream::Start (const char *_spec, const TelemetryChannel *_chan, int nchan, bool _text,
+	int _batch, double flush_ms, int _queue)
+{
+	Stop();
+	if (nchan < 1) return false;
+	spec = _spec;
+	chan.assign (_chan, _chan+nchan);
+	text = _text;
+	batch = (_batch < 1 ? 1 : _batch);
+	queue = (_queue < 1 ? 1 : _queue > NFRAME/2 ? NFRAME/2 : _queue);
+	flush = std::chrono::duration_cast<std::chrono::steady_clock::duration> (
+		std::chrono::duration<double, std::milli> (flush_ms > 0.0 ? flush_ms : 0.0));
+
+	size_t rec = (text ? (nchan+1)*TEXT_FIELD + 1 : sizeof(double) + nchan*sizeof(float));
+	size_t cap = sizeof(StreamFrameHeader) + batch*rec;
+
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup (MAKEWORD(2,2), &wsa)) return false;
+#endif
+	sock_t s = INVALID_SOCKET;
+	if (!strncmp (_spec, "tcp:", 4)) {
+		udp = false;
+		sockaddr_in a;
+		memset (&a, 0, sizeof(a));
+		a.sin_family = AF_INET;
+		a.sin_addr.s_addr = htonl (INADDR_ANY);
+		a.sin_port = htons ((unsigned short)atoi (_spec+4));
+		int on = 1;
+		if ((s = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET) return false;
+		setsockopt (s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+		if (bind (s, (sockaddr*)&a, sizeof(a)) || listen (s, 8)) { closesock (s); return false; }
+	} else if (!strncmp (_spec, "udp:", 4)) {
+		udp = true;
+		std::string host (_spec+4);
+		size_t colon = host.rfind (':');
+		if (colon == std::string::npos) return false;
+		std::string port = host.substr (colon+1);
+		host.erase (colon);
+		addrinfo hint, *ai = 0;
+		memset (&hint, 0, sizeof(hint));
+		hint.ai_family = AF_INET;
+		hint.ai_socktype = SOCK_DGRAM;
+		if (getaddrinfo (host.c_str(), port.c_str(), &hint, &ai) || !ai) return false;
+		udpaddr.assign ((char*)ai->ai_addr, (char*)ai->ai_addr + ai->ai_addrlen);
+		freeaddrinfo (ai);
+		if ((s = socket (AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == INVALID_SOCKET) return false;
+		if (cap > UDP_MAXFRAME) {
+			batch = (int)((UDP_MAXFRAME - sizeof(StreamFrameHeader)) / rec);
+			if (batch < 1) { closesock (s); return false; }
+			cap = sizeof(StreamFrameHeader) + batch*rec;
+		}
+	} else return false;
+	NonBlocking (s);
+	lsock = (long long)s;
+
+	pool = new Frame[NFRAME];
+	for (int k = 0; k < NFRAME; k++) {
+		pool[k].buf.resize (cap);
+		pool[k].len = 0;
+		pool[k].nsample = 0;
+		pool[k].refs = 0;
+		freeq[k] = &pool[k];
+	}
+	full_head = full_tail = 0;
+	free_head = 0;
+	free_tail = NFRAME;
+	cur = 0;
+	nframe = 0;
+	st_samples = st_frames = st_hdrops = st_cdrops = st_bytes = 0;
+	st_clients = 0;
+	run.store (true);
+	worker = std::thread (&TelemetryStream::Worker, this);
+	return true;
+}
+
+void TelemetryStream::Stop ()
+{
+	if (!run.load()) return;
+	run.store (false);
+	worker.join();
+	closesock ((sock_t)lsock);
+	lsock = (long long)INVALID_SOCKET;
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	delete []pool;
+	pool = 0;
+	cur = 0;
+	st_clients = 0;
+}
+
+// ==============================================================
+// Sampler side
+
+TelemetryStream::Frame *TelemetryStream::NewFrame ()
+{
+	unsigned h = free_head.load (std::memory_order_relaxed);
+	if (h == free_tail.load (std::memory_order_acquire)) return 0;
+	Frame *f = freeq[h % NFRAME];
+	free_head.store (h+1, std::memory_order_release);
+	StreamFrameHeader *fh = (StreamFrameHeader*)f->buf.data();
+	f->len = (text ? 0 : sizeof(StreamFrameHeader));
+	f->nsample = 0;
+	if (!text) {
+		memcpy (fh->magic, STREAM_MAGIC, 4);
+		fh->version = STREAM_VERSION;
+		fh->type = SF_SAMPLES;
+		fh->nchan = (unsigned)chan.size();
+		fh->first = st_samples.load (std::memory_order_relaxed);
+	}
+	return f;
+}
+
+void TelemetryStream::Encode (Frame *f, double simt, const float *v)
+{
+	char *p = f->buf.data() + f->len;
+	size_t n = chan.size();
+	if (text) {
+		char *end = f->buf.data() + f->buf.size();
+		p += snprintf (p, end-p, "%.10g", simt);
+		for (size_t c = 0; c < n; c++) p += snprintf (p, end-p, " %.7g", v[c]);
+		*p++ = '\n';
+	} else {
+		memcpy (p, &simt, sizeof(double));
+		memcpy (p + sizeof(double), v, n*sizeof(float));
+		p += sizeof(double) + n*sizeof(float);
+	}
+	f->len = p - f->buf.data();
+	f->nsample++;
+}
+
+void TelemetryStream::Seal ()
+{
+	if (!cur || !cur->nsample) return;
+	if (!text) {
+		StreamFrameHeader *fh = (StreamFrameHeader*)cur->buf.data();
+		fh->size = (unsigned)(cur->len - sizeof(StreamFrameHeader));
+		fh->seq = nframe;
+		fh->nsample = cur->nsample;
+	}
+	nframe++;
+	// every frame is either free, being filled, or in one of the queues,
+	// so 'full' always has room
+	unsigned t = full_tail.load (std::memory_order_relaxed);
+	fullq[t % NFRAME] = cur;
+	full_tail.store (t+1, std::memory_order_release);
+	st_frames.fetch_add (1, std::memory_order_relaxed);
+	cur = 0;
+}
+
+void TelemetryStream::Push (double simt, const float *v)
+{
+	if (!run.load (std::memory_order_relaxed)) return;
+	if (!cur) {
+		if (!(cur = NewFrame())) {
+			st_samples.fetch_add (1, std::memory_order_relaxed);
+			st_hdrops.fetch_add (1, std::memory_order_relaxed);
+			return;
+		}
+		cur_t0 = std::chrono::steady_clock::now();
+	}
+	Encode (cur, simt, v);
+	st_samples.fetch_add (1, std::memory_order_relaxed);
+	if ((int)cur->nsample >= batch) Seal();
+	else Poll();
+}
+
+void TelemetryStream::Poll ()
+{
+	if (cur && cur->nsample && std::chrono::steady_clock::now() - cur_t0 >= flush) Seal();
+}
+
+void TelemetryStream::GetStats (StreamStats &s) const
+{
+	s.samples = st_samples.load (std::memory_order_relaxed);
+	s.frames = st_frames.load (std::memory_order_relaxed);
+	s.handoff_drops = st_hdrops.load (std::memory_order_relaxed);
+	s.client_drops = st_cdrops.load (std::memory_order_relaxed);
+	s.bytes = st_bytes.load (std::memory_order_relaxed);
+	s.clients = st_clients.load (std::memory_order_relaxed);
+}
+
+// ==============================================================
+// Network side
+
+void TelemetryStream::SchemaFrame (std::vector<char> &buf) const
+{
+	size_t n = chan.size();
+	if (text) {
+		std::string s ("# sim_time");
+		for (size_t c = 0; c < n; c++) s += std::string (" ") + chan[c].name;
+		s += '\n';
+		buf.assign (s.begin(), s.end());
+		return;
+	}
+	buf.resize (sizeof(StreamFrameHeader) + n*sizeof(TelemetryChannel));
+	StreamFrameHeader fh;
+	memset (&fh, 0, sizeof(fh));
+	memcpy (fh.magic, STREAM_MAGIC, 4);
+	fh.version = STREAM_VERSION;
+	fh.type = SF_SCHEMA;
+	fh.size = (unsigned)(n*sizeof(TelemetryChannel));
+	fh.nchan = (unsigned)n;
+	memcpy (buf.data(), &fh, sizeof(fh));
+	memcpy (buf.data() + sizeof(fh), chan.data(), n*sizeof(TelemetryChannel));
+}
+
+void TelemetryStream::Worker ()
+{
+	std::vector<Client> cl;
+	sock_t ls = (sock_t)lsock;
+	char scratch[512];
+
+	auto release = [this](Frame *f) {
+		if (--f->refs > 0) return;
+		unsigned t = free_tail.load (std::memory_order_relaxed);
+		freeq[t % NFRAME] = f;
+		free_tail.store (t+1, std::memory_order_release);
+	};
+	auto drop = [&](size_t k) {
+		closesock (cl[k].s);
+		for (size_t j = 0; j < cl[k].q.size(); j++) release (cl[k].q[j]);
+		cl.erase (cl.begin()+k);
+	};
+
+	if (udp) {                     // one receiver, no connection
+		Client c;
+		c.s = ls;
+		c.preofs = c.ofs = 0;
+		c.sent = 0;
+		cl.push_back (c);
+	}
+
+	while (run.load (std::memory_order_relaxed)) {
+		fd_set rd, wr;
+		FD_ZERO (&rd);
+		FD_ZERO (&wr);
+		sock_t maxs = ls;
+		if (!udp) FD_SET (ls, &rd);
+		for (size_t k = 0; k < cl.size(); k++) {
+			if (!udp) FD_SET (cl[k].s, &rd);
+			if (!cl[k].q.empty() || cl[k].preofs < cl[k].pre.size()) FD_SET (cl[k].s, &wr);
+			if (cl[k].s > maxs) maxs = cl[k].s;
+		}
+		timeval tv;
+		tv.tv_sec = 0;
+		tv.tv_usec = 5000;
+		select ((int)maxs+1, &rd, &wr, 0, &tv);
+
+		// new clients start with the schema and the next frame
+		if (!udp && FD_ISSET (ls, &rd)) {
+			sock_t s;
+			while ((s = accept (ls, 0, 0)) != INVALID_SOCKET) {
+				int on = 1;
+				NonBlocking (s);
+				setsockopt (s, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+				Client c;
+				c.s = s;
+				SchemaFrame (c.pre);
+				c.preofs = c.ofs = 0;
+				c.sent = 0;
+				cl.push_back (c);
+			}
+		}
+		// clients only talk to close the connection
+		if (!udp)
+			for (size_t k = cl.size(); k-- > 0; )
+				if (FD_ISSET (cl[k].s, &rd)) {
+					int n = recv (cl[k].s, scratch, sizeof(scratch), 0);
+					if (n == 0 || (n < 0 && !WouldBlock())) drop (k);
+				}
+
+		// hand out the sealed frames; a full client queue loses its
+		// oldest frame that is not being sent, or the new frame if the
+		// only one queued is half sent (a queue of one)
+		unsigned h = full_head.load (std::memory_order_relaxed);
+		unsigned t = full_tail.load (std::memory_order_acquire);
+		for (; h != t; h++) {
+			Frame *f = fullq[h % NFRAME];
+			f->refs = 1;                      // held while handing out
+			for (size_t k = 0; k < cl.size(); k++) {
+				Client &c = cl[k];
+				if ((int)c.q.size() >= queue) {
+					size_t j = (c.ofs ? 1 : 0);
+					st_cdrops.fetch_add (1, std::memory_order_relaxed);
+					if (j == c.q.size()) continue;
+					release (c.q[j]);
+					c.q.erase (c.q.begin()+j);
+				}
+				f->refs++;
+				c.q.push_back (f);
+			}
+			release (f);
+		}
+		full_head.store (h, std::memory_order_release);
+
+		// send until the sockets are full
+		for (size_t k = cl.size(); k-- > 0; ) {
+			Client &c = cl[k];
+			bool dead = false;
+			if (udp) {
+				while (!c.q.empty()) {
+					if (!text && c.sent % SCHEMA_EVERY == 0) {
+						SchemaFrame (c.pre);
+						sendto (c.s, c.pre.data(), (int)c.pre.size(), 0, (sockaddr*)udpaddr.data(), (int)udpaddr.size());
+					}
+					Frame *f = c.q.front();
+					int n = sendto (c.s, f->buf.data(), (int)f->len, 0, (sockaddr*)udpaddr.data(), (int)udpaddr.size());
+					if (n < 0 && WouldBlock()) break;
+					if (n > 0) st_bytes.fetch_add (n, std::memory_order_relaxed);
+					c.sent++;
+					c.q.pop_front();
+					release (f);
+				}
+				continue;
+			}
+			while (c.preofs < c.pre.size()) {
+				int n = send (c.s, c.pre.data() + c.preofs, (int)(c.pre.size()-c.preofs), MSG_NOSIGNAL);
+				if (n < 0) { dead = !WouldBlock(); break; }
+				c.preofs += n;
+				st_bytes.fetch_add (n, std::memory_order_relaxed);
+			}
+			while (!dead && c.preofs == c.pre.size() && !c.q.empty()) {
+				Frame *f = c.q.front();
+				int n = send (c.s, f->buf.data() + c.ofs, (int)(f->len - c.ofs), MSG_NOSIGNAL);
+				if (n < 0) { dead = !WouldBlock(); break; }
+				st_bytes.fetch_add (n, std::memory_order_relaxed);
+				if ((c.ofs += n) < f->len) break;
+				c.ofs = 0;
+				c.q.pop_front();
+				release (f);
+			}
+			if (dead) drop (k);
+		}
+		st_clients.store (udp ? 0 : (int)cl.size(), std::memory_order_relaxed);
+	}
+
+	for (size_t k = 0; k < cl.size(); k++)
+		if (cl[k].s != ls) closesock (cl[k].s);
+}
@@ -0,0 +1,106 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (common)
+//                  Part of the ORBITER SDK
+//
+// TelemetryStream.h
+// Live samples streamed to network clients in batched frames.
+// ==============================================================
+
+#ifndef __TELEMETRYSTREAM_H
+#define __TELEMETRYSTREAM_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TelemetryRing.h"
+
+// Binary frames, native (little-endian) byte order. A TCP client gets a
+// schema frame when it connects; a UDP receiver every SCHEMA_EVERY
+// frames. Text frames are lines of "sim_time v0 v1 ...", and a schema
+// line "# sim_time name ..." opens a TCP stream.
+
+#define STREAM_MAGIC "FDSF"
+const unsigned STREAM_VERSION = 1;
+
+enum { SF_SCHEMA = 1, SF_SAMPLES = 2 };
+
+struct StreamFrameHeader {
+	char magic[4];             // "FDSF"
+	unsigned short version;    // STREAM_VERSION
+	unsigned short type;       // SF_*
+	unsigned size;             // payload bytes after the header
+	unsigned seq;              // frame number
+	unsigned nchan;
+	unsigned nsample;          // SF_SAMPLES
+	unsigned long long first;  // number of the first sample
+};
+// SF_SCHEMA payload:  TelemetryChannel[nchan]
+// SF_SAMPLES payload: nsample x { double sim_time; float v[nchan]; }
+
+struct StreamStats {
+	unsigned long long samples;        // pushed by the sampler
+	unsigned long long frames;         // sealed and handed to the network
+	unsigned long long handoff_drops;  // samples dropped, no free frame (network thread behind)
+	unsigned long long client_drops;   // frames dropped from client queues
+	unsigned long long bytes;          // sent
+	int clients;
+};
+
+// Streams samples to TCP clients or to one UDP receiver. The sampler
+// thread calls Push() and Poll(): they batch samples into a frame and
+// hand full frames to a network thread through lock-free queues over a
+// fixed pool of frames, and drop samples rather than wait when no frame
+// is free. The network thread keeps a bounded queue per client and
+// drops the oldest frame when a client cannot keep up. Neither call
+// blocks or allocates.
+class TelemetryStream {
+public:
+	TelemetryStream ();
+	~TelemetryStream ();
+	// "tcp:PORT" (listen on all interfaces) or "udp:HOST:PORT"
+	bool Start (const char *spec, const TelemetryChannel *chan, int nchan, bool text,
+		int batch, double flush_ms, int queue);
+	void Stop ();
+	bool Active () const { return run.load (std::memory_order_relaxed); }
+	const char *Spec () const { return spec.c_str(); }
+
+	void Push (double simt, const float *v);   // sampler thread
+	void Poll ();                              // sampler thread: seal a frame that is due
+	void GetStats (StreamStats &s) const;
+
+private:
+	struct Frame;
+	struct Client;
+	Frame *NewFrame ();
+	void Seal ();
+	void Worker ();
+	void Encode (Frame *f, double simt, const float *v);
+	void SchemaFrame (std::vector<char> &buf) const;
+
+	std::string spec;
+	std::vector<TelemetryChannel> chan;
+	bool text, udp;
+	int batch, queue;
+	std::chrono::steady_clock::duration flush;
+	std::atomic<bool> run;
+	std::thread worker;
+	long long lsock;                  // listening or UDP socket
+	std::vector<char> udpaddr;        // UDP destination sockaddr
+
+	// frame pool: the sampler takes frames from 'free' and hands them on
+	// through 'full'; both are single-producer single-consumer rings
+	enum { NFRAME = 128 };
+	Frame *pool;
+	Frame *fullq[NFRAME], *freeq[NFRAME];
+	std::atomic<unsigned> full_head, full_tail, free_head, free_tail;
+	Frame *cur;                                  // frame being filled
+	std::chrono::steady_clock::time_point cur_t0;
+	unsigned nframe;                             // frames sealed
+
+	std::atomic<unsigned long long> st_samples, st_frames, st_hdrops, st_cdrops, st_bytes;
+	std::atomic<int> st_clients;
+};
+
+#endif // !__TELEMETRYSTREAM_H
@@ -21,6 +21,7 @@
 #include "..//..//include//Orbitersdk.h"
 #include "resource.h"
 #include "FDGraph.h"
+#include "GdiSurface.h"
 
 #define NGRAPH 22
 #define NRATE 4
@@ -46,6 +47,7 @@ VESSEL *g_VESSEL = 0;       // current reference vessel
 OBJHANDLE g_BASE = 0;       // current reference base 
 double g_T = 0.0;           // sample time
 bool g_bRecording;          // recorder on/off
+double g_PaintTime = 0.0;   // smoothed canvas paint time per frame (ms)
 
 double M = 0;
 double R = 0;
@@ -148,7 +150,7 @@ DLLCLBK void opcDLLInit (HINSTANCE hDLL)
 	wndClass.lpszClassName = "GraphWindow";
 	RegisterClass (&wndClass);
 
-	Graph::InitGDI();
+	GdiSurface::InitGDI();
 	g_DT = 1.0; // default to 1 sample per second.
 	g_Data.sample = 0;
 	g_Data.sim_time   = 0;
@@ -197,7 +199,7 @@ DLLCLBK void opcDLLExit (HINSTANCE hDLL)
 	UnregisterClass ("GraphWindow", g_hInst);
 	oapiUnregisterCustomCmd (g_dwCmd);
 
-	Graph::FreeGDI();
+	GdiSurface::FreeGDI();
 }
 
 DLLCLBK void opcTimestep (double simt, double simdt, double mjd)
@@ -213,7 +215,8 @@ DLLCLBK void opcTimestep (double simt, double simdt, double mjd)
 		for (DWORD i = 0; i < g_nGraph; i++)
 			g_Graph[i]->AppendDataPoint();
 		g_T = syst;
-		InvalidateRect (GetDlgItem (g_hDlg, IDC_GRAPH), NULL, TRUE);
+		// with the cached layers every graph repaints its whole area
+		InvalidateRect (GetDlgItem (g_hDlg, IDC_GRAPH), NULL, !Graph::LayerCache());
 	}
 }
 
@@ -530,14 +533,27 @@ LRESULT CALLBACK Graph_WndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPar
 			HDC hDC;
 			DWORD i;
 			int gw, gh;
+			char cbuf[64];
+			LARGE_INTEGER t0, t1, freq;
 			GetClientRect (hWnd, &r);
 			gw = r.right-r.left;
 			gh = (r.bottom-r.top)/g_nGraph;
 			hDC = BeginPaint (hWnd, &ps);
+			GdiSurface surf(hDC, gw, r.bottom-r.top);
+			QueryPerformanceCounter (&t0);
 			for (i = 0; i < g_nGraph; i++) {
-				SetViewportOrgEx (hDC, 0, i*gh, NULL);
-				g_Graph[i]->Refresh (hDC, gw, gh);
+				surf.SetOrigin (0, i*gh);
+				g_Graph[i]->Refresh (surf, gw, gh);
 			}
+			QueryPerformanceCounter (&t1);
+			QueryPerformanceFrequency (&freq);
+
+			// frame time counter, averaged over ~20 frames
+			double ms = 1e3*(double)(t1.QuadPart-t0.QuadPart)/(double)freq.QuadPart;
+			g_PaintTime = (g_PaintTime ? 0.95*g_PaintTime + 0.05*ms : ms);
+			sprintf (cbuf, "%d graphs %.2f ms%s", (int)g_nGraph, g_PaintTime, Graph::LayerCache() ? "" : " (no cache)");
+			surf.SetOrigin (0, 0);
+			Graph::Note (surf, gw-2, 0, cbuf);
 			EndPaint (hWnd, &ps);
 		}
 		break;
@@ -693,6 +709,7 @@ void WriteConfig(void) {
 		out_file << "TGTBASE " << range_target << std::endl;
 		out_file << "LOGDIR " << logdir << std::endl;
 		out_file << "LOGFILE " << logfile << std::endl;
+		if (Graph::LayerCache()) { out_file << "PAINTCACHE 1" << std::endl; }
 	}
 }
 
@@ -723,6 +740,8 @@ void ReadConfig(void) {
 				strcpy(logdir, line+7);
 			else if (!strnicmp (line, "LOGFILE", 7))
 				strcpy(logfile, line+8);
+			else if (!strnicmp (line, "PAINTCACHE", 10))
+				Graph::SetLayerCache (atoi (line+11) != 0);
 		}
 		strcpy(logpath, logdir);
 		strcat(logpath, logfile);
@@ -0,0 +1,117 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData
+//                  Part of the ORBITER SDK
+//
+// GdiSurface.cpp
+// GDI backend of the graph drawing surface.
+// ==============================================================
+
+#define STRICT
+#include <string.h>
+#include "GdiSurface.h"
+
+GdiSurface::GdiSurface (HDC _hDC, int _w, int _h)
+{
+	hDC = _hDC;
+	hBmp = hOld = 0;
+	w = _w;
+	h = _h;
+	pt = 0;
+	npt = 0;
+}
+
+GdiSurface::~GdiSurface ()
+{
+	if (hBmp) {
+		SelectObject (hDC, hOld);
+		DeleteObject (hBmp);
+		DeleteDC (hDC);
+	}
+	if (pt) delete []pt;
+}
+
+void GdiSurface::InitGDI ()
+{
+	gdi.font[0] = CreateFont (-10, 0, 0, 0, 400, 0, 0, 0, 0, 3, 2, 1, 49, "Arial");
+	gdi.font[1] = CreateFont (-10, 0, 900, 900, 400, 0, 0, 0, 0, 3, 2, 1, 49, "Arial");
+	gdi.npen = 0;
+}
+
+void GdiSurface::FreeGDI ()
+{
+	int i;
+	for (i = 0; i < 2; i++) DeleteObject (gdi.font[i]);
+	for (i = 0; i < gdi.npen; i++) DeleteObject (gdi.pen[i]);
+	gdi.npen = 0;
+}
+
+// the graphs use a handful of colours, so pens are kept for the session
+HPEN GdiSurface::Pen (SurfColor col)
+{
+	int i;
+	for (i = 0; i < gdi.npen; i++)
+		if (gdi.pencol[i] == col) return gdi.pen[i];
+	if (gdi.npen == NGDIPEN) return (HPEN)GetStockObject (BLACK_PEN);
+	gdi.pencol[i] = col;
+	gdi.pen[i] = CreatePen (PS_SOLID, 1, col);
+	gdi.npen++;
+	return gdi.pen[i];
+}
+
+void GdiSurface::SetOrigin (int x, int y)
+{
+	SetViewportOrgEx (hDC, x, y, NULL);
+}
+
+void GdiSurface::Fill (int x, int y, int _w, int _h, SurfColor col)
+{
+	RECT r = {x, y, x+_w, y+_h};
+	HBRUSH br = CreateSolidBrush (col);
+	FillRect (hDC, &r, br);
+	DeleteObject (br);
+}
+
+void GdiSurface::Line (int x0, int y0, int x1, int y1, SurfColor col)
+{
+	SelectObject (hDC, Pen (col));
+	MoveToEx (hDC, x0, y0, NULL);
+	LineTo (hDC, x1, y1);
+}
+
+void GdiSurface::Polyline (const SurfPoint *p, int n, SurfColor col)
+{
+	if (n > npt) {
+		if (pt) delete []pt;
+		pt = new POINT[npt = n];
+	}
+	for (int i = 0; i < n; i++) pt[i].x = p[i].x, pt[i].y = p[i].y;
+	SelectObject (hDC, Pen (col));
+	::Polyline (hDC, pt, n);
+}
+
+void GdiSurface::Text (int x, int y, const char *str, SurfColor col, int align, bool vertical)
+{
+	static const UINT ta[3] = {TA_LEFT, TA_CENTER, TA_RIGHT};
+	HFONT pfont = (HFONT)SelectObject (hDC, gdi.font[vertical ? 1 : 0]);
+	SetTextAlign (hDC, ta[align]);
+	SetTextColor (hDC, col);
+	TextOut (hDC, x, y, str, strlen(str));
+	SelectObject (hDC, pfont);
+}
+
+Surface *GdiSurface::CreateLayer (int _w, int _h)
+{
+	HDC hMem = CreateCompatibleDC (hDC);
+	GdiSurface *s = new GdiSurface (hMem, _w, _h);
+	s->hBmp = CreateCompatibleBitmap (hDC, _w, _h);
+	s->hOld = (HBITMAP)SelectObject (hMem, s->hBmp);
+	return s;
+}
+
+void GdiSurface::Blit (Surface *layer, int x, int y)
+{
+	GdiSurface *src = static_cast<GdiSurface*>(layer);
+	BitBlt (hDC, x, y, src->w, src->h, src->hDC, 0, 0, SRCCOPY);
+}
+
+GDIres GdiSurface::gdi = {{0,0},0};
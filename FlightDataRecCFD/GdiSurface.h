@@ -0,0 +1,52 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData
+//                  Part of the ORBITER SDK
+//
+// GdiSurface.h
+// GDI backend of the graph drawing surface.
+// ==============================================================
+
+#ifndef __GDISURFACE_H
+#define __GDISURFACE_H
+
+#include "windows.h"
+#include "..//FlightDataCommon//Surface.h"
+
+const int NGDIPEN = 16;
+
+struct GDIres {
+	HFONT font[2];          // horizontal and vertical text
+	int npen;
+	SurfColor pencol[NGDIPEN];
+	HPEN pen[NGDIPEN];      // pens created on demand, by colour
+};
+
+// Surface drawing into a GDI device context, either a window DC passed in
+// by the caller or an off-screen memory DC created by CreateLayer.
+class GdiSurface: public Surface {
+public:
+	GdiSurface (HDC _hDC, int _w, int _h);
+	~GdiSurface ();
+	static void InitGDI ();
+	static void FreeGDI ();
+	int  Width () const { return w; }
+	int  Height () const { return h; }
+	void SetOrigin (int x, int y);
+	void Fill (int x, int y, int _w, int _h, SurfColor col);
+	void Line (int x0, int y0, int x1, int y1, SurfColor col);
+	void Polyline (const SurfPoint *pt, int n, SurfColor col);
+	void Text (int x, int y, const char *str, SurfColor col, int align, bool vertical = false);
+	Surface *CreateLayer (int _w, int _h);
+	void Blit (Surface *layer, int x, int y);
+
+private:
+	static HPEN Pen (SurfColor col);
+	HDC hDC;
+	HBITMAP hBmp, hOld;     // bitmap of an off-screen surface
+	int w, h;
+	POINT *pt;              // Polyline vertex buffer
+	int npt;
+	static GDIres gdi;
+};
+
+#endif // !__GDISURFACE_H
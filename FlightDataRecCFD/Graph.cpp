@@ -8,21 +8,33 @@
 // Generic data graph class implementation.
 // ==============================================================
 
-#include <sstream>
-#define STRICT
 #include "Graph.h"
 #include <cstdio>
 #include <cmath>
 #include <string.h>
-#include "..//..//include//Orbitersdk.h"
 
-static COLORREF plotcol[MAXPLOT] = {0x0000ff, 0xff0000, 0x00ff00};
+static const SurfColor plotcol[MAXPLOT] = {0x0000ff, 0xff0000, 0x00ff00};
+static const SurfColor gridcol[2] = {0x808080, 0xD0D0D0};  // major, minor
 
 Graph::Graph (int _nplot): nplot(_nplot)
 {
 	data = new float*[nplot];
-	for (int i = 0; i < nplot; i++)
+	snap.data = new float*[nplot];
+	for (int i = 0; i < nplot; i++) {
 		data[i] = new float[NDATA];
+		snap.data[i] = new float[NDATA];
+	}
+	dec = new MinMaxDecimator[nplot];
+	dpt = 0;
+	pt = 0;
+	npt = 0;
+	fed = 0;
+	fed_resets = -1;
+	total = 0;
+	resets = 0;
+	layer.surf = 0;
+	layer.dirty = true;
+	layer.fvmin = layer.fvmax = 0.0f;
 	ResetData();
 	title = 0;
 	xlabel = 0;
@@ -33,10 +45,17 @@ Graph::Graph (int _nplot): nplot(_nplot)
 
 Graph::~Graph()
 {
-	for (int i = 0; i < nplot; i++)
+	for (int i = 0; i < nplot; i++) {
 		delete []data[i];
+		delete []snap.data[i];
+	}
 	delete []data;
+	delete []snap.data;
+	delete []dec;
+	if (dpt) delete []dpt;
+	if (pt) delete []pt;
 
+	FreeLayer ();
 	if (title) delete []title;
 	if (xlabel) delete []xlabel;
 	if (ylabel) delete []ylabel;
@@ -44,28 +63,12 @@ Graph::~Graph()
 	if (legend_idx) delete[]legend_idx;
 }
 
-void Graph::InitGDI ()
-{
-	gdi.font[0] = CreateFont (-10, 0, 0, 0, 400, 0, 0, 0, 0, 3, 2, 1, 49, "Arial");
-	gdi.font[1] = CreateFont (-10, 0, 900, 900, 400, 0, 0, 0, 0, 3, 2, 1, 49, "Arial");
-	gdi.pen[0]  = CreatePen (PS_SOLID, 0, 0x808080);
-	gdi.pen[1]  = CreatePen (PS_SOLID, 0, 0xD0D0D0);
-	for (int i = 0; i < MAXPLOT; i++)
-		gdi.pen[2+i]  = CreatePen (PS_SOLID, 1, plotcol[i]);
-}
-
-void Graph::FreeGDI ()
-{
-	DWORD i;
-	for (i = 0; i < 2; i++) DeleteObject (gdi.font[i]);
-	for (i = 0; i < 2+MAXPLOT; i++) DeleteObject (gdi.pen[i]);
-}
-
 void Graph::SetTitle (const char *_title)
 {
 	if (title) delete []title;
 	title = new char[strlen (_title)+1];
 	strcpy (title, _title);
+	layer.dirty = true;
 }
 
 void Graph::SetXLabel (const char *_label)
@@ -73,6 +76,7 @@ void Graph::SetXLabel (const char *_label)
 	if (xlabel) delete []xlabel;
 	xlabel = new char[strlen (_label)+1];
 	strcpy (xlabel, _label);
+	layer.dirty = true;
 }
 
 void Graph::SetYLabel (const char *_label)
@@ -80,6 +84,7 @@ void Graph::SetYLabel (const char *_label)
 	if (ylabel) delete []ylabel;
 	ylabel = new char[strlen (_label)+1];
 	strcpy (ylabel, _label);
+	layer.dirty = true;
 }
 
 void Graph::SetLegend (const char *_legend)
@@ -95,34 +100,46 @@ void Graph::SetLegend (const char *_legend)
 		if (_legend[i] == '&')
 			legend[i] = '\0', legend_idx[k++] = i+1;
 	}
+	layer.dirty = true;
 }
 
 void Graph::ResetData ()
 {
+	lock.WriteBegin();
 	ndata = idx = 0;
+	resets++;
 	vmin = vmax = data_tickmin = 0.0;
 	data_dtick = 1.0;
+	data_tickscale = 1.0;
+	data_minortick = 1;
+	lock.WriteEnd();
 }
 
 void Graph::AppendDataPoint (float val)
 {
+	lock.WriteBegin();
 	data[0][idx] = val;
 	idx = (idx+1)%NDATA;
+	total++;
 	if (ndata < NDATA) ndata++;
 	float vmn = vmin, vmx = vmax;
 	SetAutoRange ();
 	if (vmn != vmin || vmx != vmax) SetAutoTicks();
+	lock.WriteEnd();
 }
 
 void Graph::AppendDataPoints (float *val)
 {
+	lock.WriteBegin();
 	for (int p = 0; p < nplot; p++)
 		data[p][idx] = val[p];
 	idx = (idx+1)%NDATA;
+	total++;
 	if (ndata < NDATA) ndata++;
 	float vmn = vmin, vmx = vmax;
 	SetAutoRange ();
 	if (vmn != vmin || vmx != vmax) SetAutoTicks();
+	lock.WriteEnd();
 }
 
 void Graph::SetAutoRange ()
@@ -162,81 +179,205 @@ void Graph::SetAutoTicks ()
 	data_minortick = mintick;
 }
 
-void Graph::Refresh (HDC hDC, int w, int h)
+// copy the data and range into snap. The copy is retried if a data point
+// was appended while it was taken, so Refresh never draws a torn state.
+void Graph::TakeSnapshot ()
 {
-	int    x0 = w/10,   x1 = w-w/20, dx = x1-x0;
+	unsigned seq;
+	do {
+		seq = lock.ReadBegin();
+		for (int p = 0; p < nplot; p++)
+			memcpy (snap.data[p], data[p], NDATA*sizeof(float));
+		snap.vmin      = vmin;
+		snap.vmax      = vmax;
+		snap.tickscale = data_tickscale;
+		snap.dtick     = data_dtick;
+		snap.tickmin   = data_tickmin;
+		snap.minortick = data_minortick;
+		snap.ndata     = ndata;
+		snap.idx       = idx;
+		snap.total     = total;
+		snap.resets    = resets;
+	} while (lock.ReadRetry (seq));
+}
+
+// feed the data points appended since the last frame to the reducers,
+// starting over if the data were reset or the plot width changed
+void Graph::UpdateReduction (int ncol)
+{
+	int p, i;
+	long first = snap.total-snap.ndata;
+
+	if (dec[0].Columns() != ncol || fed_resets != snap.resets || fed < first) {
+		for (p = 0; p < nplot; p++) {
+			dec[p].Setup (NDATA, ncol);
+			dec[p].Reset();
+		}
+		if (dec[0].MaxPoints() > npt) {
+			if (dpt) delete []dpt;
+			if (pt) delete []pt;
+			npt = dec[0].MaxPoints();
+			dpt = new DecPoint[npt];
+			pt = new SurfPoint[npt];
+		}
+		fed = first;
+		fed_resets = snap.resets;
+	}
+	for (; fed < snap.total; fed++) {
+		i = (int)((snap.idx - (snap.total-fed) + NDATA) % NDATA);
+		for (p = 0; p < nplot; p++) dec[p].Append ((float)fed, snap.data[p][i]);
+	}
+}
+
+// true if the cached static layer no longer matches the size, range,
+// ticks or labels of the graph
+bool Graph::LayerStale (int w, int h) const
+{
+	return layer.dirty || !layer.surf || w != layer.w || h != layer.h ||
+		snap.vmin != layer.vmin || snap.vmax != layer.vmax ||
+		snap.tickmin != layer.tickmin || snap.dtick != layer.dtick ||
+		snap.tickscale != layer.tickscale || snap.minortick != layer.minortick;
+}
+
+// redraw the static layer (background, grid, tick labels, axes, legend,
+// title and ordinate label) into the cache bitmap
+void Graph::BuildLayer (Surface &s, int w, int h)
+{
+	if (!layer.surf || w != layer.w || h != layer.h) {
+		FreeLayer ();
+		layer.surf = s.CreateLayer (w, h);
+		layer.w = w;
+		layer.h = h;
+	}
+	layer.surf->Fill (0, 0, w, h, 0xffffff);
+	DrawStatic (*layer.surf, w, h);
+	layer.vmin      = snap.vmin;
+	layer.vmax      = snap.vmax;
+	layer.tickmin   = snap.tickmin;
+	layer.dtick     = snap.dtick;
+	layer.tickscale = snap.tickscale;
+	layer.minortick = snap.minortick;
+	layer.dirty     = false;
+}
+
+void Graph::FreeLayer ()
+{
+	if (!layer.surf) return;
+	delete layer.surf;
+	layer.surf = 0;
+}
+
+void Graph::DrawStatic (Surface &s, int w, int h)
+{
+	int    x0 = w/10,   x1 = w-w/20;
 	int y, y0 = h-h/10, y1 = h/20,   dy = y0-y1;
 	int i, p;
 	char cbuf[256];
+	float vmin = snap.vmin, vmax = snap.vmax;
 
-	HFONT pfont = (HFONT)SelectObject (hDC, gdi.font[0]);
-
-	if (ndata >= 2) {
+	if (snap.ndata >= 2) {
 		float f, ys = dy/(vmax-vmin);
-		SelectObject (hDC, gdi.pen[0]);
 
 		// draw grid lines and ordinate labels
-		SetTextAlign (hDC, TA_RIGHT);
-		for (f = data_tickmin; f <= vmax; f += data_dtick) {
+		for (f = snap.tickmin; f <= vmax; f += snap.dtick) {
 			y = y0 - (int)((f-vmin)*ys+0.5);
-			MoveToEx (hDC, x0, y, 0); LineTo (hDC, x1, y);
-			sprintf (cbuf, "%0.0f", f*data_tickscale);
-			TextOut (hDC, x0, y-5, cbuf, strlen(cbuf));
+			s.Line (x0, y, x1, y, gridcol[0]);
+			sprintf (cbuf, "%0.0f", f*snap.tickscale);
+			s.Text (x0, y-5, cbuf, 0x000000, TXT_RIGHT);
 		}
-		if (data_minortick > 1) {
-			SelectObject (hDC, gdi.pen[1]);
-			for (f = data_tickmin, i = 0; f > vmin; f -= data_dtick/(float)data_minortick, i++) {
-				if (!(i%data_minortick)) continue;
+		if (snap.minortick > 1) {
+			for (f = snap.tickmin, i = 0; f > vmin; f -= snap.dtick/(float)snap.minortick, i++) {
+				if (!(i%snap.minortick)) continue;
 				y = y0 - (int)((f-vmin)*ys+0.5);
-				MoveToEx (hDC, x0, y, 0); LineTo (hDC, x1, y);
+				s.Line (x0, y, x1, y, gridcol[1]);
 			}
-			for (f = data_tickmin, i = 0; f < vmax; f += data_dtick/(float)data_minortick, i++) {
-				if (!(i%data_minortick)) continue;
+			for (f = snap.tickmin, i = 0; f < vmax; f += snap.dtick/(float)snap.minortick, i++) {
+				if (!(i%snap.minortick)) continue;
 				y = y0 - (int)((f-vmin)*ys+0.5);
-				MoveToEx (hDC, x0, y, 0); LineTo (hDC, x1, y);
-			}
-		}
-
-		// draw data
-		for (p = 0; p < nplot; p++) {
-			SelectObject (hDC, gdi.pen[(p%MAXPLOT)+2]);
-			int j, i = idx-1; if (i < 0) i += NDATA;
-			MoveToEx (hDC, x1, y0 - (int)((data[p][i]-vmin)*ys+0.5), NULL);
-			for (j = 1; j < ndata; j++) {
-				i = idx-j-1; if (i < 0) i += NDATA;
-				LineTo (hDC, x1 - (dx*j)/NDATA, y0 - (int)((data[p][i]-vmin)*ys+0.5));
+				s.Line (x0, y, x1, y, gridcol[1]);
 			}
 		}
 	}
 
-	// Draw axes
-	SelectObject (hDC, GetStockObject (BLACK_PEN));
-	MoveToEx (hDC, x0, y1, NULL);
-	LineTo (hDC, x0, y0); LineTo (hDC, x1, y0);
+	DrawAxes (s, w, h);
 
 	if (legend) {
-		SetTextAlign (hDC, TA_LEFT);
-		for (p = 0; p < nplot; p++) {
-			SetTextColor (hDC, plotcol[p%MAXPLOT]);
-			TextOut (hDC, x0+5, y1+p*10, legend+legend_idx[p], strlen(legend+legend_idx[p]));
-		}
-		SetTextColor (hDC, 0x000000);
+		for (p = 0; p < nplot; p++)
+			s.Text (x0+5, y1+p*10, legend+legend_idx[p], plotcol[p%MAXPLOT], TXT_LEFT);
 	}
-	SetTextAlign (hDC, TA_CENTER);
 	if (title) {
-		TextOut (hDC, w/2, 0, title, strlen(title));
+		s.Text (w/2, 0, title, 0x000000, TXT_CENTER);
 	}
-	
-	SelectObject (hDC, gdi.font[1]);
-	std::ostringstream oss(cbuf,64);
+
 	if (ylabel) {
-		oss << ylabel;
-		if (data_tickscale && data_tickscale != 1.0f) oss << " x " << 1.0/data_tickscale;
-		oss << '\0';
-		TextOut (hDC, 0, (y0+y1)/2, oss.str().c_str(), strlen(oss.str().c_str()));
+		if (snap.tickscale && snap.tickscale != 1.0f)
+			sprintf (cbuf, "%.200s x %g", ylabel, 1.0/snap.tickscale);
+		else
+			sprintf (cbuf, "%.200s", ylabel);
+		s.Text (0, (y0+y1)/2, cbuf, 0x000000, TXT_CENTER, true);
+	}
+}
+
+void Graph::DrawAxes (Surface &s, int w, int h)
+{
+	int x0 = w/10, x1 = w-w/20;
+	int y0 = h-h/10, y1 = h/20;
+	SurfPoint axes[3] = {{x0, y1}, {x0, y0}, {x1, y0}};
+
+	s.Polyline (axes, 3, 0x000000);
+}
+
+void Graph::Refresh (Surface &s, int w, int h)
+{
+	int    x0 = w/10,   x1 = w-w/20, dx = x1-x0;
+	int    y0 = h-h/10, y1 = h/20,   dy = y0-y1;
+	int p;
+
+	TakeSnapshot ();
+	UpdateReduction (dx);
+	float vmin = snap.vmin, vmax = snap.vmax;
+
+	// static layer: blit from the cache, only redrawn when it went stale.
+	// While the auto-range moves from frame to frame a rebuilt layer would
+	// be used once, so it is drawn directly until the range holds
+	if (layercache) {
+		bool moving = (snap.vmin != layer.fvmin || snap.vmax != layer.fvmax);
+		layer.fvmin = snap.vmin, layer.fvmax = snap.vmax;
+		if (LayerStale (w, h) && moving) {
+			s.Fill (0, 0, w, h, 0xffffff);
+			DrawStatic (s, w, h);
+		} else {
+			if (LayerStale (w, h)) BuildLayer (s, w, h);
+			s.Blit (layer.surf, 0, 0);
+		}
+	} else {
+		DrawStatic (s, w, h);
 	}
 
-	SelectObject (hDC, pfont);
+	if (snap.ndata >= 2) {
+		float ys = dy/(vmax-vmin);
+
+		// draw data: at most two points per pixel column, one polyline per plot
+		for (p = 0; p < nplot; p++) {
+			int j, n = dec[p].Reduce (dpt);
+			long newest = dec[p].Total()-1;   // dpt[].n counts the reducer's samples
+			for (j = 0; j < n; j++) {
+				pt[j].x = x1 - (int)((dx*(newest-dpt[j].n))/NDATA);
+				pt[j].y = y0 - (int)((dpt[j].y-vmin)*ys+0.5);
+			}
+			if (n >= 2) s.Polyline (pt, n, plotcol[p%MAXPLOT]);
+		}
+		// keep the axes on top of the traces
+		DrawAxes (s, w, h);
+	}
+}
+
+// small grey annotation, right-aligned at (x,y)
+void Graph::Note (Surface &s, int x, int y, const char *str)
+{
+	s.Text (x, y, str, 0x808080, TXT_RIGHT);
 }
 
-GDIres Graph::gdi = {0,0};
\ No newline at end of file
+// off by default: fdgraph --bench shows no clear saving over drawing the
+// static parts directly once the canvas erase is counted (PAINTCACHE 1)
+bool Graph::layercache = false;
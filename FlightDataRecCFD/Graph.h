@@ -11,22 +11,17 @@
 #ifndef __GRAPH_H
 #define __GRAPH_H
 
-#include "windows.h"
+#include "..//FlightDataCommon//Surface.h"
+#include "..//FlightDataCommon//SeqLock.h"
+#include "..//FlightDataCommon//Decimate.h"
 
 const int MAXPLOT = 3;
 const int NDATA = 200;
 
-struct GDIres {
-	HFONT font[2];
-	HPEN  pen[2+MAXPLOT];
-};
-
 class Graph {
 public:
 	Graph (int _nplot = 1);
 	~Graph();
-	static void InitGDI ();
-	static void FreeGDI ();
 	void SetTitle (const char *_title);
 	void SetXLabel (const char *_label);
 	void SetYLabel (const char *_label);
@@ -34,11 +29,21 @@ public:
 	void ResetData();
 	void AppendDataPoint (float val);
 	void AppendDataPoints (float *val);
-	void Refresh (HDC hDC, int w, int h);
+	void Refresh (Surface &s, int w, int h);
+	static void SetLayerCache (bool cache) { layercache = cache; }
+	static bool LayerCache () { return layercache; }
+	static void Note (Surface &s, int x, int y, const char *str);
 
 protected:
 	void SetAutoRange ();
 	void SetAutoTicks ();
+	void TakeSnapshot ();
+	void UpdateReduction (int ncol);
+	bool LayerStale (int w, int h) const;
+	void BuildLayer (Surface &s, int w, int h);
+	void FreeLayer ();
+	void DrawStatic (Surface &s, int w, int h);
+	void DrawAxes (Surface &s, int w, int h);
 
 private:
 	int nplot;
@@ -50,11 +55,45 @@ private:
 	int data_minortick;
 	int ndata;
 	int idx;
+	long total;         // data points appended since construction
+	int resets;         // number of ResetData calls
+	SeqLock lock;       // guards data and range against a concurrent Refresh
+
+	// consistent copy of the data and range taken by Refresh
+	struct {
+		float **data;
+		float vmin, vmax;
+		float tickscale, dtick, tickmin;
+		int minortick;
+		int ndata, idx;
+		long total;
+		int resets;
+	} snap;
+
+	// per-column min/max reduction of the data, kept between frames
+	MinMaxDecimator *dec;
+	DecPoint *dpt;      // reduction output
+	SurfPoint *pt;      // polyline vertices
+	int npt;            // size of dpt and pt
+	long fed;           // next data point to feed to the reducers
+	int fed_resets;     // reset count at the last feed
+
+	// cached static layer (grid, tick labels, axes, legend and labels)
+	struct {
+		Surface *surf;  // off-screen surface, 0 if not built
+		int w, h;       // layer size
+		float vmin, vmax;
+		float tickscale, dtick, tickmin;
+		int minortick;
+		bool dirty;     // labels changed
+		float fvmin, fvmax;  // range at the last frame
+	} layer;
+	static bool layercache;  // use the cached layer
+
 	char *title;
 	char *xlabel, *ylabel;
 	char *legend;
 	int *legend_idx;
-	static GDIres gdi;
 };
 
 
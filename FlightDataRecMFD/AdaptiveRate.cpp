@@ -0,0 +1,77 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// AdaptiveRate.cpp
+// Sample rate controller driven by the flight dynamics.
+// ==============================================================
+
+#include <cmath>
+#include "AdaptiveRate.h"
+
+// signal levels regarded as "changing quickly"
+static const double REF_A_G       = 0.2;    // G
+static const double REF_DYNP_RATE = 200.0;  // Pa/s
+static const double REF_THR_RATE  = 5.0;    // %/s
+static const double REF_AOA_RATE  = 2.0;    // deg/s
+
+static const double QUIET_LEVEL = 0.25;     // fraction of reference
+static const double QUIET_HOLD  = 10.0;     // s of quiet before slowing down
+
+RateControl::RateControl ()
+{
+	rmin = 0.1;
+	rmax = 10.0;
+	Reset (1.0);
+}
+
+void RateControl::SetLimits (double _rmin, double _rmax)
+{
+	if (_rmin <= 0.0 || _rmax < _rmin) return;
+	rmin = _rmin;
+	rmax = _rmax;
+	Reset (rate);
+}
+
+void RateControl::Reset (double _rate)
+{
+	rate = (_rate < rmin ? rmin : _rate > rmax ? rmax : _rate);
+	activity = 0.0;
+	tquiet = -1.0;
+	reason = "";
+}
+
+bool RateControl::Update (double t, const RateSignals &sig)
+{
+	static const char *name[4] = {"a_g", "dynp", "throttle", "aoa"};
+	double lvl[4] = {
+		fabs (sig.a_g)/REF_A_G,
+		fabs (sig.dynp_rate)/REF_DYNP_RATE,
+		fabs (sig.thr_rate)/REF_THR_RATE,
+		fabs (sig.aoa_rate)/REF_AOA_RATE
+	};
+	int i, imax = 0;
+	for (i = 1; i < 4; i++)
+		if (lvl[i] > lvl[imax]) imax = i;
+	activity = lvl[imax];
+
+	if (activity > 1.0) {
+		tquiet = -1.0;
+		if (rate < rmax) {
+			rate = (rate*2.0 < rmax ? rate*2.0 : rmax);
+			reason = name[imax];
+			return true;
+		}
+	} else if (activity < QUIET_LEVEL) {
+		if (tquiet < 0.0) tquiet = t;
+		else if (t-tquiet >= QUIET_HOLD && rate > rmin) {
+			rate = (rate*0.5 > rmin ? rate*0.5 : rmin);
+			tquiet = t;
+			reason = "quiet";
+			return true;
+		}
+	} else {
+		tquiet = -1.0;
+	}
+	return false;
+}
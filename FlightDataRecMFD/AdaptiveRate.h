@@ -0,0 +1,44 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// AdaptiveRate.h
+// Sample rate controller driven by the flight dynamics.
+// ==============================================================
+
+#ifndef __ADAPTIVERATE_H
+#define __ADAPTIVERATE_H
+
+// activity signals over the last capture interval
+struct RateSignals {
+	double a_g;        // net acceleration (G)
+	double dynp_rate;  // rate of change of dynamic pressure (Pa/s)
+	double thr_rate;   // rate of change of main throttle (%/s)
+	double aoa_rate;   // rate of change of angle of attack (deg/s)
+};
+
+// Doubles the sample rate as soon as any signal exceeds its reference
+// level, and halves it again once all signals have stayed below a quarter
+// of their reference for a hold time. The rate is kept within
+// [rmin,rmax] samples per second.
+class RateControl {
+public:
+	RateControl ();
+	void SetLimits (double _rmin, double _rmax);
+	double MinRate () const { return rmin; }
+	double MaxRate () const { return rmax; }
+	void Reset (double _rate);
+	bool Update (double t, const RateSignals &sig);
+	double Rate () const { return rate; }
+	double Activity () const { return activity; }
+	const char *Reason () const { return reason; }
+
+private:
+	double rmin, rmax;   // rate limits (samples/s)
+	double rate;         // current rate (samples/s)
+	double activity;     // last normalised activity level
+	double tquiet;       // sim time since which activity has been low
+	const char *reason;  // signal that drove the last decision
+};
+
+#endif // !__ADAPTIVERATE_H
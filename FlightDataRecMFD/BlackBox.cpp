@@ -0,0 +1,77 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// BlackBox.cpp
+// Trigger logic for black-box (pre/post event) recording.
+// ==============================================================
+
+#include "BlackBox.h"
+
+static const double TD_ALT  = 5.0;   // altitude regarded as touchdown (m)
+static const double TD_ARM  = 50.0;  // altitude that arms the touchdown trigger (m)
+static const double G_REARM = 0.9;   // fraction of the G limit that re-arms the trigger
+
+BlackBox::BlackBox ()
+{
+	pre = 30.0;
+	post = 30.0;
+	glimit = 4.0;
+	crash_vrad = 10.0;
+	ntrigger = 0;
+	Reset();
+}
+
+void BlackBox::Reset ()
+{
+	g_armed = true;
+	td_armed = false;
+	capturing = false;
+	tstop = 0.0;
+}
+
+void BlackBox::SetWindow (double _pre, double _post)
+{
+	if (_pre >= 0.0) pre = _pre;
+	if (_post >= 0.0) post = _post;
+}
+
+// check a new sample for trigger conditions (alt in m above the ground);
+// returns the trigger name, or 0 if none fired
+const char *BlackBox::Check (double alt, double v_rad, double a_g)
+{
+	const char *trg = 0;
+
+	if (a_g > glimit) {
+		if (g_armed) trg = "GLIMIT";
+		g_armed = false;
+	} else if (a_g < glimit*G_REARM) {
+		g_armed = true;
+	}
+
+	if (alt > TD_ARM) {
+		td_armed = true;
+	} else if (td_armed && alt < TD_ALT && v_rad <= 0.0) {
+		td_armed = false;
+		trg = (-v_rad > crash_vrad ? "CRASH" : "TOUCHDOWN");
+	}
+	return trg;
+}
+
+// start a capture for a trigger at time t; false if one is already running
+bool BlackBox::Start (double t)
+{
+	if (capturing) return false;
+	capturing = true;
+	tstop = t + post;
+	ntrigger++;
+	return true;
+}
+
+// true once when the running capture has passed its post-trigger window
+bool BlackBox::Expired (double t)
+{
+	if (!capturing || t < tstop) return false;
+	capturing = false;
+	return true;
+}
@@ -0,0 +1,43 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// BlackBox.h
+// Trigger logic for black-box (pre/post event) recording.
+// ==============================================================
+
+#ifndef __BLACKBOX_H
+#define __BLACKBOX_H
+
+// In black-box mode samples only go to the in-memory ring. When a trigger
+// fires, the ring contents of the last 'pre' seconds are written out and
+// recording continues for another 'post' seconds.
+class BlackBox {
+public:
+	BlackBox ();
+	void Reset ();
+	void SetWindow (double _pre, double _post);
+	void SetGLimit (double g) { glimit = g; }
+	void SetCrashVrad (double v) { crash_vrad = v; }
+	double Pre () const { return pre; }
+	double Post () const { return post; }
+	double GLimit () const { return glimit; }
+	double CrashVrad () const { return crash_vrad; }
+	const char *Check (double alt, double v_rad, double a_g);
+	bool Start (double t);
+	bool Expired (double t);
+	bool Capturing () const { return capturing; }
+	int Triggers () const { return ntrigger; }
+
+private:
+	double pre, post;    // capture window before/after the trigger (s)
+	double glimit;       // G trigger threshold
+	double crash_vrad;   // touchdown descent rate regarded as a crash (m/s)
+	bool g_armed;        // G trigger re-armed after dropping below threshold
+	bool td_armed;       // touchdown trigger armed after climbing out
+	bool capturing;      // writing samples to disk
+	double tstop;        // sim time at which the capture ends
+	int ntrigger;        // number of captures started
+};
+
+#endif // !__BLACKBOX_H
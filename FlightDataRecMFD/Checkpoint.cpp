@@ -0,0 +1,96 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// Checkpoint.cpp
+// Binary snapshot of the recorder ring and session state.
+// ==============================================================
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "..//FlightDataCommon//Deflate.h"
+#include "Checkpoint.h"
+
+static size_t PayloadSize (const CheckpointHeader &h)
+{
+	return (size_t)h.ncol*h.ndata*sizeof(float) + (size_t)h.ndata*sizeof(int) + h.state_size;
+}
+
+Checkpoint::Checkpoint ()
+{
+	hdr = 0;
+}
+
+// the file is written under a temporary name and renamed when complete,
+// so a scenario never refers to a half-written checkpoint
+bool Checkpoint::Write (const char *path, const CheckpointHeader &h, float *const *col,
+	const int *quality, const void *state)
+{
+	CheckpointHeader hw = h;
+	unsigned int c, crc = 0;
+	memcpy (hw.magic, CKPT_MAGIC, 4);
+	hw.version = CKPT_VERSION;
+	hw.header_size = sizeof(CheckpointHeader);
+	for (c = 0; c < hw.ncol; c++)
+		crc = Crc32 (crc, (const unsigned char*)col[c], hw.ndata*sizeof(float));
+	crc = Crc32 (crc, (const unsigned char*)quality, hw.ndata*sizeof(int));
+	if (hw.state_size) crc = Crc32 (crc, (const unsigned char*)state, hw.state_size);
+	hw.checksum = crc;
+
+	std::string tmp = std::string (path) + ".tmp";
+	FILE *f = fopen (tmp.c_str(), "wb");
+	if (!f) return false;
+	bool ok = fwrite (&hw, sizeof(hw), 1, f) == 1;
+	for (c = 0; ok && c < hw.ncol; c++)
+		ok = fwrite (col[c], sizeof(float), hw.ndata, f) == hw.ndata;
+	if (ok) ok = fwrite (quality, sizeof(int), hw.ndata, f) == hw.ndata;
+	if (ok && hw.state_size) ok = fwrite (state, hw.state_size, 1, f) == 1;
+	if (fclose (f)) ok = false;
+	remove (path);
+	if (!ok || rename (tmp.c_str(), path)) {
+		remove (tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool Checkpoint::Open (const char *path)
+{
+	Close();
+	if (!mf.Open (path) || mf.Size() < (long long)sizeof(CheckpointHeader)) {
+		mf.Close();
+		return false;
+	}
+	const CheckpointHeader *h = (const CheckpointHeader*)mf.Data();
+	if (memcmp (h->magic, CKPT_MAGIC, 4) || h->version != CKPT_VERSION ||
+		h->header_size != sizeof(CheckpointHeader) ||
+		mf.Size() != (long long)(sizeof(CheckpointHeader) + PayloadSize (*h)) ||
+		Crc32 (0, (const unsigned char*)(h+1), PayloadSize (*h)) != h->checksum) {
+		mf.Close();
+		return false;
+	}
+	hdr = h;
+	return true;
+}
+
+void Checkpoint::Close ()
+{
+	mf.Close();
+	hdr = 0;
+}
+
+const float *Checkpoint::Column (int c) const
+{
+	return (const float*)(hdr+1) + (size_t)c*hdr->ndata;
+}
+
+const int *Checkpoint::Quality () const
+{
+	return (const int*)((const float*)(hdr+1) + (size_t)hdr->ncol*hdr->ndata);
+}
+
+const void *Checkpoint::State () const
+{
+	return Quality() + hdr->ndata;
+}
@@ -0,0 +1,61 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// Checkpoint.h
+// Binary snapshot of the recorder ring and session state.
+// ==============================================================
+
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#include "..//FlightDataCommon//MappedFile.h"
+
+#define CKPT_MAGIC "FDCP"
+const unsigned int CKPT_VERSION = 1;
+#define CKPT_EXT ".fdcp"
+
+// File layout: the header, ncol float columns of ndata values (the ring
+// in storage order), ndata ints of sample quality, then state_size bytes
+// of recorder state. The checksum covers everything after the header.
+struct CheckpointHeader {
+	char magic[4];
+	unsigned int version;
+	unsigned int header_size;
+	unsigned int ncol;        // float columns
+	unsigned int ndata;       // ring length
+	unsigned int state_size;  // bytes of recorder state after the columns
+	unsigned int checksum;    // CRC-32 of the payload
+	int sample;               // next ring index
+	int count;                // valid samples in the ring
+	int paused;               // recorder paused at the checkpoint
+	long long total;          // samples stored
+	long long logpos;         // size of the log file at the checkpoint
+	double simt;              // sim time at the checkpoint
+	double mjd;               // MJD at the checkpoint
+	double tnext;             // time of the next sample
+	char vessel[64];          // focus vessel
+	char logfile[260];        // log file being written
+};
+
+// Writes a checkpoint in one go and reads one back through a read-only
+// mapping, so a restore costs a validation pass and one copy per column.
+class Checkpoint {
+public:
+	static bool Write (const char *path, const CheckpointHeader &h, float *const *col,
+		const int *quality, const void *state);
+
+	Checkpoint ();
+	bool Open (const char *path);
+	void Close ();
+	const CheckpointHeader &Header () const { return *hdr; }
+	const float *Column (int c) const;
+	const int *Quality () const;
+	const void *State () const;
+
+private:
+	MappedFile mf;
+	const CheckpointHeader *hdr;
+};
+
+#endif // !__CHECKPOINT_H
@@ -7,17 +7,36 @@
 // ==============================================================
 
 #include <filesystem>
+#include <sstream>
 #include <string>
 #define STRICT
 #define ORBITER_MODULE
 #include <windows.h>
 #include <cstdio>
+#include <cstdarg>
 #include <cmath>
 #include <iostream>
 #include <direct.h>
 #include "..//..//include//Orbitersdk.h"
 #include "..//..//include//MFDlib.h"
 #include "FlightDataRecMFD.h"
+#include "Resample.h"
+#include "AdaptiveRate.h"
+#include "BlackBox.h"
+#include "FlightEvents.h"
+#include "Integrals.h"
+#include "Watchdog.h"
+#include "Checkpoint.h"
+#include "..//FlightDataCommon//SeqLock.h"
+#include "..//FlightDataCommon//SessionCatalog.h"
+#include "..//FlightDataCommon//Journal.h"
+#include "..//FlightDataCommon//LogRotation.h"
+#include "..//FlightDataCommon//OrbitElements.h"
+#include "..//FlightDataCommon//RangeTargets.h"
+#include "..//FlightDataCommon//RefTrajectory.h"
+#include "..//FlightDataCommon//RunningStats.h"
+#include "..//FlightDataCommon//TelemetryRing.h"
+#include "..//FlightDataCommon//TelemetryStream.h"
 
 // ==============================================================
 // Global variables
@@ -26,12 +45,13 @@ const int ndata = 600;      // max samples
 
 int paused = 1;
 int auto_inc = 1;
+int adaptive = 0;    // adaptive sample rate
+int blackbox = 0;    // black-box mode: log only around trigger events
 double M = 0;
 double R = 0;
 float sample_dt;     // sample interval
-float prev_v_mag = 0.0;
 char delim_char = ' ';
-std::string tgt_base;
+std::string tgt_base;  // range targets, comma separated; the first is logged
 std::filesystem::path logdir;
 std::filesystem::path logfile;
 std::filesystem::path logpath;
@@ -42,8 +62,7 @@ std::filesystem::path flightdatafolder("FlightData");
 std::filesystem::path configfolder("Config");
 std::filesystem::path configfilename("FDRMFD.cfg");
 
-OBJHANDLE hbase = 0;
-VECTOR3 b_pos;
+RangeTargets g_Targets;  // resolved tgt_base, with handles as the objects
 
 static struct {  // "FlightDataRec MFD" parameters
 	int mode;      // identifier for new MFD mode
@@ -52,6 +71,9 @@ static struct {  // "FlightDataRec MFD" parameters
 struct {  // global data storage
 	double tnext;  // time of next sample
 	int   sample;  // current sample index
+	int   count;   // number of valid samples in the ring
+	long  total;   // samples stored since the module was loaded
+	int   purges;  // number of times the ring was purged
 	float *sim_time;   // sim time
 	float *ves_alt;    // altitude
 	float *ves_pitch;  // pitch
@@ -78,19 +100,89 @@ struct {  // global data storage
 	float *eng_fuel_rate; // fuel mass flow rate for default propellant source (kg/s)
 	float *eng_main_t;  // main engine thrust (%)
 	float *eng_hover_t; // hover engine thrust (%)
+	int *smp_q;         // sample quality (0 = exact, 1 = interpolated)
+	float *int_dv;      // delta-v expended (m/s)
+	float *int_gnd;     // ground track distance (km)
+	float *int_heat;    // heat load proxy, rho*v^3 over time (MJ/m^2)
+	float *int_fuel;    // propellant flow over time (kg)
+	float *fuel_resid;  // propellant mass lost minus int_fuel (kg)
+	float *orb_apo;     // apoapsis altitude (km)
+	float *orb_peri;    // periapsis altitude (km)
+	float *orb_ecc;     // eccentricity
+	float *orb_inc;     // inclination (deg)
+	float *orb_t_apo;   // time to apoapsis (s)
+	float *orb_energy;  // specific orbital energy (MJ/kg)
 } g_Data;
 
-// Thanks Chris Knestrick! :)
-// Thanks www.askdrmath.com! :-)
-static inline double CalcSphericalDistance(VECTOR3 Pos1, VECTOR3 Pos2)
+SeqLock g_DataLock;    // publishes g_Data ring updates to the renderers
+Resampler g_Resample;  // maps captured states onto the sample grid
+RateControl g_RateCtl; // adaptive sample rate
+BlackBox g_BlackBox;   // black-box trigger logic
+Watchdog g_Watchdog;   // per-step latency budget
+SessionStats g_Session;               // catalog entry of the session being logged
+WindowStats g_Window[NCATCH];         // catalog channels over the last g_StatWindow s
+double g_StatWindow = 60.0;           // sliding statistics window (s of sim time)
+std::filesystem::path g_SessionPath;  // log file of that session
+RefTrajectory g_Ref;                  // reference flight overlaid on the plots
+TelemetryWriter g_Telemetry;          // live samples for external readers
+std::string g_TelemetryName;          // shared-memory name or file, empty = off
+int g_TelemetrySlots = 4096;
+TelemetryStream g_Stream;             // live samples for network clients
+std::string g_StreamSpec;             // tcp:PORT or udp:HOST:PORT, empty = off
+int g_StreamBatch = 10;               // samples per frame
+int g_StreamFlush = 100;              // ms before a partial frame is sent
+int g_StreamQueue = 64;               // frames queued per client
+bool g_StreamText = false;            // line protocol instead of binary frames
+JournalWriter g_Journal;              // block writer of the data log
+int g_JournalRows = 0;                // samples per journal block, 0 = append each sample
+int g_JournalFlush = 200;             // ms before a partial block is written
+int g_JournalSync = 0;                // blocks between syncs to disk, 0 = no count
+int g_JournalSyncMs = 1000;           // ms between syncs to disk, 0 = no timer
+SegmentCompressor g_Segments;         // gzips closed log segments in the background
+double g_RotateMB = 0.0;              // segment size that starts a new one, 0 = no limit
+double g_RotateMin = 0.0;             // sim minutes per segment, 0 = no limit
+int g_RotateZ = 1;                    // compress closed segments
+SegmentInfo g_Seg;                    // segment being written
+FlightEvents g_Events;                // event detectors run on each stored sample
+int events = 1;                       // event detection on/off
+EventMarks g_Marks;                   // newest events, guarded by g_DataLock
+FlightIntegrals g_Integrals;          // integrated channels of the stored samples
+OBJHANDLE g_OrbitRef = 0;             // reference body of g_Orbit
+OrbitBody g_Orbit;                    // its constants, for the orbit elements
+bool g_Restored = false;              // ring restored from a scenario checkpoint
+double g_LogShift = 0.0;              // added to logged sim times: the checkpoint's time line
+std::string g_CkptPath;               // checkpoint written for the last scenario save
+double g_CkptMJD = -1.0;              // MJD of that save
+
+int g_Pending[ndata];  // ring indices of samples waiting to be logged
+int g_npending = 0;    // number of queued samples
+int g_pendhead = 0;    // index of the oldest queued sample
+
+// look up the range targets in the comma separated list as a surface base
+// of the body ref, a vessel or a station, as the CFD does for its single
+// target. Unknown names are dropped; tgt_base keeps the ones found.
+static bool SetTargets (OBJHANDLE ref, const std::string &list)
 {
-	double DeltaLat = Pos2.LAT - Pos1.LAT;
-	double DeltaLong = Pos2.LONG - Pos1.LONG;
-
-	double A = pow(sin(DeltaLat/2), 2) + cos(Pos1.LAT) * cos (Pos2.LAT) * pow(sin(DeltaLong/2), 2);
-	double C = 2 * atan2(sqrt(A), sqrt(1 - A));
-	
-	return (R * C);
+	std::vector<std::string> names = SplitTargetList (list);
+	double lon, lat, rad;
+	g_Targets.Clear();
+	tgt_base.clear();
+	for (size_t k = 0; k < names.size(); k++) {
+		char *name = const_cast<char *>(names[k].c_str());
+		OBJHANDLE h;
+		int kind;
+		if ((h = oapiGetBaseByName (ref, name))) {
+			oapiGetBaseEquPos (h, &lon, &lat, &rad);
+			kind = TGT_BASE;
+		}
+		else if ((h = oapiGetVesselByName (name)) && oapiGetEquPos (h, &lon, &lat, &rad)) kind = TGT_VESSEL;
+		else if ((h = oapiGetStationByName (name)) && oapiGetEquPos (h, &lon, &lat, &rad)) kind = TGT_STATION;
+		else continue;
+		g_Targets.Add (name, kind, h, lon, lat);
+		if (!tgt_base.empty()) tgt_base += ", ";
+		tgt_base += names[k];
+	}
+	return g_Targets.Count() > 0;
 }
 
 
@@ -98,8 +190,17 @@ static inline double CalcSphericalDistance(VECTOR3 Pos1, VECTOR3 Pos2)
 // API interface
 
 void PurgeDataPoints(void);
+static void FlushDeferred(double budget);
+static void CloseSession(void);
+static void OpenTelemetry(void);
+static void OpenStream(void);
+static void RecoverLogs(void);
+static void CloseSegment(void);
 void ReadConfig(void);
 void WriteConfig(void);
+bool LoadReference(const std::string &name);
+bool SaveCheckpoint(std::string &path);
+bool RestoreCheckpoint(const char *path, const char *vessel);
 
 DLLCLBK void opcDLLInit (HINSTANCE hDLL){
 
@@ -139,6 +240,19 @@ DLLCLBK void opcDLLInit (HINSTANCE hDLL){
 	g_Data.eng_fuel_rate   = new float[ndata];   memset (g_Data.eng_fuel_rate,  0, ndata*sizeof(float));
 	g_Data.eng_main_t   = new float[ndata];   memset (g_Data.eng_main_t,  0, ndata*sizeof(float));
 	g_Data.eng_hover_t   = new float[ndata];   memset (g_Data.eng_hover_t,  0, ndata*sizeof(float));
+	g_Data.smp_q   = new int[ndata];   memset (g_Data.smp_q,  0, ndata*sizeof(int));
+	g_Data.int_dv     = new float[ndata];   memset (g_Data.int_dv,     0, ndata*sizeof(float));
+	g_Data.int_gnd    = new float[ndata];   memset (g_Data.int_gnd,    0, ndata*sizeof(float));
+	g_Data.int_heat   = new float[ndata];   memset (g_Data.int_heat,   0, ndata*sizeof(float));
+	g_Data.int_fuel   = new float[ndata];   memset (g_Data.int_fuel,   0, ndata*sizeof(float));
+	g_Data.fuel_resid = new float[ndata];   memset (g_Data.fuel_resid, 0, ndata*sizeof(float));
+	g_Data.orb_apo    = new float[ndata];   memset (g_Data.orb_apo,    0, ndata*sizeof(float));
+	g_Data.orb_peri   = new float[ndata];   memset (g_Data.orb_peri,   0, ndata*sizeof(float));
+	g_Data.orb_ecc    = new float[ndata];   memset (g_Data.orb_ecc,    0, ndata*sizeof(float));
+	g_Data.orb_inc    = new float[ndata];   memset (g_Data.orb_inc,    0, ndata*sizeof(float));
+	g_Data.orb_t_apo  = new float[ndata];   memset (g_Data.orb_t_apo,  0, ndata*sizeof(float));
+	g_Data.orb_energy = new float[ndata];   memset (g_Data.orb_energy, 0, ndata*sizeof(float));
+	g_Resample.SetMaxBurst (ndata);
 
 	g_FlightDataRecMFD.mode = oapiRegisterMFDMode (spec);
 	PurgeDataPoints();
@@ -168,11 +282,22 @@ DLLCLBK void opcDLLInit (HINSTANCE hDLL){
 	logpath = curpath / logdir / logfile;
 
 	ReadConfig();
+	RecoverLogs();
+	if (g_RotateMB > 0 || g_RotateMin > 0) g_Segments.Start (g_RotateZ != 0);
+	OpenTelemetry();
+	OpenStream();
 }
 
 DLLCLBK void opcDLLExit (HINSTANCE hDLL)
 {
 	paused = 1;
+	FlushDeferred (-1.0);
+	CloseSegment();
+	g_Journal.Close();
+	g_Segments.Stop();
+	CloseSession();
+	g_Telemetry.Close();
+	g_Stream.Stop();
 	WriteConfig();
 	oapiUnregisterMFDMode (g_FlightDataRecMFD.mode);
 	delete []g_Data.sim_time;
@@ -200,129 +325,444 @@ DLLCLBK void opcDLLExit (HINSTANCE hDLL)
 	delete []g_Data.eng_fuel_rate;
 	delete []g_Data.eng_main_t;
 	delete []g_Data.eng_hover_t;
+	delete []g_Data.smp_q;
+	delete []g_Data.int_dv;
+	delete []g_Data.int_gnd;
+	delete []g_Data.int_heat;
+	delete []g_Data.int_fuel;
+	delete []g_Data.fuel_resid;
+	delete []g_Data.orb_apo;
+	delete []g_Data.orb_peri;
+	delete []g_Data.orb_ecc;
+	delete []g_Data.orb_inc;
+	delete []g_Data.orb_t_apo;
+	delete []g_Data.orb_energy;
 
 }
 
 // We record vessel parameters outside the MFD to keep tracking
 // even if the MFD mode doesn't exist
 
-void log_data(void);
+void log_data(int i);
+void log_event(double simt, const char *type, const char *fmt, ...);
+void IncrementFileCounter(void);
 
-DLLCLBK void opcPreStep (double simt, double simdt, double mjd){
-	
-  if (!paused) {
-	if (simt >= g_Data.tnext) {
-		VESSEL *v = oapiGetFocusInterface();
-		VESSELSTATUS v_stat;	
-		VECTOR3 vel, pos, v_pos;
-		ATMPARAM atm;
-		OBJHANDLE ref;
-		double a, r2, v2, vr2, vt2;
-		double alt = v->GetAltitude();
-
-		ref = v->GetSurfaceRef();
-		M = oapiGetMass (ref);
-		R = oapiGetSize (ref);
-		v->GetStatus(v_stat);
+// write out samples queued while the watchdog deferred log formatting;
+// stop once the current step has used 'budget' us (< 0: write all)
+static void FlushDeferred (double budget)
+{
+	while (g_npending) {
+		if (budget >= 0.0 && g_Watchdog.Elapsed() > budget) break;
+		log_data (g_Pending[g_pendhead]);
+		g_pendhead = (g_pendhead+1) % ndata;
+		g_npending--;
+	}
+}
 
-		g_Data.sim_time[g_Data.sample]  = (float)simt;
-			
-		// grab vessel attitude samples
-		g_Data.ves_alt[g_Data.sample]   = (float)(alt*1e-3);
-		g_Data.ves_pitch[g_Data.sample] = (float)(v->GetPitch()*DEG);
-		g_Data.ves_roll[g_Data.sample] = (float)(v->GetBank()*DEG);
-		g_Data.ves_yaw[g_Data.sample] = (float)(v->GetSlipAngle()*DEG);
-
-		// grab vessel velocity samples and calculate acceleration 
-		v->GetRelativeVel (v->GetSurfaceRef(), vel);
-		v->GetRelativePos (v->GetSurfaceRef(), pos);
-		r2 = pos.x*pos.x + pos.y*pos.y + pos.z*pos.z;
-		v2 = vel.x*vel.x + vel.y*vel.y + vel.z*vel.z;
-		a  = (vel.x*pos.x + vel.y*pos.y + vel.z*pos.z) / r2;
-		vr2 = a*a * r2;
-		vt2 = v2 - vr2;
-		g_Data.ves_v_rad[g_Data.sample] = (vr2 >= 0.0 ? a >= 0.0 ? (float)sqrt(vr2) : -(float)sqrt(vr2) : 0.0f);
-		g_Data.ves_v_tan[g_Data.sample] = (vt2 >= 0.0 ? (float)sqrt(vt2) : 0.0f);
-		if (g_Data.sample > 0) {
-			g_Data.ves_a_rad[g_Data.sample] = (((g_Data.ves_v_rad[g_Data.sample]) - (g_Data.ves_v_rad[g_Data.sample-1]))/sample_dt);
-			g_Data.ves_a_tan[g_Data.sample] = (((g_Data.ves_v_tan[g_Data.sample]) - (g_Data.ves_v_tan[g_Data.sample-1]))/sample_dt);
-		}
-		// ---------- G meter, somewhat agrees with Dan Polli's DG3 G meter -----------
-// reentry use
-		float v_mag, dp = 0.0;
-			v_mag = (float) sqrt((vel.x*vel.x) + (vel.y*vel.y) + (vel.z*vel.z));
-		if (prev_v_mag > 0) {
-			dp = (float) (v_mag-prev_v_mag)/(float) G;
-			dp = dp < 0 ? -dp : dp;
-			g_Data.ves_a_g[g_Data.sample] = dp;
-		}
-		else g_Data.ves_a_g[g_Data.sample] = 0.0;
-		prev_v_mag = v_mag;
-
-
-		// grab vessel position samples
-		if (hbase) {
-			v->GetEquPos(v_pos.LONG, v_pos.LAT, v_pos.RADIUS);
-			g_Data.ves_surf_lon[g_Data.sample] = (float)(v_pos.LONG*DEG);
-			g_Data.ves_surf_lat[g_Data.sample] = (float)(v_pos.LAT*DEG);
-			oapiGetFocusHeading(&a);
-			g_Data.ves_surf_hdg[g_Data.sample] = (float)(a*DEG);
-			g_Data.ves_dist[g_Data.sample] = (float)(CalcSphericalDistance(b_pos, v_pos)*1e-3); // distance in km
-		}
+// log a ring sample, or queue it for a later step while formatting is
+// deferred. At most half a ring is queued, so queued samples are never
+// overwritten before they are written.
+static void WriteSample (int i)
+{
+	if (g_Watchdog.Level() >= WD_DEFER_LOG && g_npending < ndata/2) {
+		g_Pending[(g_pendhead+g_npending) % ndata] = i;
+		g_npending++;
+	} else {
+		FlushDeferred (-1.0);
+		log_data (i);
+	}
+}
 
-		// angle of attack
-		g_Data.ves_aoa[g_Data.sample] = (float)(v->GetAOA()*DEG);
+// write out the ring samples of the last black-box pre-trigger window
+// and keep logging until the post-trigger window has passed
+static void BlackBoxTrigger (const char *reason)
+{
+	int i, n, last = (g_Data.sample+ndata-1) % ndata;
+	double t = (g_Data.count ? g_Data.sim_time[last] : 0.0);
 
-		// mach
-		g_Data.ves_mach[g_Data.sample] = (float)v->GetMachNumber();
+	if (!g_BlackBox.Start (t)) { // capture already running: just note it
+		log_event (t, "TRIGGER", "%s", reason);
+		return;
+	}
+	FlushDeferred (-1.0);
+	IncrementFileCounter();
+	log_event (t, "TRIGGER", "%s", reason);
+	for (n = g_Data.count; n > 0; n--) {
+		i = (g_Data.sample+ndata-n) % ndata;
+		if (g_Data.sim_time[i] >= t-g_BlackBox.Pre()) WriteSample (i);
+	}
+}
 
-		g_Data.ves_lift[g_Data.sample] = (float)v->GetLift();
-		g_Data.ves_drag[g_Data.sample] = (float)v->GetDrag();
+// route a new ring sample in black-box mode; alt_gnd is the altitude above
+// the ground (km) of its state
+static void BlackBoxSample (int i, double alt_gnd)
+{
+	const char *trg = g_BlackBox.Check (alt_gnd*1e3, g_Data.ves_v_rad[i], g_Data.ves_a_g[i]);
+	if (trg) BlackBoxTrigger (trg);
+	else if (g_BlackBox.Capturing()) {
+		WriteSample (i);
+		if (g_BlackBox.Expired (g_Data.sim_time[i]))
+			log_event (g_Data.sim_time[i], "BBEND", "%d", g_BlackBox.Triggers());
+	}
+}
 
+// look up the constants of a new reference body for the orbit elements.
+// The rotation axis is taken once as well; it precesses over millennia.
+static void SetOrbitBody (OBJHANDLE ref)
+{
+	MATRIX3 rot;
+	oapiGetRotationMatrix (ref, &rot);
+	g_Orbit.gm = GGRAV*oapiGetMass (ref);
+	g_Orbit.radius = oapiGetSize (ref);
+	g_Orbit.pole[0] = rot.m12;   // the body's y axis: north
+	g_Orbit.pole[1] = rot.m22;
+	g_Orbit.pole[2] = rot.m32;
+	g_OrbitRef = ref;
+}
+
+// capture the current state of vessel v. Without 'optional' the expensive
+// optional channels (atmosphere, lift, drag) hold their last values.
+static void CaptureState (VESSEL *v, double simt, FDState &s, bool optional)
+{
+	VESSELSTATUS v_stat;	
+	VECTOR3 vel, pos, v_pos;
+	ATMPARAM atm;
+	OBJHANDLE ref;
+	double a, r2, v2, vr2, vt2;
+	double alt = v->GetAltitude();
+
+	ref = v->GetSurfaceRef();
+	if (ref != g_OrbitRef) SetOrbitBody (ref);
+	M = g_Orbit.gm/GGRAV;
+	R = g_Orbit.radius;
+	v->GetStatus(v_stat);
+
+	s.t = simt;
+
+	// grab vessel attitude samples
+	s.v[ST_ALT]   = alt*1e-3;
+	s.v[ST_ALT_GND] = v->GetAltitude (ALTMODE_GROUND)*1e-3;
+	s.v[ST_PITCH] = v->GetPitch()*DEG;
+	s.v[ST_ROLL]  = v->GetBank()*DEG;
+	s.v[ST_YAW]   = v->GetSlipAngle()*DEG;
+
+	// grab vessel velocity samples
+	v->GetRelativeVel (ref, vel);
+	v->GetRelativePos (ref, pos);
+	r2 = pos.x*pos.x + pos.y*pos.y + pos.z*pos.z;
+	v2 = vel.x*vel.x + vel.y*vel.y + vel.z*vel.z;
+	a  = (vel.x*pos.x + vel.y*pos.y + vel.z*pos.z) / r2;
+	vr2 = a*a * r2;
+	vt2 = v2 - vr2;
+	s.v[ST_V_RAD] = (vr2 >= 0.0 ? a >= 0.0 ? sqrt(vr2) : -sqrt(vr2) : 0.0);
+	s.v[ST_V_TAN] = (vt2 >= 0.0 ? sqrt(vt2) : 0.0);
+	s.v[ST_V_MAG] = sqrt(v2);
+
+	// orbit elements from the same vectors
+	StateVectors sv = {&pos.x, &pos.y, &pos.z, &vel.x, &vel.y, &vel.z};
+	double *orb[NORBIT];
+	for (int k = 0; k < NORBIT; k++) orb[k] = &s.v[ST_ORB_APO+k];
+	OrbitElements (g_Orbit, sv, 1, orb);
+
+	// grab vessel position samples; the position is always taken for the
+	// ground track, but only logged with a range target. Every target is
+	// ranged for its closest approach; the first one is logged.
+	v->GetEquPos(v_pos.LONG, v_pos.LAT, v_pos.RADIUS);
+	s.v[ST_SURF_LON] = v_pos.LONG*DEG;
+	s.v[ST_SURF_LAT] = v_pos.LAT*DEG;
+	if (g_Targets.Count()) {
+		double lon, lat, rad;
+		for (int k = 0; k < g_Targets.Count(); k++)   // vessels and stations move
+			if (g_Targets.Kind (k) != TGT_BASE && oapiGetEquPos ((OBJHANDLE)g_Targets.Object (k), &lon, &lat, &rad))
+				g_Targets.Move (k, lon, lat);
+		g_Targets.Update (simt, v_pos.LONG, v_pos.LAT);
+		oapiGetFocusHeading(&a);
+		s.v[ST_SURF_HDG] = a*DEG;
+		s.v[ST_DIST] = g_Targets.Range (0, R)*1e-3; // distance in km
+	} else {
+		s.v[ST_SURF_HDG] = s.v[ST_DIST] = 0.0;
+	}
+
+	// angle of attack
+	s.v[ST_AOA] = v->GetAOA()*DEG;
+
+	// mach
+	s.v[ST_MACH] = v->GetMachNumber();
+
+	if (optional) {
+		s.v[ST_LIFT] = v->GetLift();
+		s.v[ST_DRAG] = v->GetDrag();
 
 		// grab atmospheric samples
 		oapiGetPlanetAtmParams(v_stat.rbody, R+alt, &atm);
-		g_Data.atm_t[g_Data.sample] = (float)atm.T;
-		g_Data.atm_stp[g_Data.sample] = (float)atm.p;
-		g_Data.atm_dynp[g_Data.sample] = (float)v->GetDynPressure();
-		g_Data.atm_d[g_Data.sample] = (float)atm.rho;
-		
-		//grab engine samples
-		g_Data.eng_fuel_mass[g_Data.sample] = (float)v->GetTotalPropellantMass();
-		g_Data.eng_fuel_rate[g_Data.sample] = (float)v->GetTotalPropellantFlowrate();
-		g_Data.eng_main_t[g_Data.sample] = (float)(v->GetThrusterGroupLevel(THGROUP_MAIN))*100;
-		g_Data.eng_hover_t[g_Data.sample] = (float)(v->GetThrusterGroupLevel(THGROUP_HOVER))*100;
+		s.v[ST_ATM_T] = atm.T;
+		s.v[ST_ATM_STP] = atm.p;
+		s.v[ST_ATM_D] = atm.rho;
+	} else {
+		static const int opt[5] = {ST_LIFT, ST_DRAG, ST_ATM_T, ST_ATM_STP, ST_ATM_D};
+		for (int k = 0; k < 5; k++)
+			s.v[opt[k]] = (g_Resample.Captures() ? g_Resample.Current().v[opt[k]] : 0.0);
+	}
+	s.v[ST_ATM_DYNP] = v->GetDynPressure();
+
+	//grab engine samples
+	s.v[ST_FUEL_MASS] = v->GetTotalPropellantMass();
+	s.v[ST_FUEL_RATE] = v->GetTotalPropellantFlowrate();
+	s.v[ST_MAIN_T] = v->GetThrusterGroupLevel(THGROUP_MAIN)*100;
+	s.v[ST_HOVER_T] = v->GetThrusterGroupLevel(THGROUP_HOVER)*100;
+
+	// for the integrated channels
+	VECTOR3 thrust;
+	s.v[ST_THRUST] = (v->GetThrustVector (thrust) ? length (thrust) : 0.0);
+	s.v[ST_MASS] = v->GetMass();
+	s.v[ST_AIRSPEED] = v->GetAirspeed();
+}
 
+// channels published in the telemetry ring: the log columns after sim_time
+static const TelemetryChannel telechan[] = {
+	{"ves_alt", "km"}, {"ves_pitch", "deg"}, {"ves_roll", "deg"}, {"ves_yaw", "deg"},
+	{"ves_v_rad", "m/s"}, {"ves_v_tan", "m/s"}, {"ves_a_rad", "m/s^2"}, {"ves_a_tan", "m/s^2"},
+	{"ves_a_g", "G"}, {"ves_surf_lon", "deg"}, {"ves_surf_lat", "deg"}, {"ves_surf_hdg", "deg"},
+	{"ves_dist", "km"}, {"ves_aoa", "deg"}, {"ves_mach", ""}, {"ves_lift", "N"},
+	{"ves_drag", "N"}, {"atm_t", "K"}, {"atm_stp", "Pa"}, {"atm_dynp", "Pa"},
+	{"atm_d", "kg/m^3"}, {"eng_fuel_mass", "kg"}, {"eng_fuel_rate", "kg/s"}, {"eng_main_t", "%"},
+	{"eng_hover_t", "%"}, {"smp_q", ""}, {"int_dv", "m/s"}, {"int_gnd", "km"},
+	{"int_heat", "MJ/m^2"}, {"int_fuel", "kg"}, {"fuel_resid", "kg"}, {"orb_apo", "km"},
+	{"orb_peri", "km"}, {"orb_ecc", ""}, {"orb_inc", "deg"}, {"orb_t_apo", "s"},
+	{"orb_energy", "MJ/kg"}
+};
+const int NTELECHAN = sizeof(telechan)/sizeof(TelemetryChannel);
+
+// set up the telemetry ring named in the configuration
+static void OpenTelemetry (void)
+{
+	g_Telemetry.Close();
+	if (g_TelemetryName.empty()) return;
+	if (!g_Telemetry.Create (g_TelemetryName.c_str(), telechan, NTELECHAN, g_TelemetrySlots))
+		oapiWriteLog(const_cast<char *>("FlightDataRecMFD: cannot create telemetry ring"));
+}
 
-		//  log data to file
-		log_data();
+// start the network stream named in the configuration
+static void OpenStream (void)
+{
+	g_Stream.Stop();
+	if (g_StreamSpec.empty()) return;
+	if (!g_Stream.Start (g_StreamSpec.c_str(), telechan, NTELECHAN, g_StreamText,
+			g_StreamBatch, g_StreamFlush, g_StreamQueue))
+		oapiWriteLog(const_cast<char *>("FlightDataRecMFD: cannot start telemetry stream"));
+}
 
-		//sprintf(oapiDebugString(), "Tacc: %f   Vacc: %f", g_Data.ves_a_tan[g_Data.sample], g_Data.ves_a_rad[g_Data.sample]);
+// publish a ring sample to external readers; never waits for them
+static void PublishSample (int i)
+{
+	if (!g_Telemetry.Active() && !g_Stream.Active()) return;
+	float v[NTELECHAN];
+	v[0]  = g_Data.ves_alt[i];
+	v[1]  = g_Data.ves_pitch[i];
+	v[2]  = g_Data.ves_roll[i];
+	v[3]  = g_Data.ves_yaw[i];
+	v[4]  = g_Data.ves_v_rad[i];
+	v[5]  = g_Data.ves_v_tan[i];
+	v[6]  = g_Data.ves_a_rad[i];
+	v[7]  = g_Data.ves_a_tan[i];
+	v[8]  = g_Data.ves_a_g[i];
+	v[9]  = g_Data.ves_surf_lon[i];
+	v[10] = g_Data.ves_surf_lat[i];
+	v[11] = g_Data.ves_surf_hdg[i];
+	v[12] = g_Data.ves_dist[i];
+	v[13] = g_Data.ves_aoa[i];
+	v[14] = g_Data.ves_mach[i];
+	v[15] = g_Data.ves_lift[i];
+	v[16] = g_Data.ves_drag[i];
+	v[17] = g_Data.atm_t[i];
+	v[18] = g_Data.atm_stp[i];
+	v[19] = g_Data.atm_dynp[i];
+	v[20] = g_Data.atm_d[i];
+	v[21] = g_Data.eng_fuel_mass[i];
+	v[22] = g_Data.eng_fuel_rate[i];
+	v[23] = g_Data.eng_main_t[i];
+	v[24] = g_Data.eng_hover_t[i];
+	v[25] = (float)g_Data.smp_q[i];
+	v[26] = g_Data.int_dv[i];
+	v[27] = g_Data.int_gnd[i];
+	v[28] = g_Data.int_heat[i];
+	v[29] = g_Data.int_fuel[i];
+	v[30] = g_Data.fuel_resid[i];
+	v[31] = g_Data.orb_apo[i];
+	v[32] = g_Data.orb_peri[i];
+	v[33] = g_Data.orb_ecc[i];
+	v[34] = g_Data.orb_inc[i];
+	v[35] = g_Data.orb_t_apo[i];
+	v[36] = g_Data.orb_energy[i];
+	if (g_Telemetry.Active()) g_Telemetry.Publish (g_Data.sim_time[i], v);
+	if (g_Stream.Active()) g_Stream.Push (g_Data.sim_time[i], v);
+}
 
-		// get ready for next sample period
-		if (((g_Data.sample+1) % ndata) == 0) g_Data.sample = 0;
-		else g_Data.sample = g_Data.sample+1;
-		g_Data.tnext = simt + sample_dt;
+// store a grid sample in the data ring and log it
+static void StoreSample (const FDState &s, int interp)
+{
+	int i = g_Data.sample;
+
+	g_DataLock.WriteBegin();
+	g_Data.sim_time[i]  = (float)s.t;
+	g_Data.ves_alt[i]   = (float)s.v[ST_ALT];
+	g_Data.ves_pitch[i] = (float)s.v[ST_PITCH];
+	g_Data.ves_roll[i]  = (float)s.v[ST_ROLL];
+	g_Data.ves_yaw[i]   = (float)s.v[ST_YAW];
+	g_Data.ves_v_rad[i] = (float)s.v[ST_V_RAD];
+	g_Data.ves_v_tan[i] = (float)s.v[ST_V_TAN];
+
+	// accelerations are taken over the true interval between captured
+	// states, not the nominal sample interval
+	g_Data.ves_a_rad[i] = (float)g_Resample.Rate (ST_V_RAD);
+	g_Data.ves_a_tan[i] = (float)g_Resample.Rate (ST_V_TAN);
+	// ---------- G meter, somewhat agrees with Dan Polli's DG3 G meter -----------
+	g_Data.ves_a_g[i]   = (float)(fabs (g_Resample.Rate (ST_V_MAG))/G);
+
+	if (g_Targets.Count()) {
+		g_Data.ves_surf_lon[i] = (float)s.v[ST_SURF_LON];
+		g_Data.ves_surf_lat[i] = (float)s.v[ST_SURF_LAT];
+		g_Data.ves_surf_hdg[i] = (float)s.v[ST_SURF_HDG];
+		g_Data.ves_dist[i]     = (float)s.v[ST_DIST];
+	}
+	g_Data.ves_aoa[i]  = (float)s.v[ST_AOA];
+	g_Data.ves_mach[i] = (float)s.v[ST_MACH];
+	g_Data.ves_lift[i] = (float)s.v[ST_LIFT];
+	g_Data.ves_drag[i] = (float)s.v[ST_DRAG];
+	g_Data.atm_t[i]    = (float)s.v[ST_ATM_T];
+	g_Data.atm_stp[i]  = (float)s.v[ST_ATM_STP];
+	g_Data.atm_dynp[i] = (float)s.v[ST_ATM_DYNP];
+	g_Data.atm_d[i]    = (float)s.v[ST_ATM_D];
+	g_Data.eng_fuel_mass[i] = (float)s.v[ST_FUEL_MASS];
+	g_Data.eng_fuel_rate[i] = (float)s.v[ST_FUEL_RATE];
+	g_Data.eng_main_t[i]    = (float)s.v[ST_MAIN_T];
+	g_Data.eng_hover_t[i]   = (float)s.v[ST_HOVER_T];
+	g_Data.smp_q[i] = interp;
+	g_Integrals.Update (s, R);
+	g_Data.int_dv[i]     = (float)g_Integrals.Value (IN_DV);
+	g_Data.int_gnd[i]    = (float)g_Integrals.Value (IN_GROUND);
+	g_Data.int_heat[i]   = (float)g_Integrals.Value (IN_HEAT);
+	g_Data.int_fuel[i]   = (float)g_Integrals.Value (IN_FUEL);
+	g_Data.fuel_resid[i] = (float)g_Integrals.Value (IN_FUEL_RESID);
+	g_Data.orb_apo[i]    = (float)s.v[ST_ORB_APO];
+	g_Data.orb_peri[i]   = (float)s.v[ST_ORB_PERI];
+	g_Data.orb_ecc[i]    = (float)s.v[ST_ORB_ECC];
+	g_Data.orb_inc[i]    = (float)s.v[ST_ORB_INC];
+	g_Data.orb_t_apo[i]  = (float)TimeToApoapsis (s.v[ST_ORB_MANOM], s.v[ST_ORB_PERIOD]);
+	g_Data.orb_energy[i] = (float)s.v[ST_ORB_ENERGY];
+	if (g_Data.count < ndata) g_Data.count++;
+	g_Data.total++;
+
+	// the events go into the marks together with their sample, so the
+	// plots never see one without the other
+	int k, nev = 0;
+	if (events)
+		nev = g_Events.Update (g_Data.total-1, s.t, s.v[ST_ALT], s.v[ST_ALT_GND], s.v[ST_V_RAD],
+			s.v[ST_ATM_DYNP], g_Data.ves_a_g[i], s.v[ST_MAIN_T], s.v[ST_FUEL_MASS], s.v[ST_FUEL_RATE]);
+	for (k = 0; k < nev; k++) g_Marks.ev[g_Marks.count++ % NEVMARK] = g_Events.Event (k);
+
+	// get ready for next sample period
+	if (((g_Data.sample+1) % ndata) == 0) g_Data.sample = 0;
+	else g_Data.sample = g_Data.sample+1;
+	g_DataLock.WriteEnd();
+	PublishSample (i);
+	for (k = 0; k < nev; k++) {
+		const FlightEvent &ev = g_Events.Event (k);
+		log_event (ev.t, FlightEventName (ev.type), "%g", ev.value);
 	}
 
+	//  log data to file (in black-box mode only around trigger events)
+	if (blackbox) BlackBoxSample (i, s.v[ST_ALT_GND]);
+	else WriteSample (i);
+}
+
+DLLCLBK void opcPreStep (double simt, double simdt, double mjd){
+	
+  // send a partial frame once its flush interval is over
+  if (g_Stream.Active()) g_Stream.Poll();
+  if (g_Journal.Active()) g_Journal.Poll();
+
+  if (!paused) {
+	if (g_Watchdog.Enabled()) {
+		g_Watchdog.Begin();
+		FlushDeferred (g_Watchdog.Level() >= WD_DEFER_LOG ? g_Watchdog.Budget()*0.5 : -1.0);
+	}
+
+	if (simt >= g_Data.tnext) {
+		FDState s;
+		int interp;
+		double dt = (adaptive ? 1.0/g_RateCtl.Rate() : sample_dt);
+
+		if (g_Resample.Interval() != dt) g_Resample.SetInterval (dt);
+
+		// capture the state at this frame, then emit every grid point
+		// k*sample_dt passed since the previous capture
+		CaptureState (oapiGetFocusInterface(), simt, s, g_Watchdog.Level() < WD_NO_OPTIONAL);
+		g_Resample.Push (s);
+		while (g_Resample.Emit (s, interp))
+			StoreSample (s, interp);
+
+		// let the flight dynamics of the last interval pick the next rate
+		if (adaptive && g_Resample.Captures() == 2) {
+			RateSignals sig;
+			double rate = g_RateCtl.Rate();
+			sig.a_g       = fabs (g_Resample.Rate (ST_V_MAG))/G;
+			sig.dynp_rate = g_Resample.Rate (ST_ATM_DYNP);
+			sig.thr_rate  = g_Resample.Rate (ST_MAIN_T);
+			sig.aoa_rate  = g_Resample.Rate (ST_AOA);
+			if (g_RateCtl.Update (simt, sig)) {
+				log_event (simt, "RATE", "%g%c%g%c%s%c%.2f", rate, delim_char, g_RateCtl.Rate(),
+					delim_char, g_RateCtl.Reason(), delim_char, g_RateCtl.Activity());
+				g_Resample.SetInterval (1.0/g_RateCtl.Rate());
+			}
+		}
+
+		g_Data.tnext = g_Resample.Next();
+	}
+
+	// shed or restore work if the step ran over its budget
+	if (g_Watchdog.Enabled() && g_Watchdog.End (simt))
+		log_event (simt, "DEGRADE", "%s%c%s%c%.3f%c%.0f", WatchdogLevelName (g_Watchdog.PrevLevel()), delim_char,
+			WatchdogLevelName (g_Watchdog.Level()), delim_char, g_Watchdog.PrevDuration(), delim_char, g_Watchdog.StepTime());
   }
 }
 
+DLLCLBK void opcDeleteVessel (OBJHANDLE hVessel)
+{
+	if (!paused && blackbox) {
+		char name[256], reason[280];
+		oapiGetObjectName (hVessel, name, 256);
+		sprintf (reason, "VESSEL_LOST%c%s", delim_char, name);
+		BlackBoxTrigger (reason);
+	}
+	// a vessel tracked as a range target is gone with its handle
+	for (int k = g_Targets.Count()-1; k >= 0; k--)
+		if (g_Targets.Object (k) == hVessel) g_Targets.Remove (k);
+}
+
 DLLCLBK void opcOpenRenderViewport (HWND renderWnd, DWORD width, DWORD height, BOOL fullscreen)
 {
-	PurgeDataPoints();
-	if (tgt_base[0] != '\0') { 
+	// a checkpoint named in the scenario may already have refilled the ring
+	if (!g_Restored) PurgeDataPoints();
+	g_Targets.Clear();
+	if (!tgt_base.empty()) { 
 		VESSELSTATUS v_stat;	
 		VESSEL *v = oapiGetFocusInterface();
 
 		v->GetStatus(v_stat);
-		hbase = oapiGetBaseByName(v_stat.rbody, const_cast<char *>(tgt_base.c_str()));
-		if (hbase != NULL) {
-			oapiGetBaseEquPos(hbase, &b_pos.LONG, &b_pos.LAT, &b_pos.RADIUS);
-		} 
+		std::string list = tgt_base;
+		SetTargets (v_stat.rbody, list);
+		tgt_base = list;  // names not in this scenario are kept for a later one
 	}
 }
 
+DLLCLBK void opcCloseRenderViewport (void)
+{
+	g_Restored = false;
+	g_LogShift = 0.0;
+	g_OrbitRef = 0;   // handles of the next session may be reused
+}
+
 
 // ==============================================================
 // FlightDataRec MFD implementation
@@ -330,44 +770,95 @@ DLLCLBK void opcOpenRenderViewport (HWND renderWnd, DWORD width, DWORD height, B
 FlightDataRecMFD::FlightDataRecMFD (DWORD w, DWORD h, VESSEL *vessel)
 : GraphMFD (w, h, vessel)
 {
-	int g;
+	int g, r;
 
 	ref_alt = new float[ndata];
 	ref_tvel = new float[ndata];
 	ref = vessel->GetSurfaceRef();
 
+	snap.sim_time  = new float[ndata];
+	snap.ves_alt   = new float[ndata];
+	snap.ves_v_rad = new float[ndata];
+	snap.ves_v_tan = new float[ndata];
+	snap.ves_a_rad = new float[ndata];
+	snap.ves_a_tan = new float[ndata];
+	snap.ves_dist  = new float[ndata];
+
+	// the graphs are bound to the min/max reduced series, at most two
+	// points per pixel column of the plot area. GraphMFD keeps about a
+	// fifth of the MFD width for tick labels and margins, and the buckets
+	// cut at either end of the history take two more columns. With two
+	// samples a column or fewer the reduction saves nothing, and the
+	// samples are bound as they are.
+	int ncol = (int)w*4/5 - 2;
+	for (g = 0; g < NPLOT; g++) dec[g].Setup (ndata, ncol);
+	raw = (dec[0].Span() <= 2);
+	nplt = (raw ? ndata : dec[0].MaxPoints());
+	dpt = new DecPoint[nplt];
+	for (g = 0; g < NPLOT; g++) {
+		plt_x[g] = new float[nplt];
+		plt_y[g] = new float[nplt];
+	}
+	for (g = 0; g < 3; g++)
+		for (r = 0; r < REF_NRUN; r++) {
+			rplt_x[g][r] = new float[nplt];
+			rplt_y[g][r] = new float[nplt];
+		}
+	for (g = 0; g < NPLOT; g++)
+		for (r = 0; r < NEVMARK; r++) {
+			mplt_x[g][r] = new float[NMARKPT];
+			mplt_y[g][r] = new float[NMARKPT];
+		}
+	plt_ofs = 0;
+	fed = 0;
+	fed_purges = -1;
+	TakeSnapshot();
+	UpdatePlots();
+	UpdateReference (0.0f, 0.0f);
+
 	g = AddGraph ();
 	SetAxisTitle (g, 0, const_cast<char *>("Vtan: m/s"));
 	SetAxisTitle (g, 1, const_cast<char *>("Alt: km"));
-	AddPlot (g, g_Data.ves_v_tan, g_Data.ves_alt, ndata, 1, &g_Data.sample);
+	AddPlot (g, plt_x[0], plt_y[0], nplt, 1, &plt_ofs);
+	AddPlot (g, ref_tvel, ref_alt, ndata, 2);
+	for (r = 0; r < REF_NRUN; r++) AddPlot (g, rplt_x[0][r], rplt_y[0][r], nplt, 3, &plt_ofs);
+	for (r = 0; r < NEVMARK; r++) AddPlot (g, mplt_x[0][r], mplt_y[0][r], NMARKPT, 2);
 
 	g = AddGraph ();
 	SetAxisTitle (g, 0, const_cast<char *>("Vrad: m/s"));
 	SetAxisTitle (g, 1, const_cast<char *>("Alt: km"));
-	AddPlot (g, g_Data.ves_v_rad, g_Data.ves_alt, ndata, 1, &g_Data.sample);
+	AddPlot (g, plt_x[1], plt_y[1], nplt, 1, &plt_ofs);
+	for (r = 0; r < REF_NRUN; r++) AddPlot (g, rplt_x[1][r], rplt_y[1][r], nplt, 3, &plt_ofs);
+	for (r = 0; r < NEVMARK; r++) AddPlot (g, mplt_x[1][r], mplt_y[1][r], NMARKPT, 2);
 
 	g = AddGraph ();
 	SetAxisTitle (g, 0, const_cast<char *>("Time: s"));
 	SetAxisTitle (g, 1, const_cast<char *>("Vacc: m/s^2"));
-	AddPlot (g, g_Data.sim_time, g_Data.ves_a_rad, ndata, 1, &g_Data.sample);
+	AddPlot (g, plt_x[2], plt_y[2], nplt, 1, &plt_ofs);
+	for (r = 0; r < NEVMARK; r++) AddPlot (g, mplt_x[2][r], mplt_y[2][r], NMARKPT, 2);
 
 
 	g = AddGraph ();
 	SetAxisTitle (g, 0, const_cast<char *>("RTT: km"));
 	SetAxisTitle (g, 1, const_cast<char *>("Alt: km"));
-	AddPlot (g, g_Data.ves_dist, g_Data.ves_alt, ndata, 1, &g_Data.sample);
+	AddPlot (g, plt_x[3], plt_y[3], nplt, 1, &plt_ofs);
+	for (r = 0; r < REF_NRUN; r++) AddPlot (g, rplt_x[2][r], rplt_y[2][r], nplt, 3, &plt_ofs);
+	for (r = 0; r < NEVMARK; r++) AddPlot (g, mplt_x[3][r], mplt_y[3][r], NMARKPT, 2);
 
 	g = AddGraph ();
 	SetAxisTitle (g, 0, const_cast<char *>("RTT: km"));
 	SetAxisTitle (g, 1, const_cast<char *>("Vtan: m/s"));
-    AddPlot (g, g_Data.ves_dist, g_Data.ves_v_tan, ndata, 1, &g_Data.sample);
+    AddPlot (g, plt_x[4], plt_y[4], nplt, 1, &plt_ofs);
+	for (r = 0; r < NEVMARK; r++) AddPlot (g, mplt_x[4][r], mplt_y[4][r], NMARKPT, 2);
 
 	g = AddGraph ();	
 	SetAxisTitle (g, 0, const_cast<char *>("Time: s"));
 	SetAxisTitle (g, 1, const_cast<char *>("Tacc: m/s^2"));
-	AddPlot (g, g_Data.sim_time, g_Data.ves_a_tan, ndata, 1, &g_Data.sample);
+	AddPlot (g, plt_x[5], plt_y[5], nplt, 1, &plt_ofs);
+	for (r = 0; r < NEVMARK; r++) AddPlot (g, mplt_x[5][r], mplt_y[5][r], NMARKPT, 2);
 
 	page = 0;
+	alt_auto = vrad_auto = vtan_auto = true;
 }
 
 FlightDataRecMFD::~FlightDataRecMFD ()
@@ -375,8 +866,168 @@ FlightDataRecMFD::~FlightDataRecMFD ()
 	WriteConfig();
 	delete []ref_alt;
 	delete []ref_tvel;
+	delete []snap.sim_time;
+	delete []snap.ves_alt;
+	delete []snap.ves_v_rad;
+	delete []snap.ves_v_tan;
+	delete []snap.ves_a_rad;
+	delete []snap.ves_a_tan;
+	delete []snap.ves_dist;
+	for (int g = 0; g < NPLOT; g++) {
+		delete []plt_x[g];
+		delete []plt_y[g];
+	}
+	for (int g = 0; g < 3; g++)
+		for (int r = 0; r < REF_NRUN; r++) {
+			delete []rplt_x[g][r];
+			delete []rplt_y[g][r];
+		}
+	for (int g = 0; g < NPLOT; g++)
+		for (int r = 0; r < NEVMARK; r++) {
+			delete []mplt_x[g][r];
+			delete []mplt_y[g][r];
+		}
+	delete []dpt;
+}
+
+// copy the plotted channels out of the recorder ring. The copy is retried
+// until no sample was stored while it was taken, so the plots never see a
+// half-written sample; the sampler is never held up.
+void FlightDataRecMFD::TakeSnapshot (void)
+{
+	unsigned seq;
+	do {
+		seq = g_DataLock.ReadBegin();
+		snap.sample = g_Data.sample;
+		snap.count  = g_Data.count;
+		snap.total  = g_Data.total;
+		snap.purges = g_Data.purges;
+		memcpy (snap.sim_time,  g_Data.sim_time,  ndata*sizeof(float));
+		memcpy (snap.ves_alt,   g_Data.ves_alt,   ndata*sizeof(float));
+		memcpy (snap.ves_v_rad, g_Data.ves_v_rad, ndata*sizeof(float));
+		memcpy (snap.ves_v_tan, g_Data.ves_v_tan, ndata*sizeof(float));
+		memcpy (snap.ves_a_rad, g_Data.ves_a_rad, ndata*sizeof(float));
+		memcpy (snap.ves_a_tan, g_Data.ves_a_tan, ndata*sizeof(float));
+		memcpy (snap.ves_dist,  g_Data.ves_dist,  ndata*sizeof(float));
+		snap.marks = g_Marks;
+	} while (g_DataLock.ReadRetry (seq));
+}
+
+// feed the samples stored since the last frame to the plot reducers and
+// refresh the arrays bound to the graphs. Unused entries repeat the newest
+// point, so they neither draw nor widen the auto range.
+void FlightDataRecMFD::UpdatePlots (void)
+{
+	float *src[NPLOT][2] = {
+		{snap.ves_v_tan, snap.ves_alt},
+		{snap.ves_v_rad, snap.ves_alt},
+		{snap.sim_time,  snap.ves_a_rad},
+		{snap.ves_dist,  snap.ves_alt},
+		{snap.ves_dist,  snap.ves_v_tan},
+		{snap.sim_time,  snap.ves_a_tan}
+	};
+	int g, i, n;
+	long first = snap.total-snap.count;
+
+	if (raw) {
+		for (g = 0; g < NPLOT; g++) {
+			for (i = 0; i < snap.count; i++) {
+				n = (snap.sample - snap.count + i + ndata) % ndata;
+				plt_x[g][i] = src[g][0][n], plt_y[g][i] = src[g][1][n];
+			}
+			for (; i < nplt; i++)
+				plt_x[g][i] = (i ? plt_x[g][i-1] : 0.0f), plt_y[g][i] = (i ? plt_y[g][i-1] : 0.0f);
+		}
+		UpdateMarks (src);
+		return;
+	}
+
+	// purged, or more new samples than the ring holds: start over
+	if (fed_purges != snap.purges || fed < first) {
+		for (g = 0; g < NPLOT; g++) dec[g].Reset();
+		fed = first;
+		fed_purges = snap.purges;
+	}
+	for (; fed < snap.total; fed++) {
+		i = (int)((snap.sample - (snap.total-fed) + ndata) % ndata);
+		for (g = 0; g < NPLOT; g++) dec[g].Append (src[g][0][i], src[g][1][i]);
+	}
+
+	for (g = 0; g < NPLOT; g++) {
+		n = dec[g].Reduce (dpt);
+		for (i = 0; i < n; i++)
+			plt_x[g][i] = dpt[i].x, plt_y[g][i] = dpt[i].y;
+		for (; i < nplt; i++)
+			plt_x[g][i] = (n ? dpt[n-1].x : 0.0f), plt_y[g][i] = (n ? dpt[n-1].y : 0.0f);
+	}
+	UpdateMarks (src);
+}
+
+// place a diamond on every graph for each of the newest events whose
+// sample is still in the ring. The diamonds are sized to the extent of
+// the recorded series and kept inside it, so they never widen an auto
+// range; unused marks collapse onto the newest point.
+void FlightDataRecMFD::UpdateMarks (float *src[NPLOT][2])
+{
+	static const float dx[NMARKPT] = {-1.0f, 0.0f, 1.0f, 0.0f, -1.0f};
+	static const float dy[NMARKPT] = {0.0f, 1.0f, 0.0f, -1.0f, 0.0f};
+	const float SIZE = 0.02f;   // half width of a diamond, fraction of the extent
+	long first = snap.total-snap.count;
+	float xmin, xmax, ymin, ymax, x, y;
+	int g, m, k, i;
+
+	for (g = 0; g < NPLOT; g++) {
+		FindRange (plt_x[g], nplt, xmin, xmax);
+		FindRange (plt_y[g], nplt, ymin, ymax);
+		for (m = 0; m < NEVMARK; m++) {
+			float *mx = mplt_x[g][m], *my = mplt_y[g][m];
+			long e = snap.marks.count-1-m;
+			const FlightEvent &ev = snap.marks.ev[(e >= 0 ? e : 0) % NEVMARK];
+			if (e < 0 || ev.sample < first || ev.sample >= snap.total) {
+				for (k = 0; k < NMARKPT; k++)
+					mx[k] = plt_x[g][nplt-1], my[k] = plt_y[g][nplt-1];
+				continue;
+			}
+			i = (int)((snap.sample - (snap.total-ev.sample) + ndata) % ndata);
+			for (k = 0; k < NMARKPT; k++) {
+				x = src[g][0][i] + dx[k]*SIZE*(xmax-xmin);
+				y = src[g][1][i] + dy[k]*SIZE*(ymax-ymin);
+				mx[k] = (x < xmin ? xmin : x > xmax ? xmax : x);
+				my[k] = (y < ymin ? ymin : y > ymax ? ymax : y);
+			}
+		}
+	}
 }
 
+// bind the part of the reference flight inside the altitude window to
+// the overlay plots, one plot per altitude run, sampled down to the plot
+// length. A run with nothing in view, or a graph the reference cannot
+// show, collapses onto the newest point of the recorded series.
+void FlightDataRecMFD::UpdateReference (float altmin, float altmax)
+{
+	static const int gplt[3] = {0, 1, 3};   // Vtan/Alt, Vrad/Alt, Alt/Range
+	int g, r, i, n, first;
+
+	for (r = 0; r < REF_NRUN; r++) {
+		n = (r < g_Ref.Runs() ? g_Ref.Find (r, altmin, altmax, first) : 0);
+		for (g = 0; g < 3; g++) {
+			float *x = rplt_x[g][r], *y = rplt_y[g][r];
+			if (!n || (g == 2 && !g_Ref.HasDist())) {
+				for (i = 0; i < nplt; i++)
+					x[i] = plt_x[gplt[g]][nplt-1], y[i] = plt_y[gplt[g]][nplt-1];
+				continue;
+			}
+			for (i = 0; i < nplt; i++) {
+				int k = (n <= nplt ? (i < n ? i : n-1) : (int)((long long)i*(n-1)/(nplt-1)));
+				const RefPoint &p = g_Ref.Point (r, first+k);
+				x[i] = (g == 0 ? p.v_tan : g == 1 ? p.v_rad : p.dist);
+				y[i] = p.alt;
+			}
+		}
+	}
+}
+
+// circular orbit velocity over the altitude axis of the Vtan/Alt graph
 void FlightDataRecMFD::InitReferences (void)
 {
 	const double G = 6.67259e-11;
@@ -384,7 +1035,7 @@ void FlightDataRecMFD::InitReferences (void)
 	R = oapiGetSize (ref);
 	double f0 = graph[0].data_min;
 	double f1 = (graph[0].data_max - graph[0].data_min)/(double)(ndata-1);
-	double f2 = sqrt (G*M)*1e-3;
+	double f2 = sqrt (G*M);
 	int i;
 	for (i = 0; i < ndata; i++) {
 		ref_alt[i]  = (float)(f0 + i * f1);
@@ -409,18 +1060,18 @@ bool FlightDataRecMFD::ConsumeKeyBuffered (DWORD key)
 	bool RateInput (void *id, char *str, void *data);
 	bool PathInput (void *id, char *str, void *data);
 	bool FileInput (void *id, char *str, void *data);
-	void IncrementFileCounter(void);
+	bool RefInput (void *id, char *str, void *data);
 
 	switch (key) {
 	case OAPI_KEY_A:
-		if (paused) paused = 0;
-		else { paused = 1; if (auto_inc) IncrementFileCounter(); }
+		if (paused) { paused = 0; g_Resample.Reset(); g_BlackBox.Reset(); g_Events.Reset(); g_Integrals.Break(); }
+		else { paused = 1; FlushDeferred (-1.0); CloseSession(); if (auto_inc) IncrementFileCounter(); }
 		return true;
 	case OAPI_KEY_P:
-		page = (page+1) % 2;
+		page = (page+1) % NPAGE;
 		return true;
     case OAPI_KEY_T:
-		oapiOpenInputBox (const_cast<char *>("Target Base:"), BaseInput, 0, 20, (void*)this);
+		oapiOpenInputBox (const_cast<char *>("Targets (comma separated):"), BaseInput, 0, 40, (void*)this);
 		return true;
 	case OAPI_KEY_D:
 		oapiOpenInputBox (const_cast<char *>("Delimiter character:"), DelimInput, 0, 20, (void*)this);
@@ -439,6 +1090,20 @@ bool FlightDataRecMFD::ConsumeKeyBuffered (DWORD key)
 	case OAPI_KEY_I:
 		auto_inc = (auto_inc+1) % 2;
 		return true;
+	case OAPI_KEY_V:
+		adaptive = (adaptive+1) % 2;
+		if (adaptive) g_RateCtl.Reset (1.0/sample_dt);
+		return true;
+	case OAPI_KEY_B:
+		blackbox = (blackbox+1) % 2;
+		g_BlackBox.Reset();
+		return true;
+	case OAPI_KEY_K:
+		if (!paused && blackbox) BlackBoxTrigger ("KEY");
+		return true;
+	case OAPI_KEY_L:
+		oapiOpenInputBox (const_cast<char *>("Reference log (- for none):"), RefInput, 0, 40, (void*)this);
+		return true;
 	}
 	return false;
 }
@@ -446,15 +1111,15 @@ bool FlightDataRecMFD::ConsumeKeyBuffered (DWORD key)
 bool FlightDataRecMFD::ConsumeButton (int bt, int event)
 {
 	if (!(event & PANEL_MOUSE_LBDOWN)) return false;
-	static const DWORD btkey[9] = { OAPI_KEY_T, OAPI_KEY_D, OAPI_KEY_A, OAPI_KEY_P, OAPI_KEY_U,
-									OAPI_KEY_R, OAPI_KEY_H, OAPI_KEY_F, OAPI_KEY_I};
-	if (bt < 9) return ConsumeKeyBuffered (btkey[bt]);
+	static const DWORD btkey[12] = { OAPI_KEY_T, OAPI_KEY_D, OAPI_KEY_A, OAPI_KEY_P, OAPI_KEY_U,
+									OAPI_KEY_R, OAPI_KEY_H, OAPI_KEY_F, OAPI_KEY_V, OAPI_KEY_B, OAPI_KEY_K, OAPI_KEY_I};
+	if (bt < 12 && btkey[bt]) return ConsumeKeyBuffered (btkey[bt]);
 	else return false;
 }
 
 char *FlightDataRecMFD::ButtonLabel (int bt)
 {
-	static const char *label[12] = {"TGT", "DLM", "DA", "DIS", "PUR", "RAT", "PTH", "FLE", "", "", "", "INC"};
+	static const char *label[12] = {"TGT", "DLM", "DA", "DIS", "PUR", "RAT", "PTH", "FLE", "ADP", "BBX", "TRG", "INC"};
 	return (bt < 12 ? const_cast<char *>(label[bt]) : 0);
 }
 
@@ -469,9 +1134,9 @@ int FlightDataRecMFD::ButtonMenu (const MFDBUTTONMENU **menu) const
 		{"sample Rate", 0, 'R'},
 		{"data patH", 0, 'H'},
 		{"data File name", 0, 'F'},
-		{"", 0, '\0'},
-		{"", 0, '\0'},
-		{"", 0, '\0'},
+		{"adaptiVe rate toggle", 0, 'V'},
+		{"Black box toggle", 0, 'B'},
+		{"Kick black box trigger", 0, 'K'},
 		{"auto Increment toggle", 0, 'I'},
 	};
 	if (menu) *menu = mnu;
@@ -486,11 +1151,29 @@ void FlightDataRecMFD::Update (HDC hDC)
 
 	MFDUpdate(hDC, cw, ch);
 	title[0] = '\0';
-    strcpy(title, "Flight Data Recorder");
+	if (!paused && g_Watchdog.Enabled())
+		sprintf(title, "FDR %.1f%% over", g_Watchdog.HitRate()*100.0);
+	else
+		strcpy(title, "Flight Data Recorder");
 	Title (hDC, title);
 
   if (!paused) {
-	FindRange (g_Data.ves_alt, ndata, altmin, altmax);
+	if (adaptive) TextXY(hDC, 21, 0, YELLOW, BLACK, "%.2g/s", g_RateCtl.Rate());
+	if (blackbox) {
+		if (g_BlackBox.Capturing()) TextXY(hDC, 26, 0, RED, BLACK, "REC");
+		else TextXY(hDC, 26, 0, YELLOW, BLACK, "BBX");
+	}
+	if (g_Watchdog.Level() >= WD_NO_PLOT) {
+		TextXY(hDC, 3, 12, RED, BLACK, "PLOTS SUSPENDED: OVER BUDGET");
+		return;
+	}
+	// the refresh is charged to the next recorder step, so shedding it
+	// shows in the budget
+	std::chrono::steady_clock::time_point tpaint = std::chrono::steady_clock::now();
+	TakeSnapshot();
+	UpdatePlots();
+	// the reduction keeps the extremes, so the altitude range is exact
+	FindRange (plt_y[0], nplt, altmin, altmax);
 	if (altmin > altmax)
 		tmp = altmin, altmin = altmax, altmax = tmp;
 
@@ -501,12 +1184,13 @@ void FlightDataRecMFD::Update (HDC hDC)
 		SetRange (3, 1, altmin, altmax);
 
 		InitReferences();
+		UpdateReference (altmin, altmax);
 
 		SetAutoRange (0, 0, 0); // Vel
 		SetAutoRange (1, 0, 0); // Vel
 		SetAutoRange (2, 0, 0); // Time
 		SetAutoRange (2, 1, 0); // Vacc
-		SetAutoRange (3, 0); // RTT
+		SetAutoRange (3, 0, 0); // RTT
 		SetAutoRange (4, 0); // RTT
 		SetAutoRange (4, 1, 0); // Vel
 		SetAutoRange (5, 0, 0); // Time
@@ -525,17 +1209,59 @@ void FlightDataRecMFD::Update (HDC hDC)
 				Plot (hDC, 4, (H+ch)/3, ((H+ch)/3)*2, "Vtan/Range");
 				Plot (hDC, 5, ((H+ch)/3)*2, H, "Tan acc");
 				break;
+			case 2:
+				TextXY(hDC, 30, 0, WHITE, BLACK, "PG2");
+				ShowStats (hDC, false);
+				break;
+			case 3:
+				TextXY(hDC, 30, 0, WHITE, BLACK, "PG3");
+				ShowStats (hDC, true);
+				break;
+			case 4:
+				TextXY(hDC, 30, 0, WHITE, BLACK, "PG4");
+				ShowTargets (hDC);
+				break;
 		}
+		if (g_Watchdog.Enabled()) g_Watchdog.Charge (tpaint);
 	} else {
-		strcpy(rng_target, "TGT BASE: ");
-		if (tgt_base[0] == '\0') strcat(rng_target, " !!  NONE  !!");
-		else strcat(rng_target, tgt_base.c_str());
+		if (g_Targets.Count() > 1)
+			sprintf(rng_target, "TGT BASE: %.20s +%d", g_Targets.Name(0), g_Targets.Count()-1);
+		else if (g_Targets.Count())
+			sprintf(rng_target, "TGT BASE: %.20s", g_Targets.Name(0));
+		else if (tgt_base.empty()) strcpy(rng_target, "TGT BASE:  !!  NONE  !!");
+		else sprintf(rng_target, "TGT BASE: %.20s (not found)", tgt_base.c_str());
 		TextXY(hDC, 0, 16, YELLOW, BLACK, "Rate: %.3f", (1/sample_dt));
 		TextXY(hDC, 13, 16, YELLOW, BLACK, "samples/sec");
+		if (adaptive) TextXY(hDC, 0, 17, YELLOW, BLACK, "Adaptive: %g - %g samples/sec", g_RateCtl.MinRate(), g_RateCtl.MaxRate());
+		else TextXY(hDC, 0, 17, YELLOW, BLACK, "Adaptive: OFF");
+		if (blackbox) TextXY(hDC, 0, 18, YELLOW, BLACK, "Black box: -%gs +%gs  G>%g", g_BlackBox.Pre(), g_BlackBox.Post(), g_BlackBox.GLimit());
+		else TextXY(hDC, 0, 18, YELLOW, BLACK, "Black box: OFF");
+		if (g_Watchdog.Enabled()) TextXY(hDC, 0, 19, YELLOW, BLACK, "Budget: %gus  over %.1f%%", g_Watchdog.Budget(), g_Watchdog.HitRate()*100.0);
+		else TextXY(hDC, 0, 19, YELLOW, BLACK, "Budget: OFF");
+		if (g_Telemetry.Active()) TextXY(hDC, 0, 20, YELLOW, BLACK, "Telemetry: %s  %llu sent", g_Telemetry.Name(), g_Telemetry.Published());
+		else TextXY(hDC, 0, 20, YELLOW, BLACK, "Telemetry: OFF");
+		if (g_Stream.Active()) {
+			StreamStats ss;
+			g_Stream.GetStats (ss);
+			TextXY(hDC, 0, 21, YELLOW, BLACK, "Net: %s  %d clients  %llu frames  drop %llu/%llu",
+				g_Stream.Spec(), ss.clients, ss.frames, ss.handoff_drops, ss.client_drops);
+		}
+		else TextXY(hDC, 0, 21, YELLOW, BLACK, "Net: OFF");
+		if (g_JournalRows > 0)
+			TextXY(hDC, 0, 22, g_Journal.Failed() ? RED : YELLOW, BLACK, "Journal: %d/block  sync %d blk %dms  %lld synced",
+				g_JournalRows, g_JournalSync, g_JournalSyncMs, g_Journal.Syncs());
+		else TextXY(hDC, 0, 22, YELLOW, BLACK, "Journal: OFF");
+		if (g_RotateMB > 0 || g_RotateMin > 0)
+			TextXY(hDC, 0, 23, YELLOW, BLACK, "Rotate: %gMB %gmin  part %d  %d queued  %lld done",
+				g_RotateMB, g_RotateMin, g_Seg.part, g_Segments.Pending(), g_Segments.Done());
+		else TextXY(hDC, 0, 23, YELLOW, BLACK, "Rotate: OFF");
 		
 		TextXY(hDC, 7, 12, RED, BLACK, "DATA ACQUISITION PAUSED");
 		
 		TextXY(hDC, 0, 8, YELLOW, BLACK, rng_target);
+		if (g_Ref.Loaded())
+			TextXY(hDC, 0, 9, YELLOW, BLACK, "Ref: %s", std::filesystem::path(g_Ref.Path()).filename().string().c_str());
+		else TextXY(hDC, 0, 9, YELLOW, BLACK, "Ref: NONE");
 
 		TextXY(hDC, 0, 5, YELLOW, BLACK, "Delimiter: '");
 		TextXY(hDC, 12, 5, YELLOW, BLACK, "%c'", delim_char);
@@ -559,6 +1285,81 @@ void FlightDataRecMFD::Update (HDC hDC)
 
 }
 
+// figure for the statistics page, at most 6 characters where it can
+static void StatText (char *buf, double v)
+{
+	static const char sfx[] = " kMGT";
+	int k = 0;
+	while (fabs (v) >= 999.5 && k < 4) v /= 1000.0, k++;
+	if (k) sprintf (buf, "%.3g%c", v, sfx[k]);
+	else sprintf (buf, "%.3g", v);
+}
+
+// min/max/mean/sd and p50/p95/p99 of the catalog channels, over the
+// session being logged or over the sliding window
+void FlightDataRecMFD::ShowStats (HDC hDC, bool window)
+{
+	static const double q[3] = {0.5, 0.95, 0.99};
+	ChannelStats ws;
+	char buf[4][32];
+	float p[3];
+	int c, k;
+
+	if (window) TextXY(hDC, 0, 1, YELLOW, BLACK, "WINDOW %gs", g_Window[0].Span());
+	else if (g_Session.Active())
+		TextXY(hDC, 0, 1, YELLOW, BLACK, "SESSION %.0fs", g_Session.Entry().t_end-g_Session.Entry().t_start);
+	else {
+		TextXY(hDC, 0, 1, YELLOW, BLACK, "SESSION: NOT LOGGING");
+		return;
+	}
+	TextXY(hDC, 5, 2, WHITE, BLACK, "min    max    mean   sd");
+	TextXY(hDC, 5, 3, WHITE, BLACK, "p50    p95    p99");
+	for (c = 0; c < NCATCH; c++) {
+		const ChannelStats *s = &g_Session.Stats (c);
+		if (window) g_Window[c].Get (ws), s = &ws;
+		if (!c) TextXY(hDC, 22, 1, YELLOW, BLACK, "n %lld", s->m.n);
+		if (!s->m.n) continue;
+		s->q.Quantiles (q, 3, p);
+		StatText (buf[0], s->m.vmin);
+		StatText (buf[1], s->m.vmax);
+		StatText (buf[2], s->m.mean);
+		StatText (buf[3], s->m.Sd());
+		TextXY(hDC, 0, 4+2*c, GREEN, BLACK, catchname[c]);
+		for (k = 0; k < 4; k++) TextXY(hDC, 5+7*k, 4+2*c, YELLOW, BLACK, buf[k]);
+		for (k = 0; k < 3; k++) {
+			StatText (buf[k], p[k]);
+			TextXY(hDC, 5+7*k, 5+2*c, YELLOW, BLACK, buf[k]);
+		}
+	}
+}
+
+// range, bearing and closest approach of every range target; the kind
+// is marked B(ase), V(essel) or S(tation)
+void FlightDataRecMFD::ShowTargets (HDC hDC)
+{
+	static const char kindch[NTGTKIND] = {'B', 'V', 'S'};
+	char buf[3][32];
+	int k, n = g_Targets.Count();
+
+	if (!n) {
+		TextXY(hDC, 0, 1, YELLOW, BLACK, "TARGETS: NONE");
+		return;
+	}
+	TextXY(hDC, 0, 1, YELLOW, BLACK, "TARGETS %d", n);
+	if (!g_Targets.Valid()) return;
+	TextXY(hDC, 11, 2, WHITE, BLACK, "km     brg min km @ t");
+	for (k = 0; k < n && k < 20; k++) {
+		StatText (buf[0], g_Targets.Range (k, R)*1e-3);
+		StatText (buf[1], g_Targets.Closest (k, R)*1e-3);
+		StatText (buf[2], g_Targets.ClosestTime (k));
+		TextXY(hDC, 0, 3+k, GREEN, BLACK, "%c %.8s", kindch[g_Targets.Kind (k)], g_Targets.Name (k));
+		TextXY(hDC, 11, 3+k, YELLOW, BLACK, buf[0]);
+		TextXY(hDC, 18, 3+k, YELLOW, BLACK, "%03.0f", g_Targets.Bearing (k)*DEG);
+		TextXY(hDC, 22, 3+k, YELLOW, BLACK, buf[1]);
+		TextXY(hDC, 29, 3+k, YELLOW, BLACK, buf[2]);
+	}
+}
+
 bool FlightDataRecMFD::SetAltRange (char *rstr)
 {
 	float altmin, altmax;
@@ -600,13 +1401,51 @@ bool FlightDataRecMFD::SetBase (const std::string rstr)
 
 	v->GetStatus(v_stat);
 	
-	hbase = oapiGetBaseByName(v_stat.rbody, const_cast<char *>(rstr.c_str()));
+	return SetTargets (v_stat.rbody, rstr);
+}
 
-    if(hbase != NULL){
-		oapiGetBaseEquPos(hbase, &b_pos.LONG, &b_pos.LAT, &b_pos.RADIUS);
-		return true;
-	} else {
-		return false;
+void FlightDataRecMFD::StoreStatus (void) const
+{
+	saveprm.valid = 1;
+	saveprm.page = page;
+	saveprm.alt_auto = alt_auto;
+	saveprm.vrad_auto = vrad_auto;
+	saveprm.vtan_auto = vtan_auto;
+}
+
+void FlightDataRecMFD::RecallStatus (void)
+{
+	if (!saveprm.valid) return;
+	page = saveprm.page;
+	alt_auto = saveprm.alt_auto;
+	vrad_auto = saveprm.vrad_auto;
+	vtan_auto = saveprm.vtan_auto;
+}
+
+// the recorder ring goes to a checkpoint file next to the log; the
+// scenario only names it
+void FlightDataRecMFD::WriteStatus (FILEHANDLE scn) const
+{
+	std::string path;
+	oapiWriteScenario_int (scn, const_cast<char *>("PAGE"), page);
+	if (SaveCheckpoint (path))
+		oapiWriteScenario_string (scn, const_cast<char *>("CHECKPOINT"), const_cast<char *>(path.c_str()));
+}
+
+void FlightDataRecMFD::ReadStatus (FILEHANDLE scn)
+{
+	char *line;
+	while (oapiReadScenario_nextline (scn, line)) {
+		if (!strncmp (line, "END_MFD", 7)) break;
+		else if (!strncmp (line, "PAGE", 4)) {
+			sscanf (line+4, "%d", &page);
+			if (page < 0 || page >= NPAGE) page = 0;
+		} else if (!strncmp (line, "CHECKPOINT", 10)) {
+			const char *p = line+10;
+			while (*p == ' ' || *p == '\t') p++;
+			if (!g_Restored && *p && !RestoreCheckpoint (p, pV->GetName()))
+				oapiWriteLog(const_cast<char *>("FlightDataRecMFD: cannot restore checkpoint"));
+		}
 	}
 }
 
@@ -675,8 +1514,14 @@ void PurgeDataPoints(void)
 		paused == 1; remain_paused = 0;
 	}
 
+	g_DataLock.WriteBegin();
 	g_Data.tnext  = 0.0;
 	g_Data.sample = 0;
+	g_Data.count  = 0;
+	g_Data.purges++;
+	g_Resample.Reset();
+	g_Events.Reset();
+	g_Marks.count = 0;
 	memset (g_Data.ves_alt,   0, ndata*sizeof(float));
 	memset (g_Data.ves_pitch, 0, ndata*sizeof(float));
 	memset (g_Data.ves_roll, 0, ndata*sizeof(float));
@@ -701,69 +1546,451 @@ void PurgeDataPoints(void)
 	memset (g_Data.eng_fuel_rate,  0, ndata*sizeof(float));
 	memset (g_Data.eng_main_t,  0, ndata*sizeof(float));
 	memset (g_Data.eng_hover_t,  0, ndata*sizeof(float));
+	memset (g_Data.smp_q,  0, ndata*sizeof(int));
+	memset (g_Data.int_dv,  0, ndata*sizeof(float));
+	memset (g_Data.int_gnd,  0, ndata*sizeof(float));
+	memset (g_Data.int_heat,  0, ndata*sizeof(float));
+	memset (g_Data.int_fuel,  0, ndata*sizeof(float));
+	memset (g_Data.fuel_resid,  0, ndata*sizeof(float));
+	memset (g_Data.orb_apo,  0, ndata*sizeof(float));
+	memset (g_Data.orb_peri,  0, ndata*sizeof(float));
+	memset (g_Data.orb_ecc,  0, ndata*sizeof(float));
+	memset (g_Data.orb_inc,  0, ndata*sizeof(float));
+	memset (g_Data.orb_t_apo,  0, ndata*sizeof(float));
+	memset (g_Data.orb_energy,  0, ndata*sizeof(float));
+	g_Integrals.Reset();
+	g_Targets.ResetClosest();
+	g_DataLock.WriteEnd();
     
 	paused = remain_paused;
 }
 
-void log_data(void){
+// captured states of the resampler, kept in a checkpoint so the first
+// samples after a restore still get their rates
+struct RecorderState {
+	FDState prev, cur;
+	int captures;
+};
 
-	std::ofstream out_file;
-	
-	out_file.open(logpath, std::ios::app);
+// the float channels of the ring, in log column order
+static int RingColumns (float *col[])
+{
+	int n = 0;
+	col[n++] = g_Data.sim_time;
+	col[n++] = g_Data.ves_alt;
+	col[n++] = g_Data.ves_pitch;
+	col[n++] = g_Data.ves_roll;
+	col[n++] = g_Data.ves_yaw;
+	col[n++] = g_Data.ves_v_rad;
+	col[n++] = g_Data.ves_v_tan;
+	col[n++] = g_Data.ves_a_rad;
+	col[n++] = g_Data.ves_a_tan;
+	col[n++] = g_Data.ves_a_g;
+	col[n++] = g_Data.ves_surf_lon;
+	col[n++] = g_Data.ves_surf_lat;
+	col[n++] = g_Data.ves_surf_hdg;
+	col[n++] = g_Data.ves_dist;
+	col[n++] = g_Data.ves_aoa;
+	col[n++] = g_Data.ves_mach;
+	col[n++] = g_Data.ves_lift;
+	col[n++] = g_Data.ves_drag;
+	col[n++] = g_Data.atm_t;
+	col[n++] = g_Data.atm_stp;
+	col[n++] = g_Data.atm_dynp;
+	col[n++] = g_Data.atm_d;
+	col[n++] = g_Data.eng_fuel_mass;
+	col[n++] = g_Data.eng_fuel_rate;
+	col[n++] = g_Data.eng_main_t;
+	col[n++] = g_Data.eng_hover_t;
+	col[n++] = g_Data.int_dv;
+	col[n++] = g_Data.int_gnd;
+	col[n++] = g_Data.int_heat;
+	col[n++] = g_Data.int_fuel;
+	col[n++] = g_Data.fuel_resid;
+	col[n++] = g_Data.orb_apo;
+	col[n++] = g_Data.orb_peri;
+	col[n++] = g_Data.orb_ecc;
+	col[n++] = g_Data.orb_inc;
+	col[n++] = g_Data.orb_t_apo;
+	col[n++] = g_Data.orb_energy;
+	return n;
+}
+const int NRINGCOL = 37;
+const int NLOGCOL = NRINGCOL+2;  // fields of a log line: index, ring columns, quality
 
-	if (out_file.is_open()){
+// write the ring and the recorder state to a checkpoint named after the
+// log file and the MJD of the save. Several MFDs saving the same scenario
+// share one checkpoint.
+bool SaveCheckpoint(std::string &path)
+{
+	double mjd = oapiGetSimMJD();
+	if (mjd == g_CkptMJD && !g_CkptPath.empty()) {
+		path = g_CkptPath;
+		return true;
+	}
+	FlushDeferred (-1.0);
+	g_Journal.Flush (false);
+
+	CheckpointHeader h;
+	RecorderState st;
+	float *col[NRINGCOL];
+	std::error_code ec;
+	char stamp[32];
+	memset (&h, 0, sizeof(h));
+	memset ((void*)&st, 0, sizeof(st));
+	h.ncol = RingColumns (col);
+	h.ndata = ndata;
+	h.state_size = sizeof(st);
+	h.sample = g_Data.sample;
+	h.count = g_Data.count;
+	h.total = g_Data.total;
+	h.paused = paused;
+	h.simt = oapiGetSimTime();
+	h.mjd = mjd;
+	h.tnext = g_Data.tnext;
+	std::uintmax_t sz = std::filesystem::file_size (logpath, ec);
+	h.logpos = (ec ? -1 : (long long)sz);
+	VESSEL *v = oapiGetFocusInterface();
+	if (v) strncpy (h.vessel, v->GetName(), sizeof(h.vessel)-1);
+	strncpy (h.logfile, logpath.string().c_str(), sizeof(h.logfile)-1);
+	st.prev = g_Resample.Previous();
+	st.cur = g_Resample.Current();
+	st.captures = g_Resample.Captures();
+
+	std::filesystem::path cp = logpath;
+	sprintf (stamp, "-%.5f", mjd);
+	cp.replace_filename (logpath.stem().string() + stamp + CKPT_EXT);
+	if (!Checkpoint::Write (cp.string().c_str(), h, col, g_Data.smp_q, &st)) {
+		oapiWriteLog(const_cast<char *>("FlightDataRecMFD: cannot write checkpoint"));
+		return false;
+	}
+	g_CkptPath = path = cp.string();
+	g_CkptMJD = mjd;
+	return true;
+}
 
-		out_file << g_Data.sample << delim_char;
-		out_file << g_Data.sim_time[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_alt[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_pitch[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_roll[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_yaw[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_v_rad[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_v_tan[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_a_rad[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_a_tan[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_a_g[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_surf_lon[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_surf_lat[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_surf_hdg[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_dist[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_aoa[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_mach[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_lift[g_Data.sample] << delim_char;
-		out_file << g_Data.ves_drag[g_Data.sample] << delim_char;
-		out_file << g_Data.atm_t[g_Data.sample] << delim_char;
-		out_file << g_Data.atm_stp[g_Data.sample] << delim_char;
-		out_file << g_Data.atm_dynp[g_Data.sample] << delim_char;
-		out_file << g_Data.atm_d[g_Data.sample] << delim_char;
-		out_file << g_Data.eng_fuel_mass[g_Data.sample] << delim_char;
-		out_file << g_Data.eng_fuel_rate[g_Data.sample] << delim_char;
-		out_file << g_Data.eng_main_t[g_Data.sample] << delim_char;
-		out_file << g_Data.eng_hover_t[g_Data.sample];
-		out_file << std::endl;
+// Cut the log file back to its size at the checkpoint. Whatever was logged
+// after the save belongs to a flight this one does not continue, so it is
+// moved to a file of its own beside the checkpoint, rather than lost: the
+// first of <checkpoint>.after1<ext>, .after2 ... that does not exist, so
+// a save loaded again does not overwrite the flight of the first load.
+// The journal of the log is cut back with it. Returns the bytes moved,
+// -1 on failure (the log is then left as it is).
+static long long SplitLogTail(const std::filesystem::path &log, long long pos, const char *ckpt,
+	std::filesystem::path &tail)
+{
+	std::error_code ec;
+	std::uintmax_t sz = std::filesystem::file_size (log, ec);
+	if (ec || (long long)sz <= pos) return 0;
+	if (g_Journal.Active() && g_Journal.Path() == log.string()) g_Journal.Close();
+	for (int n = 1; ; n++) {
+		tail = ckpt;
+		tail.replace_extension (".after" + std::to_string (n) + log.extension().string());
+		if (!std::filesystem::exists (tail, ec)) break;
+	}
+	{
+		std::ifstream in (log, std::ios::binary);
+		std::ofstream out (tail, std::ios::binary);
+		if (!in.is_open() || !out.is_open()) return -1;
+		in.seekg (pos);
+		out << in.rdbuf();
+		if (!out.good()) return -1;
 	}
+	std::filesystem::resize_file (log, (std::uintmax_t)pos, ec);
+	if (ec) return -1;
+	if (!TruncateJournal (log.string().c_str(), pos))
+		oapiWriteLog(const_cast<char *>("FlightDataRecMFD: cannot cut log journal back to the checkpoint"));
+	return (long long)sz-pos;
+}
 
+// refill the ring from a checkpoint of the same vessel. Orbiter restarts
+// sim time with every session, so the restored samples are moved onto
+// the new time line: the checkpoint instant becomes the current sim time.
+// Recording continues into the log file of the checkpoint, on the time
+// line of the checkpoint, from where the log stood at the save.
+bool RestoreCheckpoint(const char *path, const char *vessel)
+{
+	Checkpoint ck;
+	RecorderState st;
+	float *col[NRINGCOL];
+	int c, i;
+	if (!ck.Open (path)) return false;
+	const CheckpointHeader &h = ck.Header();
+	if (h.ncol != (unsigned int)RingColumns (col) || h.ndata != (unsigned int)ndata ||
+		h.state_size != sizeof(st) || strncmp (h.vessel, vessel, sizeof(h.vessel)-1))
+		return false;
+	memcpy ((void*)&st, ck.State(), sizeof(st));
+	double shift = oapiGetSimTime() - h.simt;
+
+	g_DataLock.WriteBegin();
+	for (c = 0; c < (int)h.ncol; c++)
+		memcpy (col[c], ck.Column (c), ndata*sizeof(float));
+	memcpy (g_Data.smp_q, ck.Quality(), ndata*sizeof(int));
+	for (i = 0; i < ndata; i++)
+		g_Data.sim_time[i] = (float)(g_Data.sim_time[i] + shift);
+	g_Data.sample = h.sample;
+	g_Data.count = h.count;
+	g_Data.total = h.total;
+	g_Data.purges++;
+	g_Events.Reset();
+	g_Marks.count = 0;
+	g_Integrals.Reset();
+	if (g_Data.count) {
+		// the integrals go on from the newest sample
+		i = (g_Data.sample+ndata-1) % ndata;
+		double in[NINTEGRAL] = {g_Data.int_dv[i], g_Data.int_gnd[i], g_Data.int_heat[i],
+			g_Data.int_fuel[i], g_Data.fuel_resid[i]};
+		g_Integrals.Restore (in, g_Data.eng_fuel_mass[i]);
+	}
+	g_Resample.Restore (st.prev, st.cur, st.captures, shift);
+	g_Data.tnext = (st.captures ? g_Resample.Next() : 0.0);
+	g_DataLock.WriteEnd();
+
+	g_npending = 0;
+	paused = h.paused;
+	logpath = std::filesystem::path (h.logfile);
+	logdir = logpath.parent_path();
+	logfile = logpath.filename();
+	g_Restored = true;
+	g_LogShift = -shift;
+
+	// RESUME checkpoint, log size at the save, bytes logged after the save
+	// and the file they were moved to
+	std::filesystem::path tail;
+	long long moved = SplitLogTail (logpath, h.logpos > 0 ? h.logpos : 0, path, tail);
+	log_event (oapiGetSimTime(), "RESUME", "%s%c%lld%c%lld%c%s",
+		std::filesystem::path (path).filename().string().c_str(), delim_char, h.logpos, delim_char,
+		moved, delim_char, moved > 0 ? tail.filename().string().c_str() : "-");
+	return true;
 }
 
+// add the catalog entry of the session being logged to the catalog in
+// the directory of its log file
+static void CloseSession(void)
+{
+	if (g_Session.Active() && g_Session.Entry().samples) {
+		std::filesystem::path catpath = g_SessionPath.parent_path() / CATALOG_NAME;
+		if (!AppendCatalog (catpath.string().c_str(), g_Session.Summary()))
+			oapiWriteLog(const_cast<char *>("FlightDataRecMFD: cannot update session catalog"));
+	}
+	g_Session.Stop();
+}
 
-bool DelimInput (void *id, char *str, void *data)
+// account a logged sample to the session of its log file; a new log file
+// (auto increment, black-box trigger, new name or path) starts a new session
+static void SessionSample(int i)
 {
-	delim_char = str[0];
+	if (!g_Session.Active() || logpath != g_SessionPath) {
+		CloseSession();
+		VESSEL *v = oapiGetFocusInterface();
+		g_SessionPath = logpath;
+		g_Session.Start (v ? v->GetName() : "", g_Targets.Count() ? g_Targets.Name (0) : "", logpath.string().c_str());
+	}
+	float val[NCATCH];
+	val[CAT_ALT]   = g_Data.ves_alt[i];
+	val[CAT_V_RAD] = g_Data.ves_v_rad[i];
+	val[CAT_V_TAN] = g_Data.ves_v_tan[i];
+	val[CAT_A_G]   = g_Data.ves_a_g[i];
+	val[CAT_DYNP]  = g_Data.atm_dynp[i];
+	val[CAT_MACH]  = g_Data.ves_mach[i];
+	val[CAT_FUEL]  = g_Data.eng_fuel_mass[i];
+	val[CAT_DIST]  = g_Data.ves_dist[i];
+	// deferred samples are logged after their step: date them back
+	double mjd = oapiGetSimMJD() - (oapiGetSimTime() - g_Data.sim_time[i])/86400.0;
+	g_Session.Add (g_Data.sim_time[i], mjd, val);
+	for (int c = 0; c < NCATCH; c++) g_Window[c].Add (g_Data.sim_time[i], val[c]);
+}
+
+// open the journal on the current log file; false if the log cannot be
+// journaled, and the samples are appended one by one instead
+static bool OpenJournal(void)
+{
+	static std::string failed;
+	std::string p = logpath.string();
+	if (g_Journal.Active() && g_Journal.Path() == p) return !g_Journal.Failed();
+	g_Journal.Close();
+	if (p == failed) return false;
+	if (!g_Journal.Open (p.c_str(), g_JournalRows, g_JournalFlush, g_JournalSync, g_JournalSyncMs)) {
+		oapiWriteLog(const_cast<char *>("FlightDataRecMFD: cannot open log journal"));
+		failed = p;
+		return false;
+	}
+	failed.clear();
 	return true;
 }
 
-bool BaseInput (void *id, char *str, void *data){
+// repair the logs of sessions that ended without closing their journal,
+// e.g. in a crash: cut the torn tail and keep every complete sample
+static void RecoverLogs(void)
+{
+	std::error_code ec;
+	char msg[512];
+	for (const auto &e : std::filesystem::directory_iterator (logdir, ec)) {
+		const std::filesystem::path &lp = e.path();
+		if (!e.is_regular_file (ec) || lp.extension() == JOURNAL_EXT) continue;
+		if (!std::filesystem::exists (JournalPath (lp.string().c_str()), ec)) continue;
+		if (JournalClosed (lp.string().c_str())) continue;
+		JournalReport r;
+		bool ok = RecoverJournal (lp.string().c_str(), NLOGCOL, delim_char, true, r);
+		snprintf (msg, sizeof(msg), "FlightDataRecMFD: %s %s: %lld samples verified, %lld salvaged, %lld bytes cut",
+			ok ? "recovered" : "cannot recover", lp.filename().string().c_str(), r.verified, r.salvaged, r.dropped);
+		oapiWriteLog(msg);
+		if (!ok) continue;
+		std::filesystem::path evtpath = lp;
+		std::ofstream evt (evtpath.replace_extension(".evt"), std::ios::app);
+		if (evt.is_open())
+			evt << 0 << delim_char << "RECOVER" << delim_char << r.verified << delim_char
+				<< r.salvaged << delim_char << r.dropped << std::endl;
+	}
+}
 
-	tgt_base = str;
+// the fields of a log line
+static void write_sample(std::ostream &out_file, int i)
+{
+	out_file << i << delim_char;
+	out_file << g_Data.sim_time[i] + g_LogShift << delim_char;
+	out_file << g_Data.ves_alt[i] << delim_char;
+	out_file << g_Data.ves_pitch[i] << delim_char;
+	out_file << g_Data.ves_roll[i] << delim_char;
+	out_file << g_Data.ves_yaw[i] << delim_char;
+	out_file << g_Data.ves_v_rad[i] << delim_char;
+	out_file << g_Data.ves_v_tan[i] << delim_char;
+	out_file << g_Data.ves_a_rad[i] << delim_char;
+	out_file << g_Data.ves_a_tan[i] << delim_char;
+	out_file << g_Data.ves_a_g[i] << delim_char;
+	out_file << g_Data.ves_surf_lon[i] << delim_char;
+	out_file << g_Data.ves_surf_lat[i] << delim_char;
+	out_file << g_Data.ves_surf_hdg[i] << delim_char;
+	out_file << g_Data.ves_dist[i] << delim_char;
+	out_file << g_Data.ves_aoa[i] << delim_char;
+	out_file << g_Data.ves_mach[i] << delim_char;
+	out_file << g_Data.ves_lift[i] << delim_char;
+	out_file << g_Data.ves_drag[i] << delim_char;
+	out_file << g_Data.atm_t[i] << delim_char;
+	out_file << g_Data.atm_stp[i] << delim_char;
+	out_file << g_Data.atm_dynp[i] << delim_char;
+	out_file << g_Data.atm_d[i] << delim_char;
+	out_file << g_Data.eng_fuel_mass[i] << delim_char;
+	out_file << g_Data.eng_fuel_rate[i] << delim_char;
+	out_file << g_Data.eng_main_t[i] << delim_char;
+	out_file << g_Data.eng_hover_t[i] << delim_char;
+	out_file << g_Data.smp_q[i] << delim_char;
+	out_file << g_Data.int_dv[i] << delim_char;
+	out_file << g_Data.int_gnd[i] << delim_char;
+	out_file << g_Data.int_heat[i] << delim_char;
+	out_file << g_Data.int_fuel[i] << delim_char;
+	out_file << g_Data.fuel_resid[i] << delim_char;
+	out_file << g_Data.orb_apo[i] << delim_char;
+	out_file << g_Data.orb_peri[i] << delim_char;
+	out_file << g_Data.orb_ecc[i] << delim_char;
+	out_file << g_Data.orb_inc[i] << delim_char;
+	out_file << g_Data.orb_t_apo[i] << delim_char;
+	out_file << g_Data.orb_energy[i];
+}
 
-	if(!((FlightDataRecMFD*)data)->SetBase (str)){
-		tgt_base.clear();
-		return false;
+// hand the segment being written to the compressor; its journal is
+// closed first, so the compressed segment is complete
+static void CloseSegment(void)
+{
+	if (g_Seg.samples && (g_RotateMB > 0 || g_RotateMin > 0)) {
+		if (g_Journal.Active() && g_Journal.Path() == g_Seg.path) g_Journal.Close();
+		g_Segments.Close (g_Seg);
+	}
+	g_Seg.path.clear();
+	g_Seg.samples = g_Seg.bytes = 0;
+}
+
+// start the next segment of the flight in the next numbered log file
+static void RotateLog(void)
+{
+	SegmentInfo prev = g_Seg;
+	CloseSegment();
+	IncrementFileCounter();
+	g_Seg.flight = prev.flight;
+	g_Seg.part = prev.part+1;
+	g_Seg.path = logpath.string();
+	log_event (prev.t_end, "SEGMENT", "%d%c%s%c%lld%c%lld", g_Seg.part, delim_char,
+		std::filesystem::path (prev.path).filename().string().c_str(), delim_char,
+		prev.samples, delim_char, prev.bytes);
+}
+
+// account a logged line to its segment and rotate the log when the
+// segment is full; a new log file of its own starts a new flight
+static void SegmentSample(int i, size_t len)
+{
+	if (g_Seg.path != logpath.string()) {
+		CloseSegment();
+		g_Seg.flight = logpath.filename().string();
+		g_Seg.part = 0;
+		g_Seg.path = logpath.string();
+	}
+	if (!g_Seg.samples) g_Seg.t_start = g_Data.sim_time[i];
+	g_Seg.t_end = g_Data.sim_time[i];
+	g_Seg.samples++;
+	g_Seg.bytes += len;
+	if ((g_RotateMB > 0 && g_Seg.bytes >= g_RotateMB*1048576.0) ||
+		(g_RotateMin > 0 && g_Seg.t_end-g_Seg.t_start >= g_RotateMin*60.0))
+		RotateLog();
+}
+
+void log_data(int i){
+
+	static std::ostringstream line;
+	
+	SessionSample(i);
+
+	line.str ("");
+	write_sample (line, i);
+#ifdef _WIN32
+	line << "\r\n";
+#else
+	line << '\n';
+#endif
+	const std::string &s = line.str();
+
+	// journaled: the line goes into the pending block
+	if (g_JournalRows > 0 && OpenJournal())
+		g_Journal.Append (s.data(), (int)s.size());
+	else {
+		std::ofstream out_file (logpath, std::ios::app | std::ios::binary);
+		if (!out_file.is_open()) return;
+		out_file.write (s.data(), s.size());
+	}
+
+	if (g_RotateMB > 0 || g_RotateMin > 0) SegmentSample (i, s.size());
+}
+
+
+// append an entry to the event log kept next to the data log
+void log_event(double simt, const char *type, const char *fmt, ...){
+
+	std::ofstream out_file;
+	std::filesystem::path evtpath = logpath;
+	char cbuf[256];
+	va_list ap;
+
+	evtpath.replace_extension(".evt");
+	out_file.open(evtpath, std::ios::app);
+
+	if (out_file.is_open()){
+		va_start(ap, fmt);
+		vsnprintf(cbuf, sizeof(cbuf), fmt, ap);
+		va_end(ap);
+		out_file << simt + g_LogShift << delim_char << type << delim_char << cbuf << std::endl;
 	}
+}
 
+bool DelimInput (void *id, char *str, void *data)
+{
+	delim_char = str[0];
 	return true;
 }
 
+bool BaseInput (void *id, char *str, void *data){
+
+	return ((FlightDataRecMFD*)data)->SetBase (str);
+}
+
 bool RateInput (void *id, char *str, void *data){
 	
 	float rate;
@@ -804,6 +2031,22 @@ bool PathInput(void* id, char *str, void* data) {
     return true;
 }
 
+// load the reference flight: a log name is taken relative to the log
+// directory, "-" or nothing unloads it
+bool LoadReference(const std::string &name) {
+    if (name.empty() || name == "-") {
+        g_Ref.Clear();
+        return true;
+    }
+    std::filesystem::path p(name);
+    if (p.is_relative()) p = logdir / p;
+    return g_Ref.Load(p.string().c_str(), 0);
+}
+
+bool RefInput(void *id, char *str, void *data) {
+    return LoadReference(strip_quotes(str));
+}
+
 bool FileInput(void *id, char *str, void *data) {
     namespace fs = std::filesystem;
 
@@ -829,7 +2072,18 @@ void WriteConfig() {
     }
 
     out_file << "AUTOINC "  << auto_inc   << '\n'
-             << "SAMPLEDT " << sample_dt  << '\n';
+             << "SAMPLEDT " << sample_dt  << '\n'
+             << "ADAPTIVE " << adaptive   << '\n'
+             << "RATEMIN "  << g_RateCtl.MinRate() << '\n'
+             << "RATEMAX "  << g_RateCtl.MaxRate() << '\n'
+             << "BLACKBOX " << blackbox   << '\n'
+             << "BBPRE "    << g_BlackBox.Pre()       << '\n'
+             << "BBPOST "   << g_BlackBox.Post()      << '\n'
+             << "BBGLIMIT " << g_BlackBox.GLimit()    << '\n'
+             << "BBCRASHVR " << g_BlackBox.CrashVrad() << '\n'
+             << "BUDGET "   << g_Watchdog.Budget()    << '\n'
+             << "EVENTS "   << events     << '\n'
+             << "STATWIN "  << g_StatWindow << '\n';
 
     if (delim_char != ' ') {
         out_file << "DELIM " << std::string(1, delim_char) << '\n';
@@ -839,6 +2093,32 @@ void WriteConfig() {
              << "LOGDIR "  << logdir.string()    << '\n'
              << "LOGFILE " << logfile.string()   << '\n'
              << "PAUSED "  << paused    << '\n';
+
+    if (g_Ref.Loaded()) {
+        out_file << "REFLOG " << g_Ref.Path() << '\n';
+    }
+    if (!g_TelemetryName.empty()) {
+        out_file << "SHMRING "  << g_TelemetryName  << '\n'
+                 << "SHMSLOTS " << g_TelemetrySlots << '\n';
+    }
+    if (!g_StreamSpec.empty()) {
+        out_file << "NETSTREAM " << g_StreamSpec  << '\n'
+                 << "NETFORMAT " << (g_StreamText ? "text" : "bin") << '\n'
+                 << "NETBATCH "  << g_StreamBatch << '\n'
+                 << "NETFLUSH "  << g_StreamFlush << '\n'
+                 << "NETQUEUE "  << g_StreamQueue << '\n';
+    }
+    if (g_JournalRows > 0) {
+        out_file << "JOURNAL " << g_JournalRows   << '\n'
+                 << "JFLUSH "  << g_JournalFlush  << '\n'
+                 << "JSYNC "   << g_JournalSync   << '\n'
+                 << "JSYNCMS " << g_JournalSyncMs << '\n';
+    }
+    if (g_RotateMB > 0 || g_RotateMin > 0) {
+        out_file << "ROTATEMB "  << g_RotateMB  << '\n'
+                 << "ROTATEMIN " << g_RotateMin << '\n'
+                 << "ROTATEZ "   << g_RotateZ   << '\n';
+    }
 }
 
 void ReadConfig() {
@@ -852,6 +2132,9 @@ void ReadConfig() {
     std::string key;
     std::string value;
     std::string line;
+    double ratemin = g_RateCtl.MinRate(), ratemax = g_RateCtl.MaxRate();
+    double bbpre = g_BlackBox.Pre(), bbpost = g_BlackBox.Post();
+    std::string reflog;
 
     while (std::getline(in_file, line)) {
         if (line.empty() || line[0] == '#') continue; // ignorar vacías o comentarios
@@ -867,6 +2150,28 @@ void ReadConfig() {
             try { auto_inc = std::stoi(value); } catch (...) {}
         } else if (key == "SAMPLEDT") {
             try { sample_dt = std::stof(value); } catch (...) {}
+        } else if (key == "ADAPTIVE") {
+            try { adaptive = std::stoi(value); } catch (...) {}
+        } else if (key == "RATEMIN") {
+            try { ratemin = std::stod(value); } catch (...) {}
+        } else if (key == "RATEMAX") {
+            try { ratemax = std::stod(value); } catch (...) {}
+        } else if (key == "BLACKBOX") {
+            try { blackbox = std::stoi(value); } catch (...) {}
+        } else if (key == "EVENTS") {
+            try { events = std::stoi(value); } catch (...) {}
+        } else if (key == "STATWIN") {
+            try { g_StatWindow = std::stod(value); } catch (...) {}
+        } else if (key == "BBPRE") {
+            try { bbpre = std::stod(value); } catch (...) {}
+        } else if (key == "BBPOST") {
+            try { bbpost = std::stod(value); } catch (...) {}
+        } else if (key == "BBGLIMIT") {
+            try { g_BlackBox.SetGLimit(std::stod(value)); } catch (...) {}
+        } else if (key == "BBCRASHVR") {
+            try { g_BlackBox.SetCrashVrad(std::stod(value)); } catch (...) {}
+        } else if (key == "BUDGET") {
+            try { g_Watchdog.SetBudget(std::stod(value)); } catch (...) {}
         } else if (key == "DELIM") {
             if (!value.empty()) delim_char = value[0];
         } else if (key == "TGTBASE") {
@@ -875,11 +2180,47 @@ void ReadConfig() {
             logdir = fs::path(value);
         } else if (key == "LOGFILE") {
             logfile = fs::path(value);
+        } else if (key == "REFLOG") {
+            reflog = value;
+        } else if (key == "SHMRING") {
+            g_TelemetryName = value;
+        } else if (key == "SHMSLOTS") {
+            try { g_TelemetrySlots = std::stoi(value); } catch (...) {}
+        } else if (key == "NETSTREAM") {
+            g_StreamSpec = value;
+        } else if (key == "NETFORMAT") {
+            g_StreamText = (value == "text");
+        } else if (key == "NETBATCH") {
+            try { g_StreamBatch = std::stoi(value); } catch (...) {}
+        } else if (key == "NETFLUSH") {
+            try { g_StreamFlush = std::stoi(value); } catch (...) {}
+        } else if (key == "NETQUEUE") {
+            try { g_StreamQueue = std::stoi(value); } catch (...) {}
+        } else if (key == "JOURNAL") {
+            try { g_JournalRows = std::stoi(value); } catch (...) {}
+        } else if (key == "JFLUSH") {
+            try { g_JournalFlush = std::stoi(value); } catch (...) {}
+        } else if (key == "JSYNC") {
+            try { g_JournalSync = std::stoi(value); } catch (...) {}
+        } else if (key == "JSYNCMS") {
+            try { g_JournalSyncMs = std::stoi(value); } catch (...) {}
+        } else if (key == "ROTATEMB") {
+            try { g_RotateMB = std::stod(value); } catch (...) {}
+        } else if (key == "ROTATEMIN") {
+            try { g_RotateMin = std::stod(value); } catch (...) {}
+        } else if (key == "ROTATEZ") {
+            try { g_RotateZ = std::stoi(value); } catch (...) {}
         }
     }
 
     logpath = logdir / logfile;
+    g_RateCtl.SetLimits(ratemin, ratemax);
+    g_RateCtl.Reset(1.0/sample_dt);
+    g_BlackBox.SetWindow(bbpre, bbpost);
+    for (int c = 0; c < NCATCH; c++) g_Window[c].SetSpan(g_StatWindow);
+    if (!reflog.empty() && !LoadReference(reflog))
+        oapiWriteLog(const_cast<char *>("FlightDataRecMFD: cannot load reference log"));
 }
 
 
-FlightDataRecMFD::SavePrm FlightDataRecMFD::saveprm = {0, 0, 0.0, '\0', '\0', '\0', '\0'};
+FlightDataRecMFD::SavePrm FlightDataRecMFD::saveprm = {0, 0, true, true, true};
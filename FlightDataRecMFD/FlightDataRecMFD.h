@@ -3,11 +3,17 @@
 
 #include "..//..//include//Orbitersdk.h"
 #include "..//..//include//MFDAPI.h"
+#include "..//FlightDataCommon//Decimate.h"
+#include "..//FlightDataCommon//RefTrajectory.h"
+#include "FlightEvents.h"
 
 #define LONG x
 #define LAT y
 #define RADIUS z
 
+const int NPLOT = 6;  // number of graphs
+const int NPAGE = 5;  // display pages: two of graphs, session and window statistics, targets
+
 #define HOR x
 #define VERT y
 #define LATERAL y
@@ -25,10 +31,20 @@ public:
 	bool SetVradRange (char *rstr);
 	bool SetVtanRange (char *rstr);
 	bool SetBase (const std::string rstr);
+	void StoreStatus (void) const;
+	void RecallStatus (void);
+	void WriteStatus (FILEHANDLE scn) const;
+	void ReadStatus (FILEHANDLE scn);
 	static OAPI_MSGTYPE MsgProc (UINT msg, UINT mfd, WPARAM wparam, LPARAM lparam);
 
 private:
 	void InitReferences (void);
+	void TakeSnapshot (void);
+	void UpdatePlots (void);
+	void UpdateReference (float altmin, float altmax);
+	void UpdateMarks (float *src[NPLOT][2]);
+	void ShowStats (HDC hDC, bool window);
+	void ShowTargets (HDC hDC);
 	OBJHANDLE ref;
 	double tgt_alt;
 	bool  alt_auto;
@@ -38,20 +54,51 @@ private:
 	float *ref_alt;
 	float *ref_tvel;
 
-	// transient parameter storage
+	// consistent copy of the recorder channels plotted by this MFD
+	struct {
+		int sample;       // ring offset
+		int count;        // valid samples
+		long total;       // samples stored
+		int purges;       // purge count
+		float *sim_time;
+		float *ves_alt;
+		float *ves_v_rad;
+		float *ves_v_tan;
+		float *ves_a_rad;
+		float *ves_a_tan;
+		float *ves_dist;
+		EventMarks marks;
+	} snap;
+
+	// per-column min/max reduction of the plotted series
+	MinMaxDecimator dec[NPLOT];
+	DecPoint *dpt;          // reduction output
+	float *plt_x[NPLOT];    // abscissa arrays bound to the graphs
+	float *plt_y[NPLOT];    // ordinate arrays bound to the graphs
+	int nplt;               // length of the bound arrays
+	bool raw;               // too few samples per column to reduce: bind them as they are
+	int plt_ofs;            // ring offset of the bound arrays (always 0)
+	long fed;               // next sample to feed to the reducers
+	int fed_purges;         // purge count at the last feed
+
+	// reference flight overlaid on the Vtan/Alt, Vrad/Alt and Alt/Range
+	// graphs: one plot per altitude run of the reference
+	float *rplt_x[3][REF_NRUN];
+	float *rplt_y[3][REF_NRUN];
+
+	// flight events marked on every graph: a small diamond per event,
+	// one plot each
+	enum { NMARKPT = 5 };
+	float *mplt_x[NPLOT][NEVMARK];
+	float *mplt_y[NPLOT][NEVMARK];
+
+	// transient parameter storage: the display settings of the MFD while
+	// it is closed (vessel switch, panel change); the recorder settings
+	// are module globals and outlive it anyway
 	static struct SavePrm {
-		int paused;
-		int auto_inc;
-		float sample_dt;
-		char delim_char;
-		char tgt_base[255];
-		char logdir[255];
-		char logfile[25];
-		
+		int valid;
 		int page;
-		float altmin, altmax;
-		float vradmin, vradmax;
-		float vtanmin, vtanmax;
+		bool alt_auto, vrad_auto, vtan_auto;
 	} saveprm;
 };
 
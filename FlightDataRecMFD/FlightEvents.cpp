@@ -0,0 +1,152 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// FlightEvents.cpp
+// Incremental detection of flight events in the sampled channels.
+// ==============================================================
+
+#include <cmath>
+#include "FlightEvents.h"
+
+static const double ALT_HYST  = 0.1;    // altitude turn that confirms an extremum (km)
+static const double DYNP_HYST = 500.0;  // dynamic pressure drop that confirms max-Q (Pa)
+static const double DYNP_MIN  = 1000.0; // smallest max-Q reported (Pa)
+static const double G_HYST    = 0.2;    // acceleration drop that confirms max-G (g)
+static const double G_MIN     = 1.0;    // smallest max-G reported (g)
+static const double PEAK_REL  = 0.1;    // relative hysteresis of max-Q and max-G
+static const double THR_ON    = 5.0;    // throttle that counts as ignition (%)
+static const double THR_OFF   = 1.0;    // throttle that counts as cutoff (%)
+static const double TD_ALT    = 5.0;    // altitude regarded as touchdown (m)
+static const double TD_ARM    = 50.0;   // altitude that arms the touchdown detector (m)
+static const double STG_MIN   = 50.0;   // smallest propellant mass step taken as staging (kg)
+static const double STG_REL   = 0.02;   // ... or fraction of the propellant mass
+
+PeakDetector::PeakDetector (double _hyst, double _rel)
+{
+	hyst = _hyst;
+	rel = _rel;
+	Reset();
+}
+
+void PeakDetector::Reset ()
+{
+	dir = 0;
+	started = false;
+	n_ext = -1;
+	t_ext = v_ext = 0.0;
+}
+
+double PeakDetector::Band (double v) const
+{
+	double b = rel*fabs (v);
+	return (b > hyst ? b : hyst);
+}
+
+int PeakDetector::Update (long n, double t, double v)
+{
+	if (!started) {
+		started = true;
+		hi = lo = v, t_hi = t_lo = t, n_hi = n_lo = n;
+		return 0;
+	}
+	if (v > hi) hi = v, t_hi = t, n_hi = n;
+	if (v < lo) lo = v, t_lo = t, n_lo = n;
+
+	if (dir >= 0 && v < hi-Band (hi)) {
+		int found = (dir > 0 ? 1 : 0);
+		n_ext = n_hi, t_ext = t_hi, v_ext = hi;
+		dir = -1;
+		lo = v, t_lo = t, n_lo = n;
+		return found;
+	}
+	if (dir <= 0 && v > lo+Band (lo)) {
+		int found = (dir < 0 ? -1 : 0);
+		n_ext = n_lo, t_ext = t_lo, v_ext = lo;
+		dir = 1;
+		hi = v, t_hi = t, n_hi = n;
+		return found;
+	}
+	return 0;
+}
+
+FlightEvents::FlightEvents ()
+: alt (ALT_HYST, 0.0), dynp (DYNP_HYST, PEAK_REL), a_g (G_HYST, PEAK_REL)
+{
+	nevent = 0;
+	Reset();
+}
+
+void FlightEvents::Reset ()
+{
+	alt.Reset();
+	dynp.Reset();
+	a_g.Reset();
+	thr_on = false;
+	t_ign = 0.0;
+	td_armed = false;
+	have_prev = false;
+	nev = 0;
+}
+
+void FlightEvents::Add (int type, long n, double t, double value)
+{
+	FlightEvent &e = ev[nev++];
+	e.type = type;
+	e.sample = n;
+	e.t = t;
+	e.value = value;
+	nevent++;
+}
+
+int FlightEvents::Update (long n, double t, double _alt, double alt_gnd, double v_rad, double _dynp,
+	double _a_g, double thr, double fuel, double fuel_rate)
+{
+	nev = 0;
+
+	// minima on the ground are where the vessel sits, not periapses. The
+	// ground is where the terrain is, not at the mean radius
+	int turn = alt.Update (n, t, _alt);
+	if (turn > 0) Add (FE_APOAPSIS, alt.Sample(), alt.Time(), alt.Value());
+	else if (turn < 0 && alt_gnd*1e3 > TD_ARM) Add (FE_PERIAPSIS, alt.Sample(), alt.Time(), alt.Value());
+
+	if (dynp.Update (n, t, _dynp) > 0 && dynp.Value() >= DYNP_MIN)
+		Add (FE_MAXQ, dynp.Sample(), dynp.Time(), dynp.Value());
+	if (a_g.Update (n, t, _a_g) > 0 && a_g.Value() >= G_MIN)
+		Add (FE_MAXG, a_g.Sample(), a_g.Time(), a_g.Value());
+
+	if (!thr_on && thr >= THR_ON) {
+		thr_on = true;
+		t_ign = t;
+		Add (FE_IGNITION, n, t, thr);
+	} else if (thr_on && thr <= THR_OFF) {
+		thr_on = false;
+		Add (FE_MECO, n, t, t-t_ign);
+	}
+
+	if (alt_gnd*1e3 > TD_ARM) {
+		td_armed = true;
+	} else if (td_armed && alt_gnd*1e3 < TD_ALT && v_rad <= 0.0) {
+		td_armed = false;
+		Add (FE_TOUCHDOWN, n, t, -v_rad);
+	}
+
+	// propellant lost beyond what the engines burnt over the interval
+	if (have_prev) {
+		double lost = (fuel_prev-fuel) - 0.5*(rate_prev+fuel_rate)*(t-t_prev);
+		double lim = STG_REL*fuel_prev;
+		if (lost > (lim > STG_MIN ? lim : STG_MIN)) Add (FE_STAGING, n, t, lost);
+	}
+	have_prev = true;
+	t_prev = t, fuel_prev = fuel, rate_prev = fuel_rate;
+
+	return nev;
+}
+
+const char *FlightEventName (int type)
+{
+	static const char *name[NFLIGHTEVENT] = {
+		"APOAPSIS", "PERIAPSIS", "MAXQ", "MAXG", "IGNITION", "MECO", "TOUCHDOWN", "STAGING"
+	};
+	return (type >= 0 && type < NFLIGHTEVENT ? name[type] : "?");
+}
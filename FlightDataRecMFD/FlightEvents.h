@@ -0,0 +1,94 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// FlightEvents.h
+// Incremental detection of flight events in the sampled channels.
+// ==============================================================
+
+#ifndef __FLIGHTEVENTS_H
+#define __FLIGHTEVENTS_H
+
+// event types
+enum {
+	FE_APOAPSIS,    // altitude maximum
+	FE_PERIAPSIS,   // altitude minimum off the ground
+	FE_MAXQ,        // dynamic pressure maximum
+	FE_MAXG,        // acceleration maximum
+	FE_IGNITION,    // main engine throttled up
+	FE_MECO,        // main engine cut off
+	FE_TOUCHDOWN,   // descended to the ground
+	FE_STAGING,     // propellant mass dropped by more than was burnt
+	NFLIGHTEVENT
+};
+
+struct FlightEvent {
+	int type;       // FE_*
+	long sample;    // number of the sample the event belongs to
+	double t;       // sim time of that sample
+	double value;   // extremum, descent rate, burn time or mass lost
+};
+
+// Peaks and valleys of a signal with hysteresis: an extremum is confirmed
+// once the signal has moved back from it by max(hyst, rel*|extremum|).
+// Until the first confirmed turn the detector does not know whether it is
+// climbing or falling, so the first sample is never reported.
+class PeakDetector {
+public:
+	PeakDetector (double hyst, double rel);
+	void Reset ();
+	int Update (long n, double t, double v);  // +1 peak, -1 valley confirmed, 0 none
+	long Sample () const { return n_ext; }    // the confirmed extremum
+	double Time () const { return t_ext; }
+	double Value () const { return v_ext; }
+
+private:
+	double Band (double v) const;
+	double hyst, rel;
+	int dir;              // 0 undecided, +1 looking for a peak, -1 for a valley
+	bool started;
+	double hi, t_hi, lo, t_lo;
+	long n_hi, n_lo;
+	double t_ext, v_ext;
+	long n_ext;
+};
+
+// Runs all detectors on each new sample. O(1) work and no history beyond
+// the current extremum of each peak detector; at most one event of each
+// type per sample. Peak events are dated back to their extremum.
+class FlightEvents {
+public:
+	FlightEvents ();
+	void Reset ();
+	// alt (above the mean radius) and alt_gnd (above the ground) in km,
+	// v_rad in m/s, dynp in Pa, a_g in g, thr in %, fuel in kg and
+	// fuel_rate in kg/s; returns the number of events found
+	int Update (long n, double t, double alt, double alt_gnd, double v_rad, double dynp, double a_g,
+		double thr, double fuel, double fuel_rate);
+	const FlightEvent &Event (int k) const { return ev[k]; }
+	long Count () const { return nevent; }
+
+private:
+	void Add (int type, long n, double t, double value);
+	PeakDetector alt, dynp, a_g;
+	bool thr_on;          // main engine burning
+	double t_ign;         // sim time of the ignition
+	bool td_armed;        // climbed out since the last touchdown
+	bool have_prev;
+	double t_prev, fuel_prev, rate_prev;
+	FlightEvent ev[NFLIGHTEVENT];
+	int nev;              // events of the current sample
+	long nevent;          // events found since construction
+};
+
+// the newest events, for the markers on the plots
+const int NEVMARK = 8;
+struct EventMarks {
+	FlightEvent ev[NEVMARK];  // event k at ev[k % NEVMARK]
+	long count;               // events stored since the last purge
+};
+
+// name of an event type in the event log
+const char *FlightEventName (int type);
+
+#endif // !__FLIGHTEVENTS_H
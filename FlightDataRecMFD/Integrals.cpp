@@ -0,0 +1,79 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// Integrals.cpp
+// Channels integrated over the recorded flight, sample by sample.
+// ==============================================================
+
+#include <cmath>
+#include "Integrals.h"
+
+static const double RAD = 0.017453292519943295;  // rad per deg
+
+FlightIntegrals::FlightIntegrals ()
+{
+	Reset();
+}
+
+void FlightIntegrals::Reset ()
+{
+	for (int k = 0; k < IN_FUEL_RESID; k++) sum[k].Reset();
+	have_prev = have_fuel0 = false;
+	fuel0 = fuel = 0.0;
+	prev_radius = 0.0;
+}
+
+// v[NINTEGRAL] as logged with the last sample, and its propellant mass
+void FlightIntegrals::Restore (const double *v, double _fuel)
+{
+	for (int k = 0; k < IN_FUEL_RESID; k++) sum[k].Reset (v[k]);
+	fuel = _fuel;
+	fuel0 = v[IN_FUEL_RESID] + fuel + v[IN_FUEL];
+	have_fuel0 = true;
+	have_prev = false;
+}
+
+// great circle distance between two positions (deg) on a sphere; the
+// haversine form keeps its precision for the short steps between samples
+static double GroundStep (double lon0, double lat0, double lon1, double lat1, double radius)
+{
+	double slat = sin (0.5*(lat1-lat0)*RAD), slon = sin (0.5*(lon1-lon0)*RAD);
+	double h = slat*slat + cos (lat0*RAD)*cos (lat1*RAD)*slon*slon;
+	return 2.0*radius*asin (sqrt (h < 1.0 ? h : 1.0));
+}
+
+static double ThrustAcc (const FDState &s)
+{
+	return (s.v[ST_MASS] > 0.0 ? s.v[ST_THRUST]/s.v[ST_MASS] : 0.0);
+}
+
+static double HeatRate (const FDState &s)
+{
+	double v = s.v[ST_AIRSPEED];
+	return s.v[ST_ATM_D]*v*v*v;
+}
+
+void FlightIntegrals::Update (const FDState &s, double radius)
+{
+	fuel = s.v[ST_FUEL_MASS];
+	if (!have_fuel0) fuel0 = fuel, have_fuel0 = true;
+	if (have_prev && s.t > prev.t) {
+		double dt = s.t - prev.t;
+		sum[IN_DV].Add (0.5*(ThrustAcc (prev) + ThrustAcc (s))*dt);
+		sum[IN_HEAT].Add (0.5*(HeatRate (prev) + HeatRate (s))*dt*1e-6);
+		sum[IN_FUEL].Add (0.5*(prev.v[ST_FUEL_RATE] + s.v[ST_FUEL_RATE])*dt);
+		if (radius == prev_radius)
+			sum[IN_GROUND].Add (GroundStep (prev.v[ST_SURF_LON], prev.v[ST_SURF_LAT],
+				s.v[ST_SURF_LON], s.v[ST_SURF_LAT], radius)*1e-3);
+	}
+	prev = s;
+	prev_radius = radius;
+	have_prev = true;
+}
+
+double FlightIntegrals::Value (int k) const
+{
+	if (k == IN_FUEL_RESID) return (fuel0 - fuel) - sum[IN_FUEL].s;
+	return (k >= 0 && k < IN_FUEL_RESID ? sum[k].s : 0.0);
+}
@@ -0,0 +1,61 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// Integrals.h
+// Channels integrated over the recorded flight, sample by sample.
+// ==============================================================
+
+#ifndef __INTEGRALS_H
+#define __INTEGRALS_H
+
+#include "Resample.h"
+
+// integrated channels (in logged units)
+enum {
+	IN_DV,          // delta-v expended: thrust/mass over time (m/s)
+	IN_GROUND,      // ground track distance (km)
+	IN_HEAT,        // heat load proxy: rho*v^3 over time (MJ/m^2)
+	IN_FUEL,        // propellant flow over time (kg)
+	IN_FUEL_RESID,  // propellant mass lost minus IN_FUEL (kg)
+	NINTEGRAL
+};
+
+// running sum with Kahan's compensation: the rounding error of each
+// addition is carried into the next, so millions of small increments
+// add up as if summed exactly
+struct KahanSum {
+	double s, c;
+
+	void Reset (double v = 0.0) { s = v; c = 0.0; }
+	void Add (double x)
+	{
+		double y = x - c;
+		double t = s + y;
+		c = (t - s) - y;
+		s = t;
+	}
+};
+
+// Integrates the flight over consecutive grid samples by the trapezoid
+// rule; O(1) per sample. The ground track follows the great circle
+// between successive positions and skips a step onto another body.
+class FlightIntegrals {
+public:
+	FlightIntegrals ();
+	void Reset ();                               // all integrals to 0
+	void Break () { have_prev = false; }         // do not integrate across a gap
+	void Restore (const double *v, double fuel); // continue from logged values
+	void Update (const FDState &s, double radius);
+	double Value (int k) const;
+
+private:
+	KahanSum sum[IN_FUEL_RESID];
+	FDState prev;
+	double prev_radius;
+	double fuel0;           // propellant mass at the start
+	bool have_prev, have_fuel0;
+	double fuel;            // latest propellant mass
+};
+
+#endif // !__INTEGRALS_H
@@ -0,0 +1,121 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// Resample.cpp
+// Resampling of captured vessel states onto the k*dt sample grid.
+// ==============================================================
+
+#include <cmath>
+#include "Resample.h"
+
+// angle wrapping of state channels: 0 = none, 1 = [-180,180), 2 = [0,360)
+static const int stwrap[NSTATE] = {
+	0, 0, 1, 1, 0, 0, 0, 1, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 1, 0, 0, 0
+};
+
+static double Wrap (double a, int wrap)
+{
+	if (wrap == 1) a -= 360.0*floor ((a+180.0)/360.0);
+	else if (wrap == 2) a -= 360.0*floor (a/360.0);
+	return a;
+}
+
+// difference b-a, taking the short way round for angles
+static double Delta (double a, double b, int wrap)
+{
+	double d = b-a;
+	if (wrap) {
+		if (d > 180.0) d -= 360.0;
+		else if (d < -180.0) d += 360.0;
+	}
+	return d;
+}
+
+Resampler::Resampler ()
+{
+	dt = 1.0;
+	maxburst = 1000;
+	Reset();
+}
+
+void Resampler::Reset ()
+{
+	nstate = 0;
+	knext = 0;
+}
+
+void Resampler::SetInterval (double _dt)
+{
+	if (_dt <= 0.0 || _dt == dt) return;
+	dt = _dt;
+	// re-anchor on the new grid, after the last state already covered
+	if (nstate) knext = (long long)floor (cur.t/dt + 1e-6) + 1;
+}
+
+double Resampler::Next () const
+{
+	return knext*dt;
+}
+
+void Resampler::Push (const FDState &s)
+{
+	if (nstate && s.t <= cur.t) {
+		if (s.t == cur.t) { cur = s; return; } // same frame
+		Reset();                               // time went backwards
+	}
+	if (!nstate) {
+		cur = s;
+		nstate = 1;
+		knext = (long long)ceil (s.t/dt - 1e-6);
+		return;
+	}
+	prev = cur;
+	cur = s;
+	nstate = 2;
+
+	// drop the oldest grid points if a single step spans too many of them
+	long long klast = (long long)floor (cur.t/dt + 1e-6);
+	if (klast-knext >= maxburst) knext = klast-maxburst+1;
+}
+
+bool Resampler::Emit (FDState &s, int &interp)
+{
+	if (!nstate) return false;
+	double t = knext*dt;
+	if (t > cur.t + Eps()) return false;
+
+	if (fabs (t-cur.t) <= Eps()) {
+		s = cur;
+		interp = 0;
+	} else if (nstate == 2 && t > prev.t) {
+		double f = (t-prev.t)/(cur.t-prev.t);
+		for (int i = 0; i < NSTATE; i++)
+			s.v[i] = Wrap (prev.v[i] + Delta (prev.v[i], cur.v[i], stwrap[i])*f, stwrap[i]);
+		interp = 1;
+	} else {
+		// grid point not bracketed by captured states: skip it
+		knext++;
+		return Emit (s, interp);
+	}
+	s.t = t;
+	knext++;
+	return true;
+}
+
+// reinstate captured states saved earlier, moved by 'shift' seconds onto
+// the current sim time line; the grid continues after the last of them
+void Resampler::Restore (const FDState &p, const FDState &c, int n, double shift)
+{
+	prev = p, prev.t += shift;
+	cur = c, cur.t += shift;
+	nstate = (n < 0 ? 0 : n > 2 ? 2 : n);
+	knext = (nstate ? (long long)floor (cur.t/dt + 1e-6) + 1 : 0);
+}
+
+double Resampler::Rate (int ch) const
+{
+	if (nstate < 2) return 0.0;
+	return Delta (prev.v[ch], cur.v[ch], stwrap[ch]) / (cur.t-prev.t);
+}
@@ -0,0 +1,84 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// Resample.h
+// Resampling of captured vessel states onto the k*dt sample grid.
+// ==============================================================
+
+#ifndef __RESAMPLE_H
+#define __RESAMPLE_H
+
+// captured state channels (in logged units)
+enum {
+	ST_ALT,        // altitude (km)
+	ST_PITCH,      // pitch (deg)
+	ST_ROLL,       // bank (deg, wraps at +-180)
+	ST_YAW,        // slip angle (deg, wraps at +-180)
+	ST_V_RAD,      // radial velocity (m/s)
+	ST_V_TAN,      // tangential velocity (m/s)
+	ST_V_MAG,      // velocity magnitude (m/s)
+	ST_SURF_LON,   // surface longitude (deg, wraps at +-180)
+	ST_SURF_LAT,   // surface latitude (deg)
+	ST_SURF_HDG,   // surface heading (deg, wraps at 0/360)
+	ST_DIST,       // range to target base (km)
+	ST_AOA,        // angle of attack (deg)
+	ST_MACH,       // Mach number
+	ST_LIFT,       // lift
+	ST_DRAG,       // drag
+	ST_ATM_T,      // atmospheric temperature
+	ST_ATM_STP,    // atmospheric pressure
+	ST_ATM_DYNP,   // dynamic pressure
+	ST_ATM_D,      // atmospheric density
+	ST_FUEL_MASS,  // propellant mass (kg)
+	ST_FUEL_RATE,  // propellant flow rate (kg/s)
+	ST_MAIN_T,     // main thrust level (%)
+	ST_HOVER_T,    // hover thrust level (%)
+	ST_THRUST,     // thrust magnitude (N)
+	ST_MASS,       // vessel mass (kg)
+	ST_AIRSPEED,   // airspeed (m/s)
+	ST_ORB_APO,    // orbit elements, in the order of OE_* (OrbitElements.h):
+	ST_ORB_PERI,   //   apoapsis and periapsis altitude (km),
+	ST_ORB_ECC,    //   eccentricity,
+	ST_ORB_INC,    //   inclination (deg),
+	ST_ORB_MANOM,  //   mean anomaly (deg, wraps at +-180),
+	ST_ORB_PERIOD, //   period (s),
+	ST_ORB_ENERGY, //   specific energy (MJ/kg)
+	ST_ALT_GND,    // altitude above the ground (km), for the touchdown detectors
+	NSTATE
+};
+
+struct FDState {
+	double t;          // sim time of the state
+	double v[NSTATE];  // channel values
+};
+
+// Keeps the two most recent captured states and emits samples at the exact
+// grid times k*dt that fall between them by linear interpolation. Several
+// grid points may be emitted for a single capture under time acceleration.
+class Resampler {
+public:
+	Resampler ();
+	void Reset ();
+	void SetInterval (double _dt);
+	void SetMaxBurst (int n) { maxburst = n; }
+	double Interval () const { return dt; }
+	double Next () const;
+	void Push (const FDState &s);
+	bool Emit (FDState &s, int &interp);
+	double Rate (int ch) const;
+	int Captures () const { return nstate; }
+	const FDState &Current () const { return cur; }
+	const FDState &Previous () const { return prev; }
+	void Restore (const FDState &p, const FDState &c, int n, double shift);
+
+private:
+	double Eps () const { return dt*1e-6; }
+	FDState prev, cur;  // bracketing captured states
+	int nstate;         // number of valid captured states (0..2)
+	long long knext;    // grid index of next sample
+	int maxburst;       // max grid samples emitted per capture
+	double dt;          // grid interval
+};
+
+#endif // !__RESAMPLE_H
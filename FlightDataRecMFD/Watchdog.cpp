@@ -0,0 +1,107 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// Watchdog.cpp
+// Per-step latency budget of the recorder.
+// ==============================================================
+
+#include "Watchdog.h"
+
+static const int RECOVER_STEPS = 100;     // steps within budget before restoring a level
+static const double RECOVER_FRAC = 0.5;   // "well within budget" fraction
+static const int ESCALATE_STEPS = 3;      // consecutive steps over budget before shedding a level
+static const double HIT_WINDOW = 32.0;    // steps in the hit rate average
+static const double ESCALATE_RATE = 0.25; // hit rate that sheds a level
+
+Watchdog::Watchdog ()
+{
+	budget = 0.0;
+	Reset();
+}
+
+void Watchdog::SetBudget (double us)
+{
+	budget = (us > 0.0 ? us : 0.0);
+	Reset();
+}
+
+void Watchdog::Reset ()
+{
+	tstep = tcharge = tplot = 0.0;
+	level = plevel = WD_FULL;
+	tlevel = -1.0;
+	pdur = 0.0;
+	nok = nover = nplotover = 0;
+	hitavg = 0.0;
+	nstep = nhit = 0;
+}
+
+void Watchdog::Begin ()
+{
+	t0 = std::chrono::steady_clock::now();
+}
+
+// time since Begin (us)
+double Watchdog::Elapsed () const
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// add the time since 'since' (us) to the current step
+void Watchdog::Charge (std::chrono::steady_clock::time_point since)
+{
+	tcharge += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+}
+
+// close the current step; true if the degradation level changed
+bool Watchdog::End (double simt)
+{
+	int nlevel = level;
+	bool charged = (tcharge > 0.0);
+
+	tstep = Elapsed() + tcharge;
+	if (charged) tplot = (tplot > 0.0 ? 0.8*tplot + 0.2*tcharge : tcharge);
+	tcharge = 0.0;
+	if (tlevel < 0.0) tlevel = simt;
+	nstep++;
+	if (tstep > budget) {
+		nhit++;
+		nok = 0;
+		nover++;
+		if (charged) nplotover++;
+		hitavg += (1.0-hitavg)/HIT_WINDOW;
+		if ((nover >= ESCALATE_STEPS || nplotover >= ESCALATE_STEPS || hitavg > ESCALATE_RATE)
+			&& level < WD_NLEVEL-1) {
+			nlevel = level+1;
+			nover = nplotover = 0;
+			hitavg = 0.0;
+		}
+	} else {
+		nover = 0;
+		if (charged) nplotover = 0;
+		hitavg -= hitavg/HIT_WINDOW;
+		// with the plots shed, their last cost counts as if they were back
+		double t = tstep + (level >= WD_NO_PLOT ? tplot : 0.0);
+		if (t < budget*RECOVER_FRAC) {
+			if (++nok >= RECOVER_STEPS && level > WD_FULL) {
+				nlevel = level-1;
+				nok = 0;
+			}
+		} else {
+			nok = 0;
+		}
+	}
+	if (nlevel == level) return false;
+	plevel = level;
+	pdur = simt-tlevel;
+	level = nlevel;
+	tlevel = simt;
+	return true;
+}
+
+const char *WatchdogLevelName (int level)
+{
+	static const char *name[WD_NLEVEL] = {"FULL", "NO_OPTIONAL", "DEFER_LOG", "NO_PLOT"};
+	return (level >= 0 && level < WD_NLEVEL ? name[level] : "");
+}
@@ -0,0 +1,66 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightDataRecMFD
+//                  Part of the ORBITER SDK
+//
+// Watchdog.h
+// Per-step latency budget of the recorder.
+// ==============================================================
+
+#ifndef __WATCHDOG_H
+#define __WATCHDOG_H
+
+#include <chrono>
+
+// degradation levels, in the order work is shed
+enum {
+	WD_FULL,         // everything enabled
+	WD_NO_OPTIONAL,  // skip expensive optional channels
+	WD_DEFER_LOG,    // defer log formatting to later steps
+	WD_NO_PLOT,      // drop MFD plot refresh
+	WD_NLEVEL
+};
+
+// Measures each recorder step against a microsecond budget. The MFD plot
+// refresh between two steps is charged to the next one, so the plot level
+// has a cost to shed. A run of steps over budget, or a hit rate over the
+// recent steps above a limit, sheds one more level of work; one step over
+// budget (a time warp burst) does not. A run of steps well within budget,
+// counting the plot cost that would come back, restores one level.
+class Watchdog {
+public:
+	Watchdog ();
+	void SetBudget (double us);
+	double Budget () const { return budget; }
+	bool Enabled () const { return budget > 0.0; }
+	void Reset ();
+	void Begin ();
+	double Elapsed () const;
+	void Charge (std::chrono::steady_clock::time_point since);  // work outside the step
+	bool End (double simt);
+	int Level () const { return level; }
+	int PrevLevel () const { return plevel; }
+	double PrevDuration () const { return pdur; }
+	double StepTime () const { return tstep; }
+	double HitRate () const { return nstep ? (double)nhit/(double)nstep : 0.0; }
+
+private:
+	std::chrono::steady_clock::time_point t0;  // start of the current step
+	double budget;   // step budget (us), 0 = disabled
+	double tstep;    // duration of the last step (us)
+	double tcharge;  // work charged to the current step (us)
+	double tplot;    // mean charged work of the steps that had some (us)
+	int level;       // current degradation level
+	int plevel;      // level before the last change
+	double tlevel;   // sim time at which the current level was entered
+	double pdur;     // sim time spent in the previous level
+	int nok;         // consecutive steps well within budget
+	int nover;       // consecutive steps over budget
+	int nplotover;   // consecutive charged steps over budget
+	double hitavg;   // recent hit rate (moving average)
+	long nstep;      // measured steps
+	long nhit;       // steps over budget
+};
+
+const char *WatchdogLevelName (int level);
+
+#endif // !__WATCHDOG_H
@@ -0,0 +1,217 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// ChunkLog.cpp
+// Chunked columnar flight log with per-chunk min/max (zone maps).
+// ==============================================================
+
+#include <cmath>
+#include <cstring>
+#include "ChunkLog.h"
+#include "LogReader.h"
+
+static long long TellFile (FILE *f)
+{
+#ifdef _WIN32
+	return _ftelli64 (f);
+#else
+	return (long long)ftello (f);
+#endif
+}
+
+// ---------------------------------------------------------------------
+// writer
+
+ChunkLogWriter::ChunkLogWriter ()
+{
+	f = 0;
+	buf = mn = mx = 0;
+	ncol = chunkrows = n = 0;
+	ok = false;
+}
+
+ChunkLogWriter::~ChunkLogWriter ()
+{
+	Close();
+}
+
+bool ChunkLogWriter::Open (const char *path, int _ncol, int _chunkrows)
+{
+	Close();
+	if (_ncol < 1 || _chunkrows < 1 || !(f = fopen (path, "wb"))) return false;
+	ncol = _ncol, chunkrows = _chunkrows, n = 0;
+	buf = new float[(size_t)ncol*chunkrows];
+	mn = new float[ncol];
+	mx = new float[ncol];
+	idx.clear(), zmin.clear(), zmax.clear();
+
+	ChunkFileHeader h;
+	memcpy (h.magic, "FDCX", 4);
+	h.version = CHUNKLOG_VERSION;
+	h.ncol = ncol;
+	h.chunkrows = chunkrows;
+	ok = fwrite (&h, sizeof(h), 1, f) == 1;
+	return ok;
+}
+
+bool ChunkLogWriter::Add (const float *row)
+{
+	if (!f) return false;
+	// NaN never widens the zone map, it matches no predicate either
+	for (int c = 0; c < ncol; c++) {
+		float v = row[c];
+		buf[(size_t)c*chunkrows+n] = v;
+		if (!n) mn[c] = HUGE_VALF, mx[c] = -HUGE_VALF;
+		if (v < mn[c]) mn[c] = v;
+		if (v > mx[c]) mx[c] = v;
+	}
+	if (++n == chunkrows) Flush();
+	return ok;
+}
+
+bool ChunkLogWriter::Flush ()
+{
+	if (!n) return ok;
+	ChunkIndex ci;
+	ChunkHeader ch;
+	ci.ofs = TellFile (f);
+	ci.nrows = n;
+	ci.reserved = 0;
+	memcpy (ch.magic, "FDCK", 4);
+	ch.nrows = n;
+	ok = ok && fwrite (&ch, sizeof(ch), 1, f) == 1;
+	ok = ok && fwrite (mn, sizeof(float), ncol, f) == (size_t)ncol;
+	ok = ok && fwrite (mx, sizeof(float), ncol, f) == (size_t)ncol;
+	for (int c = 0; c < ncol; c++)
+		ok = ok && fwrite (buf+(size_t)c*chunkrows, sizeof(float), n, f) == (size_t)n;
+	idx.push_back (ci);
+	zmin.insert (zmin.end(), mn, mn+ncol);
+	zmax.insert (zmax.end(), mx, mx+ncol);
+	n = 0;
+	return ok;
+}
+
+bool ChunkLogWriter::Close ()
+{
+	if (!f) return false;
+	Flush();
+	ChunkTrailer t;
+	t.index = TellFile (f);
+	t.nchunk = (int)idx.size();
+	memcpy (t.magic, "FDCI", 4);
+	if (!idx.empty()) {
+		ok = ok && fwrite (idx.data(), sizeof(ChunkIndex), idx.size(), f) == idx.size();
+		ok = ok && fwrite (zmin.data(), sizeof(float), zmin.size(), f) == zmin.size();
+		ok = ok && fwrite (zmax.data(), sizeof(float), zmax.size(), f) == zmax.size();
+	}
+	ok = ok && fwrite (&t, sizeof(t), 1, f) == 1;
+	ok = (fclose (f) == 0) && ok;
+	f = 0;
+	delete []buf;
+	delete []mn;
+	delete []mx;
+	buf = mn = mx = 0;
+	return ok;
+}
+
+// ---------------------------------------------------------------------
+// reader
+
+ChunkLogReader::ChunkLogReader ()
+{
+	f = 0;
+	ncol = chunkrows = 0;
+	nrows = nread = 0;
+	rebuilt = false;
+}
+
+ChunkLogReader::~ChunkLogReader ()
+{
+	Close();
+}
+
+void ChunkLogReader::Close ()
+{
+	if (f) fclose (f);
+	f = 0;
+}
+
+bool ChunkLogReader::Open (const char *path)
+{
+	ChunkFileHeader h;
+	ChunkTrailer t;
+	long long size;
+
+	Close();
+	idx.clear(), zmin.clear(), zmax.clear();
+	nrows = nread = 0;
+	rebuilt = false;
+	if ((size = LogReader::FileSize (path)) < (long long)sizeof(h) || !(f = fopen (path, "rb"))) return false;
+	if (fread (&h, sizeof(h), 1, f) != 1 || memcmp (h.magic, "FDCX", 4) ||
+		h.version != CHUNKLOG_VERSION || h.ncol < 1 || h.chunkrows < 1) {
+		Close();
+		return false;
+	}
+	ncol = h.ncol, chunkrows = h.chunkrows;
+
+	bool indexed = size >= (long long)(sizeof(h)+sizeof(t)) &&
+		!SeekFile (f, size-sizeof(t)) && fread (&t, sizeof(t), 1, f) == 1 &&
+		!memcmp (t.magic, "FDCI", 4) && t.nchunk >= 0 &&
+		t.index + t.nchunk*(long long)(sizeof(ChunkIndex)+2*ncol*sizeof(float)) + (long long)sizeof(t) == size;
+	if (indexed) {
+		idx.resize (t.nchunk);
+		zmin.resize ((size_t)t.nchunk*ncol);
+		zmax.resize ((size_t)t.nchunk*ncol);
+		indexed = !SeekFile (f, t.index) &&
+			fread (idx.data(), sizeof(ChunkIndex), t.nchunk, f) == (size_t)t.nchunk &&
+			fread (zmin.data(), sizeof(float), zmin.size(), f) == zmin.size() &&
+			fread (zmax.data(), sizeof(float), zmax.size(), f) == zmax.size();
+		for (int k = 0; indexed && k < t.nchunk; k++)
+			indexed = idx[k].nrows > 0 && idx[k].nrows <= chunkrows;
+	}
+	if (!indexed && !Rebuild (size)) {
+		Close();
+		return false;
+	}
+	for (size_t k = 0; k < idx.size(); k++) nrows += idx[k].nrows;
+	return true;
+}
+
+// walk the chunk headers of a log without index, up to the last chunk
+// that was written completely
+bool ChunkLogReader::Rebuild (long long size)
+{
+	long long ofs = sizeof(ChunkFileHeader);
+	ChunkHeader ch;
+	std::vector<float> z(2*ncol);
+
+	idx.clear(), zmin.clear(), zmax.clear();
+	rebuilt = true;
+	while (ofs + (long long)sizeof(ch) <= size) {
+		if (SeekFile (f, ofs) || fread (&ch, sizeof(ch), 1, f) != 1 ||
+			memcmp (ch.magic, "FDCK", 4) || ch.nrows < 1 || ch.nrows > chunkrows) break;
+		long long end = ofs + sizeof(ch) + (2*ncol + (long long)ncol*ch.nrows)*sizeof(float);
+		if (end > size || fread (z.data(), sizeof(float), 2*ncol, f) != (size_t)(2*ncol)) break;
+		ChunkIndex ci = {ofs, ch.nrows, 0};
+		idx.push_back (ci);
+		zmin.insert (zmin.end(), z.begin(), z.begin()+ncol);
+		zmax.insert (zmax.end(), z.begin()+ncol, z.end());
+		ofs = end;
+	}
+	return true;
+}
+
+long long ChunkLogReader::ColumnOffset (int k, int c) const
+{
+	const ChunkIndex &ci = idx[k];
+	return ci.ofs + sizeof(ChunkHeader) + (2*ncol + (long long)c*ci.nrows)*sizeof(float);
+}
+
+bool ChunkLogReader::ReadColumn (int k, int c, float *out)
+{
+	const ChunkIndex &ci = idx[k];
+	if (SeekFile (f, ColumnOffset (k, c)) || fread (out, sizeof(float), ci.nrows, f) != (size_t)ci.nrows) return false;
+	nread += (long long)ci.nrows*sizeof(float);
+	return true;
+}
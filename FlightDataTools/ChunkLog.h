@@ -0,0 +1,99 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// ChunkLog.h
+// Chunked columnar flight log with per-chunk min/max (zone maps).
+// ==============================================================
+
+#ifndef __CHUNKLOG_H
+#define __CHUNKLOG_H
+
+#include <cstdio>
+#include <vector>
+
+// File layout (native byte order):
+//   ChunkFileHeader
+//   per chunk: ChunkHeader, min[ncol], max[ncol], then the chunk's rows
+//              column by column, ncol*nrows floats
+//   index:     ChunkIndex[nchunk], all chunk minima, all chunk maxima
+//   ChunkTrailer
+// The index repeats the chunk headers' zone maps in one block so a query
+// can prune without touching the data. A file whose writer did not close
+// it has no trailer; the reader then rebuilds the index from the chunk
+// headers.
+
+struct ChunkFileHeader {
+	char magic[4];         // "FDCX"
+	unsigned version;      // CHUNKLOG_VERSION
+	int ncol;
+	int chunkrows;         // rows per full chunk
+};
+
+struct ChunkHeader {
+	char magic[4];         // "FDCK"
+	int nrows;
+};
+
+struct ChunkIndex {
+	long long ofs;         // file offset of the ChunkHeader
+	int nrows;
+	int reserved;
+};
+
+struct ChunkTrailer {
+	long long index;       // file offset of the index
+	int nchunk;
+	char magic[4];         // "FDCI"
+};
+
+const unsigned CHUNKLOG_VERSION = 1;
+
+class ChunkLogWriter {
+public:
+	ChunkLogWriter ();
+	~ChunkLogWriter ();
+	bool Open (const char *path, int _ncol, int _chunkrows = 4096);
+	bool Add (const float *row);
+	bool Close ();
+
+private:
+	bool Flush ();
+	FILE *f;
+	int ncol, chunkrows, n;
+	float *buf;                    // current chunk, column by column
+	float *mn, *mx;                // its zone map
+	bool ok;
+	std::vector<ChunkIndex> idx;
+	std::vector<float> zmin, zmax;
+};
+
+class ChunkLogReader {
+public:
+	ChunkLogReader ();
+	~ChunkLogReader ();
+	bool Open (const char *path);
+	void Close ();
+	int  Columns () const { return ncol; }
+	int  Chunks () const { return (int)idx.size(); }
+	int  ChunkRows () const { return chunkrows; }
+	int  Rows (int k) const { return idx[k].nrows; }
+	long long Rows () const { return nrows; }
+	const float *Min (int k) const { return &zmin[(size_t)k*ncol]; }
+	const float *Max (int k) const { return &zmax[(size_t)k*ncol]; }
+	bool ReadColumn (int k, int c, float *out);
+	long long ColumnOffset (int k, int c) const;   // file offset of column c of chunk k
+	long long BytesRead () const { return nread; }
+	bool Rebuilt () const { return rebuilt; }
+
+private:
+	bool Rebuild (long long size);
+	FILE *f;
+	int ncol, chunkrows;
+	long long nrows, nread;
+	bool rebuilt;
+	std::vector<ChunkIndex> idx;
+	std::vector<float> zmin, zmax;
+};
+
+#endif // !__CHUNKLOG_H
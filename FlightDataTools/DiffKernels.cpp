@@ -0,0 +1,144 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// DiffKernels.cpp
+// Alignment and error kernels for comparing two flights sample by
+// sample (see fddiff).
+//
+// Apart from the alignment walk and the interpolating gather, the loops
+// run over contiguous floats without branches and keep their sums in
+// LANES independent accumulators, so the compiler can vectorise them
+// without reordering a single serial sum.
+// ==============================================================
+
+#include <cmath>
+#include "DiffKernels.h"
+
+#define LANES 8
+#define BLOCK 256
+
+bool AlignKeys (const float *a, long long na, const float *b, long long nb,
+	int *j, float *f, long long &i0, long long &i1)
+{
+	i0 = i1 = 0;
+	if (na < 1 || nb < 2) return false;
+	long long i = 0, k = 0;
+	while (i < na && a[i] < b[0]) i++;
+	i0 = i;
+	for (; i < na && a[i] <= b[nb-1]; i++) {
+		while (k+2 < nb && b[k+1] <= a[i]) k++;
+		j[i] = (int)k;
+		f[i] = (a[i] - b[k]) / (b[k+1] - b[k]);
+	}
+	i1 = i;
+	return i1 > i0;
+}
+
+void Residual (const float *ya, const float *yb, const int *j, const float *f,
+	long long i0, long long i1, float period, float *err)
+{
+	long long i;
+	if (!period) {
+		for (i = i0; i < i1; i++) {
+			float y0 = yb[j[i]], y1 = yb[j[i]+1];
+			err[i] = ya[i] - (y0 + f[i]*(y1-y0));
+		}
+		return;
+	}
+	const float rp = 1.0f/period;
+	for (i = i0; i < i1; i++) {
+		float y0 = yb[j[i]], d = yb[j[i]+1] - y0;
+		d -= period*std::nearbyint (d*rp);
+		float e = ya[i] - (y0 + f[i]*d);
+		err[i] = e - period*std::nearbyint (e*rp);
+	}
+}
+
+void ErrorStatistics (const float *err, long long i0, long long i1, ErrStats &s)
+{
+	double sum[LANES] = {0}, sq[LANES] = {0}, cnt[LANES] = {0};
+	float mx[LANES] = {0};
+	long long i = i0;
+	int l;
+
+	// NaN errors select zero and are not counted
+	for (; i+LANES <= i1; i += LANES)
+		for (l = 0; l < LANES; l++) {
+			float e = err[i+l];
+			float ok = (e == e) ? 1.0f : 0.0f;
+			float z = (e == e) ? e : 0.0f;
+			float ae = std::fabs (z);
+			sum[l] += z;
+			sq[l] += (double)z*z;
+			cnt[l] += ok;
+			mx[l] = (ae > mx[l] ? ae : mx[l]);
+		}
+	for (l = 0; i < i1; i++, l++) {
+		float e = err[i];
+		if (e != e) continue;
+		sum[l] += e, sq[l] += (double)e*e, cnt[l] += 1.0;
+		if (std::fabs (e) > mx[l]) mx[l] = std::fabs (e);
+	}
+
+	double tsum = 0, tsq = 0, tcnt = 0;
+	float tmax = 0;
+	for (l = 0; l < LANES; l++) {
+		tsum += sum[l], tsq += sq[l], tcnt += cnt[l];
+		if (mx[l] > tmax) tmax = mx[l];
+	}
+	s.n = (long long)tcnt;
+	s.mean = s.n ? tsum/s.n : 0.0;
+	s.rms = s.n ? std::sqrt (tsq/s.n) : 0.0;
+	s.maxabs = tmax;
+	s.imax = -1;
+	if (s.n)
+		for (i = i0; i < i1; i++)
+			if (std::fabs (err[i]) == tmax) { s.imax = i; break; }
+}
+
+bool ValueRange (const float *y, long long i0, long long i1, float &mn, float &mx)
+{
+	float lo[LANES], hi[LANES];
+	long long i = i0;
+	int l;
+	for (l = 0; l < LANES; l++) lo[l] = HUGE_VALF, hi[l] = -HUGE_VALF;
+	// NaN compares false and leaves the lane as it was
+	for (; i+LANES <= i1; i += LANES)
+		for (l = 0; l < LANES; l++) {
+			float v = y[i+l];
+			lo[l] = (v < lo[l] ? v : lo[l]);
+			hi[l] = (v > hi[l] ? v : hi[l]);
+		}
+	for (; i < i1; i++) {
+		if (y[i] < lo[0]) lo[0] = y[i];
+		if (y[i] > hi[0]) hi[0] = y[i];
+	}
+	mn = HUGE_VALF, mx = -HUGE_VALF;
+	for (l = 0; l < LANES; l++) {
+		if (lo[l] < mn) mn = lo[l];
+		if (hi[l] > mx) mx = hi[l];
+	}
+	return mn <= mx;
+}
+
+long long FirstDivergence (const float *err, long long i0, long long i1, float tol, int persist)
+{
+	long long i = i0, run = 0;
+	if (persist < 1) persist = 1;
+	while (i < i1) {
+		// skip whole blocks that stay within tolerance
+		if (!run && i+BLOCK <= i1) {
+			int over = 0;
+			for (int k = 0; k < BLOCK; k++) over |= (std::fabs (err[i+k]) > tol);
+			if (!over) { i += BLOCK; continue; }
+		}
+		long long end = (i+BLOCK < i1 ? i+BLOCK : i1);
+		for (; i < end; i++) {
+			if (std::fabs (err[i]) > tol) {
+				if (++run == persist) return i-persist+1;
+			} else run = 0;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,44 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// DiffKernels.h
+// Alignment and error kernels for comparing two flights sample by
+// sample (see fddiff).
+// ==============================================================
+
+#ifndef __DIFFKERNELS_H
+#define __DIFFKERNELS_H
+
+// Aligns the samples of key 'a' to key 'b', both strictly rising. For
+// every a[i] inside b's range, b[j[i]] <= a[i] <= b[j[i]+1] and f[i] is
+// the fraction of the way from one to the other. The aligned samples form
+// the range [i0,i1); returns false if the keys do not overlap.
+bool AlignKeys (const float *a, long long na, const float *b, long long nb,
+	int *j, float *f, long long &i0, long long &i1);
+
+// err[i] = ya[i] - yb interpolated at (j[i],f[i]), for i in [i0,i1).
+// With a nonzero period the channel is an angle: the interpolation and
+// the error are taken the short way round.
+void Residual (const float *ya, const float *yb, const int *j, const float *f,
+	long long i0, long long i1, float period, float *err);
+
+struct ErrStats {
+	long long n;       // samples with a valid error
+	double mean;       // mean error (bias)
+	double rms;
+	double maxabs;
+	long long imax;    // sample of the largest |error|, -1 if none
+};
+
+// NaN errors (channel not logged) are left out
+void ErrorStatistics (const float *err, long long i0, long long i1, ErrStats &s);
+
+// range of y over [i0,i1), NaN ignored; false if there is no value
+bool ValueRange (const float *y, long long i0, long long i1, float &mn, float &mx);
+
+// first sample at which |err| exceeds tol for 'persist' samples in a row,
+// or -1
+long long FirstDivergence (const float *err, long long i0, long long i1, float tol, int persist);
+
+#endif // !__DIFFKERNELS_H
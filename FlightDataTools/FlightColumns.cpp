@@ -0,0 +1,119 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// FlightColumns.cpp
+// Selected channels of a whole flight log, held column by column.
+// ==============================================================
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include "..//FlightDataCommon//MappedFile.h"
+#include "ChunkLog.h"
+#include "FlightColumns.h"
+#include "LogReader.h"
+
+FlightColumns::FlightColumns ()
+{
+	for (int c = 0; c < NCOL; c++) want[c] = false;
+	nrows = 0;
+}
+
+bool FlightColumns::Load (const char *path, const std::vector<int> &cols, char delim)
+{
+	int c;
+	for (c = 0; c < NCOL; c++) want[c] = false, col[c].clear();
+	for (size_t k = 0; k < cols.size(); k++) want[cols[k]] = true;
+	nrows = 0;
+
+	std::string p (path);
+	size_t dot = p.find_last_of ('.');
+	if (dot != std::string::npos && p.substr (dot) == ".fdx") return LoadChunked (path);
+	return LoadText (path, delim ? delim : LogReader::DetectDelim (path));
+}
+
+bool FlightColumns::LoadText (const char *path, char delim)
+{
+	MappedFile mf;
+	if (!mf.Open (path)) return false;
+	const char *s = mf.Data(), *end = s + mf.Size();
+	int c, last = -1;
+	for (c = 0; c < NCOL; c++) if (want[c]) last = c;
+
+	// size the columns from the line length at the start of the log
+	const char *nl = (const char*)memchr (s, '\n', end-s < 65536 ? end-s : 65536);
+	if (nl && nl > s) {
+		size_t est = (size_t)(mf.Size() / (nl-s+1)) + 16;
+		for (c = 0; c < NCOL; c++) if (want[c]) col[c].reserve (est);
+	}
+
+	auto isdelim = [delim](char ch) {
+		if (ch == '\r') return true;
+		return delim ? ch == delim : (ch == ' ' || ch == '\t' || ch == ',' || ch == ';' || ch == '|');
+	};
+	while (s < end) {
+		const char *e = (const char*)memchr (s, '\n', end-s);
+		if (!e) e = end;
+		const char *q = s;
+		int n = 0;
+		float v[NCOL];
+		while (q < e && n <= last) {
+			while (q < e && isdelim (*q)) q++;
+			if (q == e) break;
+			const char *t = q;
+			while (t < e && !isdelim (*t)) t++;
+			if (want[n]) {
+				const char *b = (*q == '+' ? q+1 : q);
+				std::from_chars_result r = std::from_chars (b, t, v[n]);
+				if (r.ec != std::errc() || r.ptr != t) v[n] = NAN;
+			}
+			n++;
+			q = t;
+		}
+		if (n) {
+			for (c = 0; c <= last; c++)
+				if (want[c]) col[c].push_back (c < n ? v[c] : NAN);
+			nrows++;
+		}
+		s = e+1;
+	}
+	return true;
+}
+
+bool FlightColumns::LoadChunked (const char *path)
+{
+	ChunkLogReader rd;
+	MappedFile mf;
+	if (!rd.Open (path) || rd.Columns() < NCOL_V1 || !mf.Open (path)) return false;
+	int c, k;
+	for (c = 0; c < NCOL; c++) if (want[c]) col[c].assign (rd.Rows(), NAN);
+	long long r = 0;
+	for (k = 0; k < rd.Chunks(); k++) {
+		for (c = 0; c < NCOL && c < rd.Columns(); c++)
+			if (want[c]) memcpy (&col[c][r], mf.Data() + rd.ColumnOffset (k, c), rd.Rows (k)*sizeof(float));
+		r += rd.Rows (k);
+	}
+	nrows = r;
+	return true;
+}
+
+void FlightColumns::KeepRising (int key)
+{
+	const float *kv = col[key].data();
+	long long i, w = 0, imax = -1;
+	int c;
+	for (i = 0; i < nrows; i++)
+		if (!std::isnan (kv[i]) && (imax < 0 || kv[i] > kv[imax])) imax = i;
+	float top = -HUGE_VALF;
+	for (i = 0; i <= imax; i++) {
+		if (!(kv[i] > top)) continue;     // also drops NaN
+		top = kv[i];
+		if (w != i)
+			for (c = 0; c < NCOL; c++) if (want[c]) col[c][w] = col[c][i];
+		w++;
+	}
+	for (c = 0; c < NCOL; c++) if (want[c]) col[c].resize (w);
+	nrows = w;
+}
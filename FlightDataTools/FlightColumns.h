@@ -0,0 +1,41 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// FlightColumns.h
+// Selected channels of a whole flight log, held column by column.
+// ==============================================================
+
+#ifndef __FLIGHTCOLUMNS_H
+#define __FLIGHTCOLUMNS_H
+
+#include <vector>
+#include "LogFormat.h"
+
+// Loads the requested columns of a text log (.dat/.csv) or a chunked log
+// (.fdx, see fdindex) into one float array per column. Both are read
+// through a memory mapping: the text is parsed in place, the chunked
+// columns are copied straight out of the mapping.
+class FlightColumns {
+public:
+	FlightColumns ();
+	bool Load (const char *path, const std::vector<int> &cols, char delim = 0);
+	long long Rows () const { return nrows; }
+	bool Has (int c) const { return want[c]; }
+	float *Col (int c) { return col[c].data(); }
+	const float *Col (int c) const { return col[c].data(); }
+
+	// keep only the rows where column 'key' rises above all earlier rows,
+	// up to its maximum: the monotonic part of an ascent for altitude,
+	// the whole log for sim time
+	void KeepRising (int key);
+
+private:
+	bool LoadText (const char *path, char delim);
+	bool LoadChunked (const char *path);
+	std::vector<float> col[NCOL];
+	bool want[NCOL];
+	long long nrows;
+};
+
+#endif // !__FLIGHTCOLUMNS_H
@@ -0,0 +1,92 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// FlightSummary.cpp
+// One-pass key figures of a flight log.
+// ==============================================================
+
+#include <cmath>
+#include "LogFormat.h"
+#include "FlightSummary.h"
+
+const double FlightAnalyzer::BURN_THR = 0.5;
+
+FlightAnalyzer::FlightAnalyzer ()
+{
+	airborne = 1.0;
+	tdalt = 0.5;
+	Reset();
+}
+
+void FlightAnalyzer::Reset ()
+{
+	sum.samples = 0;
+	sum.t_start = sum.t_end = NAN;
+	sum.max_q = sum.max_g = sum.apo_alt = -HUGE_VAL;
+	sum.max_q_t = sum.max_g_t = sum.apo_t = NAN;
+	sum.burns = 0;
+	sum.burn_time = sum.burn_max = sum.hover_time = 0.0;
+	sum.fuel_used = 0.0;
+	sum.landed = 0;
+	sum.td_t = sum.td_vrad = sum.td_range = NAN;
+	prev_t = prev_fuel = prev_vrad = prev_dist = NAN;
+	main_on = hover_on = up = have_prev = false;
+	burn_cur = 0.0;
+}
+
+void FlightAnalyzer::Add (const double *row, int n)
+{
+	double t = row[C_SIM_TIME];
+	if (n < MINCOL || std::isnan (t)) return;
+
+	// a time step backwards (recorder reset) contributes no interval
+	double dt = (have_prev && t > prev_t ? t-prev_t : 0.0);
+	if (!sum.samples) sum.t_start = t;
+	sum.t_end = t;
+	sum.samples++;
+
+	if (row[C_ATM_DYNP] > sum.max_q) sum.max_q = row[C_ATM_DYNP], sum.max_q_t = t;
+	if (row[C_A_G] > sum.max_g)      sum.max_g = row[C_A_G],      sum.max_g_t = t;
+	if (row[C_ALT] > sum.apo_alt)    sum.apo_alt = row[C_ALT],    sum.apo_t = t;
+
+	// engine time is credited to the interval following an 'on' sample
+	if (main_on) sum.burn_time += dt, burn_cur += dt;
+	if (hover_on) sum.hover_time += dt;
+	bool on = row[C_MAIN_T] > BURN_THR;
+	if (on && !main_on) sum.burns++, burn_cur = 0.0;
+	if (!on && main_on && burn_cur > sum.burn_max) sum.burn_max = burn_cur;
+	main_on = on;
+	hover_on = row[C_HOVER_T] > BURN_THR;
+
+	// refuelling is not counted as negative use
+	double fuel = row[C_FUEL_MASS];
+	if (have_prev && fuel < prev_fuel) sum.fuel_used += prev_fuel-fuel;
+
+	double alt = row[C_ALT], vrad = row[C_V_RAD];
+	if (!sum.landed) {
+		if (alt > airborne) up = true;
+		if (up && alt < tdalt && vrad >= 0.0 && prev_vrad < 0.0) {
+			sum.landed = 1;
+			sum.td_t = t;
+			sum.td_vrad = prev_vrad;
+			sum.td_range = row[C_DIST];
+		}
+	}
+
+	if (!std::isnan (fuel)) prev_fuel = fuel;
+	prev_t = t;
+	prev_vrad = vrad;
+	prev_dist = row[C_DIST];
+	have_prev = true;
+}
+
+void FlightAnalyzer::Finish (FlightSummary &s) const
+{
+	s = sum;
+	if (main_on && burn_cur > s.burn_max) s.burn_max = burn_cur;
+	if (s.max_q == -HUGE_VAL) s.max_q = NAN;
+	if (s.max_g == -HUGE_VAL) s.max_g = NAN;
+	if (s.apo_alt == -HUGE_VAL) s.apo_alt = NAN;
+	if (!s.landed) s.td_range = prev_dist;
+}
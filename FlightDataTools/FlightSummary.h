@@ -0,0 +1,73 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// FlightSummary.h
+// One-pass key figures of a flight log.
+// ==============================================================
+
+#ifndef __FLIGHTSUMMARY_H
+#define __FLIGHTSUMMARY_H
+
+// Key figures of one flight. Times are sim times (s); NaN where a figure
+// does not apply (e.g. no touchdown).
+struct FlightSummary {
+	long long samples;
+	double t_start, t_end;
+	double max_q, max_q_t;        // peak dynamic pressure (Pa)
+	double max_g, max_g_t;        // peak net acceleration (G)
+	double apo_alt, apo_t;        // highest altitude reached (km)
+	int    burns;                 // main engine burns
+	double burn_time;             // total main engine burn time (s)
+	double burn_max;              // longest main engine burn (s)
+	double hover_time;            // total hover engine burn time (s)
+	double fuel_used;             // sum of fuel mass decreases (kg)
+	int    landed;                // touchdown detected
+	double td_t, td_vrad;         // touchdown time, radial velocity (m/s)
+	double td_range;              // range to target at touchdown, else at the end (km)
+};
+
+// binary summary table (fdstats -b): header, then 'count' records of
+// 'recsize' bytes, native byte order
+struct SummaryFileHeader {
+	char magic[4];                // "FDSM"
+	unsigned version;             // SUMMARY_VERSION
+	unsigned count;
+	unsigned recsize;             // sizeof(SummaryRecord)
+};
+
+struct SummaryRecord {
+	char file[128];               // log file name, without directory
+	FlightSummary s;
+};
+
+const unsigned SUMMARY_VERSION = 1;
+
+// Streams the rows of one log and keeps the running figures, so a log of
+// any length is summarised in one pass and constant memory.
+//
+// A burn is a run of samples with the throttle above BURN_THR %; its time
+// is accumulated from the sample intervals. Touchdown is the first sample
+// after having been above 'airborne' km at which the descent ends (v_rad
+// no longer negative) below 'tdalt' km; the radial velocity of the last
+// descending sample is the touchdown velocity.
+class FlightAnalyzer {
+public:
+	FlightAnalyzer ();
+	void SetTouchdown (double _airborne, double _tdalt) { airborne = _airborne, tdalt = _tdalt; }
+	void Reset ();
+	void Add (const double *row, int n);
+	void Finish (FlightSummary &s) const;
+
+	enum { MINCOL = 27 };      // rows up to eng_hover_t are required
+	static const double BURN_THR;
+
+private:
+	FlightSummary sum;
+	double airborne, tdalt;
+	double prev_t, prev_fuel, prev_vrad, prev_dist;
+	bool   main_on, hover_on, up, have_prev;
+	double burn_cur;
+};
+
+#endif // !__FLIGHTSUMMARY_H
@@ -0,0 +1,70 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// LogFormat.cpp
+// Column layout of FlightDataRecMFD flight logs (see Column_list.txt).
+// ==============================================================
+
+#include <cctype>
+#include <cstring>
+#include "LogFormat.h"
+
+const ColumnInfo logcol[NCOL] = {
+	{"sample",        "Sample", ""},
+	{"sim_time",      "Time",   "s"},
+	{"ves_alt",       "Alt",    "km"},
+	{"ves_pitch",     "Pitch",  "deg"},
+	{"ves_roll",      "Roll",   "deg"},
+	{"ves_yaw",       "Yaw",    "deg"},
+	{"ves_v_rad",     "Vrad",   "m/s"},
+	{"ves_v_tan",     "Vtan",   "m/s"},
+	{"ves_a_rad",     "Vacc",   "m/s^2"},
+	{"ves_a_tan",     "Tacc",   "m/s^2"},
+	{"ves_a_g",       "G",      "G"},
+	{"ves_surf_lon",  "Lon",    "deg"},
+	{"ves_surf_lat",  "Lat",    "deg"},
+	{"ves_surf_hdg",  "Hdg",    "deg"},
+	{"ves_dist",      "RTT",    "km"},
+	{"ves_aoa",       "AoA",    "deg"},
+	{"ves_mach",      "Mach",   ""},
+	{"ves_lift",      "Lift",   ""},
+	{"ves_drag",      "Drag",   ""},
+	{"atm_t",         "Temp",   "K"},
+	{"atm_stp",       "Press",  "Pa"},
+	{"atm_dynp",      "DynP",   "Pa"},
+	{"atm_d",         "Dens",   "kg/m^3"},
+	{"eng_fuel_mass", "Fuel",   "kg"},
+	{"eng_fuel_rate", "Flow",   "kg/s"},
+	{"eng_main_t",    "Main",   "%"},
+	{"eng_hover_t",   "Hover",  "%"},
+	{"smp_q",         "Qual",   ""},
+	{"int_dv",        "dV",     "m/s"},
+	{"int_gnd",       "Gnd",    "km"},
+	{"int_heat",      "Heat",   "MJ/m^2"},
+	{"int_fuel",      "Burnt",  "kg"},
+	{"fuel_resid",    "Resid",  "kg"},
+	{"orb_apo",       "ApA",    "km"},
+	{"orb_peri",      "PeA",    "km"},
+	{"orb_ecc",       "Ecc",    ""},
+	{"orb_inc",       "Inc",    "deg"},
+	{"orb_t_apo",     "T-ApA",  "s"},
+	{"orb_energy",    "Energy", "MJ/kg"}
+};
+
+static bool Same (const char *a, const char *b)
+{
+	for (; *a && *b; a++, b++)
+		if (tolower ((unsigned char)*a) != tolower ((unsigned char)*b)) return false;
+	return *a == *b;
+}
+
+int FindColumn (const char *name)
+{
+	for (int i = 0; i < NCOL; i++) {
+		const char *n = logcol[i].name;
+		if (Same (name, n) || (!strncmp (n, "ves_", 4) && Same (name, n+4)) || Same (name, logcol[i].label))
+			return i;
+	}
+	return -1;
+}
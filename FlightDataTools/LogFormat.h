@@ -0,0 +1,72 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// LogFormat.h
+// Column layout of FlightDataRecMFD flight logs (see Column_list.txt).
+// ==============================================================
+
+#ifndef __LOGFORMAT_H
+#define __LOGFORMAT_H
+
+// logged columns, in file order
+enum {
+	C_SAMPLE,         // sample index
+	C_SIM_TIME,       // simulation elapsed time (s)
+	C_ALT,            // altitude (km)
+	C_PITCH,          // pitch (deg)
+	C_ROLL,           // roll (deg)
+	C_YAW,            // yaw (deg)
+	C_V_RAD,          // radial velocity (m/s)
+	C_V_TAN,          // tangential velocity (m/s)
+	C_A_RAD,          // radial acceleration (m/s^2)
+	C_A_TAN,          // tangential acceleration (m/s^2)
+	C_A_G,            // net acceleration (G)
+	C_SURF_LON,       // surface longitude (deg)
+	C_SURF_LAT,       // surface latitude (deg)
+	C_SURF_HDG,       // surface heading (deg)
+	C_DIST,           // range to target base (km)
+	C_AOA,            // angle of attack (deg)
+	C_MACH,           // Mach number
+	C_LIFT,           // lift
+	C_DRAG,           // drag
+	C_ATM_T,          // atmospheric temperature (K)
+	C_ATM_STP,        // atmospheric pressure (Pa)
+	C_ATM_DYNP,       // dynamic pressure (Pa)
+	C_ATM_D,          // atmospheric density (kg/m^3)
+	C_FUEL_MASS,      // total fuel mass (kg)
+	C_FUEL_RATE,      // total fuel flow rate (kg/s)
+	C_MAIN_T,         // main throttle setting (%)
+	C_HOVER_T,        // hover throttle setting (%)
+	C_SMP_Q,          // sample quality (0 = exact, 1 = interpolated)
+	C_INT_DV,         // delta-v expended (m/s)
+	C_INT_GND,        // ground track distance (km)
+	C_INT_HEAT,       // heat load proxy, rho*v^3 over time (MJ/m^2)
+	C_INT_FUEL,       // propellant flow over time (kg)
+	C_FUEL_RESID,     // propellant mass lost minus int_fuel (kg)
+	C_ORB_APO,        // apoapsis altitude (km, 0 when unbound)
+	C_ORB_PERI,       // periapsis altitude (km)
+	C_ORB_ECC,        // eccentricity
+	C_ORB_INC,        // inclination (deg)
+	C_ORB_T_APO,      // time to apoapsis (s, 0 when unbound)
+	C_ORB_ENERGY,     // specific orbital energy (MJ/kg)
+	NCOL
+};
+
+// columns of logs recorded before the integrated and orbit channels;
+// readers take the missing columns as NaN
+const int NCOL_V1 = C_SMP_Q+1;
+
+struct ColumnInfo {
+	const char *name;   // name as in Column_list.txt
+	const char *label;  // short axis label, as on the MFD
+	const char *unit;
+};
+
+extern const ColumnInfo logcol[NCOL];
+
+// column index from its name, with or without the "ves_" prefix, or from
+// its MFD label (case-insensitive); -1 if unknown
+int FindColumn (const char *name);
+
+#endif // !__LOGFORMAT_H
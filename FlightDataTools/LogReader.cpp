@@ -0,0 +1,193 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// LogReader.cpp
+// Streaming reader for FlightDataRecMFD flight logs.
+// ==============================================================
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include "LogReader.h"
+
+int SeekFile (FILE *f, long long ofs)
+{
+#ifdef _WIN32
+	return _fseeki64 (f, ofs, SEEK_SET);
+#else
+	return fseeko (f, (off_t)ofs, SEEK_SET);
+#endif
+}
+
+LogReader::LogReader (int _bufsize)
+{
+	f = 0;
+	bufsize = (_bufsize < 4096 ? 4096 : _bufsize);
+	buf = new char[bufsize];
+	len = p = 0;
+	lbeg = lend = 0;
+	fpos = fend = 0;
+	nline = 0;
+	delim = 0;
+}
+
+LogReader::~LogReader ()
+{
+	Close();
+	delete []buf;
+}
+
+// open the log for reading the lines in [begin,end); begin must be the
+// start of a line (see Split)
+bool LogReader::Open (const char *path, long long begin, long long end)
+{
+	Close();
+	if (!(f = fopen (path, "rb"))) return false;
+	if (begin && SeekFile (f, begin)) {
+		Close();
+		return false;
+	}
+	len = p = 0;
+	lbeg = lend = 0;
+	fpos = begin;
+	fend = (end < 0 ? -1 : end);
+	nline = 0;
+	return true;
+}
+
+void LogReader::Close ()
+{
+	if (f) fclose (f);
+	f = 0;
+}
+
+// move the unread bytes to the front of the buffer and read more
+bool LogReader::Fill ()
+{
+	if (!f) return false;
+	if (p) {
+		memmove (buf, buf+p, len-p);
+		len -= p;
+		p = 0;
+	}
+	long long want = bufsize-len;
+	if (fend >= 0 && want > fend-fpos) want = fend-fpos;
+	if (want <= 0) return false;
+	size_t n = fread (buf+len, 1, (size_t)want, f);
+	len += (int)n;
+	fpos += n;
+	return n > 0;
+}
+
+bool LogReader::IsDelim (char c) const
+{
+	if (delim) return c == delim || c == '\r';
+	return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '|' || c == '\r';
+}
+
+// parse the next non-empty line into row[0..maxcol-1]; returns the number
+// of fields on the line (which may exceed maxcol), or -1 at the end
+int LogReader::Next (double *row, int maxcol)
+{
+	for (;;) {
+		char *eol = (char*)memchr (buf+p, '\n', len-p);
+		if (!eol) {
+			if (len-p == bufsize) p = len;  // overlong line: drop it
+			if (!Fill()) {
+				if (p == len) return -1;
+				eol = buf+len;              // last line without newline
+			} else continue;
+		}
+		char *s = buf+p, *e = eol;
+		p = (int)(eol-buf) + (eol < buf+len ? 1 : 0);
+		lbeg = (int)(s-buf);
+		lend = (int)(e-buf);
+		if (lend > lbeg && buf[lend-1] == '\r') lend--;
+
+		int n = 0;
+		while (s < e) {
+			while (s < e && IsDelim (*s)) s++;
+			if (s == e) break;
+			char *t = s;
+			while (t < e && !IsDelim (*t)) t++;
+			if (n < maxcol) {
+				double v;
+				const char *q = (*s == '+' ? s+1 : s);
+				std::from_chars_result r = std::from_chars (q, t, v);
+				row[n] = (r.ec == std::errc() && r.ptr == t ? v : NAN);
+			}
+			n++;
+			s = t;
+		}
+		if (n) {
+			nline++;
+			return n;
+		}
+	}
+}
+
+long long LogReader::FileSize (const char *path)
+{
+	FILE *g = fopen (path, "rb");
+	if (!g) return -1;
+#ifdef _WIN32
+	_fseeki64 (g, 0, SEEK_END);
+	long long n = _ftelli64 (g);
+#else
+	fseeko (g, 0, SEEK_END);
+	long long n = (long long)ftello (g);
+#endif
+	fclose (g);
+	return n;
+}
+
+// split the log into n byte ranges [off[k],off[k+1]) that start on line
+// boundaries, for reading in parallel
+bool LogReader::Split (const char *path, int n, std::vector<long long> &off)
+{
+	long long size = FileSize (path);
+	if (size < 0) return false;
+	FILE *g = fopen (path, "rb");
+	if (!g) return false;
+	off.assign (1, 0);
+	char tmp[4096];
+	for (int k = 1; k < n; k++) {
+		long long o = size*k/n;
+		if (o <= off.back()) continue;
+		// advance to the byte after the next newline
+		SeekFile (g, o-1);
+		bool found = false;
+		while (!found) {
+			size_t m = fread (tmp, 1, sizeof(tmp), g);
+			if (!m) break;
+			char *nl = (char*)memchr (tmp, '\n', m);
+			if (nl) o += nl-tmp, found = true;
+			else o += m;
+		}
+		if (!found || o >= size) break;
+		if (o > off.back()) off.push_back (o);
+	}
+	off.push_back (size);
+	fclose (g);
+	return true;
+}
+
+// guess the delimiter of a log from its first line: the most frequent
+// character that cannot be part of a number. 0 (any default delimiter)
+// if there is none.
+char LogReader::DetectDelim (const char *path)
+{
+	FILE *g = fopen (path, "rb");
+	if (!g) return 0;
+	int count[256] = {0}, c, best = 0;
+	while ((c = fgetc (g)) != EOF && c != '\n') {
+		if (isdigit (c) || strchr (".+-eEnaifNAIF\r", c)) continue;
+		count[c]++;
+	}
+	fclose (g);
+	for (c = 1; c < 256; c++)
+		if (count[c] > count[best]) best = c;
+	return (char)best;
+}
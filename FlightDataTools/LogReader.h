@@ -0,0 +1,56 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// LogReader.h
+// Streaming reader for FlightDataRecMFD flight logs.
+// ==============================================================
+
+#ifndef __LOGREADER_H
+#define __LOGREADER_H
+
+#include <cstdio>
+#include <vector>
+
+// Reads the numeric rows of a flight log, or of a byte range of it, through
+// a fixed-size buffer, so memory does not depend on the log size. Fields
+// are separated by the recorder's delimiter character; by default any of
+// space, tab, comma, semicolon and '|' is accepted. Fields that are not
+// numbers read as NaN.
+class LogReader {
+public:
+	LogReader (int _bufsize = BUFSIZE);
+	~LogReader ();
+	bool Open (const char *path, long long begin = 0, long long end = -1);
+	void Close ();
+	void SetDelim (char c) { delim = c; }
+	char Delim () const { return delim; }
+	int  Next (double *row, int maxcol);
+	const char *Line (int &n) const { n = lend-lbeg; return buf+lbeg; }
+	long long Lines () const { return nline; }
+	long long Offset () const { return fpos - (len-p); }
+
+	static long long FileSize (const char *path);
+	static bool Split (const char *path, int n, std::vector<long long> &off);
+	static char DetectDelim (const char *path);
+
+	enum { BUFSIZE = 1 << 20 };
+
+private:
+	bool Fill ();
+	bool IsDelim (char c) const;
+	FILE *f;
+	char *buf;
+	int bufsize;
+	int len, p;          // bytes in buf, read position
+	int lbeg, lend;      // last line returned by Next, without newline
+	long long fpos;      // file offset of the end of buf
+	long long fend;      // end of the byte range
+	long long nline;     // lines returned
+	char delim;          // field delimiter, 0 = any of the defaults
+};
+
+// portable 64-bit seek
+int SeekFile (FILE *f, long long ofs);
+
+#endif // !__LOGREADER_H
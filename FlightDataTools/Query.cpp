@@ -0,0 +1,118 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// Query.cpp
+// Column predicates over chunked logs: zone-map pruning and
+// vectorisable per-chunk filters.
+// ==============================================================
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "LogFormat.h"
+#include "Query.h"
+
+bool ParsePredicate (const char *s, Predicate &p)
+{
+	static const char *opname[] = {"<=", ">=", "!=", "==", "<", ">", "="};
+	static const int opcode[] = {Q_LE, Q_GE, Q_NE, Q_EQ, Q_LT, Q_GT, Q_EQ};
+	const char *o = s + strcspn (s, "<>=!");
+	std::string name (s, o-s);
+	int k;
+
+	for (k = 0; k < 7; k++)
+		if (!strncmp (o, opname[k], strlen (opname[k]))) break;
+	if (k == 7 || (p.col = FindColumn (name.c_str())) < 0) return false;
+	p.op = opcode[k];
+	o += strlen (opname[k]);
+	char *end;
+	p.v = strtof (o, &end);
+	return end != o && !*end;
+}
+
+bool ZoneMayMatch (const Predicate &p, float mn, float mx)
+{
+	switch (p.op) {
+	case Q_LT: return mn < p.v;
+	case Q_LE: return mn <= p.v;
+	case Q_GT: return mx > p.v;
+	case Q_GE: return mx >= p.v;
+	case Q_EQ: return mn <= p.v && p.v <= mx;
+	default:   return !(mn == p.v && mx == p.v);
+	}
+}
+
+#define FILTER_LOOP(cmp) \
+	if (and_) for (i = 0; i < n; i++) mask[i] &= (unsigned char)(col[i] cmp v); \
+	else      for (i = 0; i < n; i++) mask[i]  = (unsigned char)(col[i] cmp v);
+
+// NaN fails every predicate, != included, as in the zone maps
+#define FILTER_NE \
+	if (and_) for (i = 0; i < n; i++) mask[i] &= (unsigned char)(col[i] == col[i] && col[i] != v); \
+	else      for (i = 0; i < n; i++) mask[i]  = (unsigned char)(col[i] == col[i] && col[i] != v);
+
+void FilterColumn (const Predicate &p, const float *col, int n, unsigned char *mask, bool and_)
+{
+	const float v = p.v;
+	int i;
+	switch (p.op) {
+	case Q_LT: FILTER_LOOP(<)  break;
+	case Q_LE: FILTER_LOOP(<=) break;
+	case Q_GT: FILTER_LOOP(>)  break;
+	case Q_GE: FILTER_LOOP(>=) break;
+	case Q_EQ: FILTER_LOOP(==) break;
+	default:   FILTER_NE break;
+	}
+}
+
+int CountMask (const unsigned char *mask, int n)
+{
+	int i, m = 0;
+	for (i = 0; i < n; i++) m += mask[i];
+	return m;
+}
+
+ChunkQuery::ChunkQuery (ChunkLogReader &_rd)
+	: rd (_rd), mask (_rd.ChunkRows()), col (_rd.Columns()), colchunk (_rd.Columns(), -1)
+{
+	prune = true;
+	skipped = scanned = 0;
+}
+
+const float *ChunkQuery::Column (int k, int c)
+{
+	if (colchunk[c] != k) {
+		col[c].resize (rd.ChunkRows());
+		if (!rd.ReadColumn (k, c, col[c].data())) return 0;
+		colchunk[c] = k;
+	}
+	return col[c].data();
+}
+
+int ChunkQuery::Run (int k)
+{
+	int n = rd.Rows (k), m = n;
+	size_t j;
+
+	if (prune) {
+		const float *mn = rd.Min (k), *mx = rd.Max (k);
+		for (j = 0; j < pred.size(); j++)
+			if (!ZoneMayMatch (pred[j], mn[pred[j].col], mx[pred[j].col])) {
+				skipped++;
+				return 0;
+			}
+	}
+	scanned++;
+	if (pred.empty()) {
+		memset (mask.data(), 1, n);
+		return n;
+	}
+	for (j = 0; j < pred.size() && m; j++) {
+		const float *c = Column (k, pred[j].col);
+		if (!c) return -1;
+		FilterColumn (pred[j], c, n, mask.data(), j > 0);
+		m = CountMask (mask.data(), n);
+	}
+	return m;
+}
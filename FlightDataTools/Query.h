@@ -0,0 +1,64 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// Query.h
+// Column predicates over chunked logs: zone-map pruning and
+// vectorisable per-chunk filters.
+// ==============================================================
+
+#ifndef __QUERY_H
+#define __QUERY_H
+
+#include <vector>
+#include "ChunkLog.h"
+
+enum { Q_LT, Q_LE, Q_GT, Q_GE, Q_EQ, Q_NE };
+
+struct Predicate {
+	int col;      // log column (LogFormat.h)
+	int op;       // Q_*
+	float v;
+};
+
+// "mach>5", "atm_dynp>=20000", "alt!=0"; column names as FindColumn
+bool ParsePredicate (const char *s, Predicate &p);
+
+// false if no value in [mn,mx] can satisfy p
+bool ZoneMayMatch (const Predicate &p, float mn, float mx);
+
+// mask[i] = p(col[i]), or mask[i] &= p(col[i]) if 'and'. Branch-free
+// loops over contiguous floats, which the compiler turns into SIMD
+// compares.
+void FilterColumn (const Predicate &p, const float *col, int n, unsigned char *mask, bool and_);
+
+int CountMask (const unsigned char *mask, int n);
+
+// Conjunction of predicates evaluated chunk by chunk. A chunk is skipped
+// when its zone map rules out any predicate; otherwise the predicate
+// columns are read one at a time and filtered, stopping as soon as no
+// row is left. Other columns are only read for chunks with matches.
+class ChunkQuery {
+public:
+	ChunkQuery (ChunkLogReader &_rd);
+	void Add (const Predicate &p) { pred.push_back (p); }
+	void SetPruning (bool on) { prune = on; }
+	// evaluate chunk k; returns the number of matching rows (mask) or -1
+	// on a read error
+	int  Run (int k);
+	const unsigned char *Mask () const { return mask.data(); }
+	const float *Column (int k, int c);    // column c of chunk k (cached)
+	long long Skipped () const { return skipped; }
+	long long Scanned () const { return scanned; }
+
+private:
+	ChunkLogReader &rd;
+	std::vector<Predicate> pred;
+	std::vector<unsigned char> mask;
+	std::vector<std::vector<float> > col;
+	std::vector<int> colchunk;             // chunk held in col[c], -1 = none
+	bool prune;
+	long long skipped, scanned;
+};
+
+#endif // !__QUERY_H
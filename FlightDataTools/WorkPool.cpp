@@ -0,0 +1,68 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// WorkPool.cpp
+// Work-stealing thread pool for batches of independent tasks.
+// ==============================================================
+
+#include <thread>
+#include "WorkPool.h"
+
+WorkPool::WorkPool (int _nthread)
+	: nthread (_nthread < 1 ? 1 : _nthread), queue (nthread)
+{
+	steals = 0;
+}
+
+// next task for worker w: its own front, else the back of the fullest
+// other queue. Tasks are never added while running, so an empty scan
+// means the batch is done.
+bool WorkPool::Take (int w, int &task)
+{
+	{
+		std::lock_guard<std::mutex> g(queue[w].lock);
+		if (!queue[w].task.empty()) {
+			task = queue[w].task.front();
+			queue[w].task.pop_front();
+			return true;
+		}
+	}
+	for (;;) {
+		int victim = -1;
+		size_t most = 0;
+		for (int i = 0; i < nthread; i++) {
+			if (i == w) continue;
+			std::lock_guard<std::mutex> g(queue[i].lock);
+			if (queue[i].task.size() > most) most = queue[i].task.size(), victim = i;
+		}
+		if (victim < 0) return false;
+		std::lock_guard<std::mutex> g(queue[victim].lock);
+		if (queue[victim].task.empty()) continue;   // lost the race, rescan
+		task = queue[victim].task.back();
+		queue[victim].task.pop_back();
+		std::lock_guard<std::mutex> s(statlock);
+		steals++;
+		return true;
+	}
+}
+
+void WorkPool::Worker (int w, const Task *fn)
+{
+	int task;
+	while (Take (w, task)) (*fn)(task, w);
+}
+
+void WorkPool::Run (int ntask, const Task &fn)
+{
+	int i;
+	for (i = 0; i < ntask; i++) queue[i % nthread].task.push_back (i);
+	if (nthread == 1) {
+		Worker (0, &fn);
+		return;
+	}
+	std::vector<std::thread> th;
+	for (i = 1; i < nthread; i++) th.emplace_back (&WorkPool::Worker, this, i, &fn);
+	Worker (0, &fn);
+	for (i = 0; i < (int)th.size(); i++) th[i].join();
+}
@@ -0,0 +1,46 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// WorkPool.h
+// Work-stealing thread pool for batches of independent tasks.
+// ==============================================================
+
+#ifndef __WORKPOOL_H
+#define __WORKPOOL_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Runs tasks 0..ntask-1 on a fixed set of worker threads. The tasks are
+// dealt round-robin onto per-worker deques in the order given; a worker
+// takes its own tasks from the front and, when it runs dry, steals from
+// the back of the fullest other deque. Callers that know the task costs
+// should order them largest first, so the big tasks start early and the
+// small ones are left for stealing at the end.
+class WorkPool {
+public:
+	typedef std::function<void(int task, int worker)> Task;
+
+	WorkPool (int nthread);
+	int  Threads () const { return nthread; }
+	void Run (int ntask, const Task &fn);
+	long long Steals () const { return steals; }
+
+private:
+	struct Queue {
+		std::mutex lock;
+		std::deque<int> task;
+	};
+	bool Take (int w, int &task);
+	void Worker (int w, const Task *fn);
+
+	int nthread;
+	std::vector<Queue> queue;
+	long long steals;       // tasks run by another worker than dealt to
+	std::mutex statlock;
+};
+
+#endif // !__WORKPOOL_H
@@ -0,0 +1,228 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdcat.cpp
+// Lists the sessions of a recorder catalog that match a set of filters.
+//
+// The catalog holds one fixed-size record per session, so it is read in
+// one block and each filter is a compiled comparison against a record
+// field; no flight log is opened.
+// ==============================================================
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "..//FlightDataCommon//SessionCatalog.h"
+
+enum { OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE, OP_SUB };
+enum { F_NUM, F_FLOAT, F_LL, F_STR };
+
+struct Filter {
+	int type;            // F_*
+	size_t ofs;          // field offset in CatalogEntry
+	int op;              // OP_*
+	double v;            // numeric operand
+	std::string s;       // string operand (lower case for OP_SUB)
+	bool duration;       // t_end-t_start
+};
+
+static const struct {
+	const char *name;
+	int type;
+	size_t ofs;
+} field[] = {
+	{"vessel",    F_STR, offsetof(CatalogEntry, vessel)},
+	{"base",      F_STR, offsetof(CatalogEntry, tgt_base)},
+	{"path",      F_STR, offsetof(CatalogEntry, path)},
+	{"t_start",   F_NUM, offsetof(CatalogEntry, t_start)},
+	{"t_end",     F_NUM, offsetof(CatalogEntry, t_end)},
+	{"mjd_start", F_NUM, offsetof(CatalogEntry, mjd_start)},
+	{"mjd_end",   F_NUM, offsetof(CatalogEntry, mjd_end)},
+	{"samples",   F_LL,  offsetof(CatalogEntry, samples)}
+};
+const int NFIELD = sizeof(field)/sizeof(field[0]);
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdcat [options] [FILTER...]\n"
+		"  -c PATH     catalog file, or log directory holding " CATALOG_NAME "\n"
+		"              (default: FlightData/" CATALOG_NAME ")\n"
+		"  -v          report load and filter times on stderr\n"
+		"FILTER is FIELD OP VALUE, all filters must match. FIELD is one of\n"
+		"  vessel base path t_start t_end mjd_start mjd_end samples duration\n"
+		"  CH.min CH.max CH.last CH.mean CH.sd CH.p50 CH.p95 CH.p99\n"
+		"  with CH in alt vrad vtan g dynp mach fuel dist (mean to p99 are 0\n"
+		"  in sessions recorded before the catalog held them)\n"
+		"OP is one of < <= > >= = != and ~ (case-insensitive substring), e.g.\n"
+		"  fdcat \"base~brighton\" \"fuel.last<200\" \"alt.last<1\"\n");
+}
+
+static std::string Lower (const char *s)
+{
+	std::string r;
+	for (; *s; s++) r += (char)tolower ((unsigned char)*s);
+	return r;
+}
+
+static bool Parse (const char *arg, Filter &f)
+{
+	static const char *opname[] = {"<=", ">=", "!=", "<", ">", "=", "~"};
+	static const int opcode[] = {OP_LE, OP_GE, OP_NE, OP_LT, OP_GT, OP_EQ, OP_SUB};
+	const char *p = arg + strcspn (arg, "<>=!~");
+	std::string name (arg, p-arg), val;
+	int k;
+
+	for (k = 0; k < 7; k++)
+		if (!strncmp (p, opname[k], strlen (opname[k]))) break;
+	if (k == 7 || name.empty()) return false;
+	f.op = opcode[k];
+	val = p + strlen (opname[k]);
+
+	f.duration = false;
+	for (k = 0; k < NFIELD; k++)
+		if (name == field[k].name) { f.type = field[k].type, f.ofs = field[k].ofs; break; }
+	if (k == NFIELD) {
+		if (name == "duration") f.type = F_NUM, f.ofs = 0, f.duration = true;
+		else {
+			size_t dot = name.find ('.');
+			if (dot == std::string::npos) return false;
+			std::string ch = name.substr (0, dot), st = name.substr (dot+1);
+			for (k = 0; k < NCATCH; k++) if (ch == catchname[k]) break;
+			if (k == NCATCH) return false;
+			f.type = F_FLOAT;
+			if (st == "min")       f.ofs = offsetof(CatalogEntry, vmin) + k*sizeof(float);
+			else if (st == "max")  f.ofs = offsetof(CatalogEntry, vmax) + k*sizeof(float);
+			else if (st == "last") f.ofs = offsetof(CatalogEntry, vlast) + k*sizeof(float);
+			else if (st == "mean") f.ofs = offsetof(CatalogEntry, vmean) + k*sizeof(float);
+			else if (st == "sd")   f.ofs = offsetof(CatalogEntry, vsd) + k*sizeof(float);
+			else if (st == "p50")  f.ofs = offsetof(CatalogEntry, vp50) + k*sizeof(float);
+			else if (st == "p95")  f.ofs = offsetof(CatalogEntry, vp95) + k*sizeof(float);
+			else if (st == "p99")  f.ofs = offsetof(CatalogEntry, vp99) + k*sizeof(float);
+			else return false;
+		}
+	}
+
+	if (f.type == F_STR) {
+		if (f.op != OP_EQ && f.op != OP_NE && f.op != OP_SUB) return false;
+		f.s = (f.op == OP_SUB ? Lower (val.c_str()) : val);
+		return true;
+	}
+	if (f.op == OP_SUB) return false;
+	char *end;
+	f.v = strtod (val.c_str(), &end);
+	return end != val.c_str() && !*end;
+}
+
+// case-insensitive substring test; 'lsub' is lower case
+static bool Contains (const char *s, const std::string &lsub)
+{
+	size_t n = lsub.size();
+	if (!n) return true;
+	for (; *s; s++) {
+		size_t k = 0;
+		while (k < n && s[k] && tolower ((unsigned char)s[k]) == lsub[k]) k++;
+		if (k == n) return true;
+	}
+	return false;
+}
+
+static bool Compare (double a, int op, double b)
+{
+	switch (op) {
+	case OP_LT: return a < b;
+	case OP_LE: return a <= b;
+	case OP_GT: return a > b;
+	case OP_GE: return a >= b;
+	case OP_EQ: return a == b;
+	default:    return a != b;
+	}
+}
+
+static bool Match (const CatalogEntry &e, const Filter &f)
+{
+	const char *base = (const char*)&e;
+	switch (f.type) {
+	case F_STR: {
+		const char *s = base + f.ofs;
+		if (f.op == OP_SUB) return Contains (s, f.s);
+		return (f.s == s) == (f.op == OP_EQ);
+	}
+	case F_FLOAT: return Compare (*(const float*)(base + f.ofs), f.op, f.v);
+	case F_LL:    return Compare ((double)*(const long long*)(base + f.ofs), f.op, f.v);
+	default:
+		return Compare (f.duration ? e.t_end-e.t_start : *(const double*)(base + f.ofs), f.op, f.v);
+	}
+}
+
+int main (int argc, char *argv[])
+{
+	std::vector<Filter> filter;
+	std::string catpath = std::string ("FlightData/") + CATALOG_NAME;
+	bool verbose = false;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-c") && i+1 < argc) {
+			catpath = argv[++i];
+			std::error_code ec;
+			if (std::filesystem::is_directory (catpath, ec))
+				catpath = (std::filesystem::path (catpath) / CATALOG_NAME).string();
+		}
+		else if (!strcmp (a, "-v")) verbose = true;
+		else if (a[0] == '-' && !strchr (a, '<') && !strchr (a, '>') && !strchr (a, '=')) { Usage(); return 1; }
+		else {
+			Filter f;
+			if (!Parse (a, f)) {
+				fprintf (stderr, "fdcat: bad filter %s\n", a);
+				return 1;
+			}
+			filter.push_back (f);
+		}
+	}
+
+	// numeric tests first, they are the cheapest
+	std::stable_sort (filter.begin(), filter.end(), [](const Filter &a, const Filter &b) {
+		return (a.type == F_STR) < (b.type == F_STR);
+	});
+
+	std::vector<CatalogEntry> cat;
+	auto t0 = std::chrono::steady_clock::now();
+	if (!LoadCatalog (catpath.c_str(), cat)) {
+		fprintf (stderr, "fdcat: cannot read catalog %s\n", catpath.c_str());
+		return 1;
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	std::vector<int> hit;
+	for (i = 0; i < (int)cat.size(); i++) {
+		size_t k;
+		for (k = 0; k < filter.size(); k++)
+			if (!Match (cat[i], filter[k])) break;
+		if (k == filter.size()) hit.push_back (i);
+	}
+	auto t2 = std::chrono::steady_clock::now();
+
+	printf ("%-16s %-16s %12s %12s %11s %9s %8s %8s %9s  %s\n",
+		"vessel", "base", "t_start", "t_end", "mjd_start", "samples", "alt.max", "fuel.end", "dist.end", "path");
+	for (i = 0; i < (int)hit.size(); i++) {
+		const CatalogEntry &e = cat[hit[i]];
+		printf ("%-16s %-16s %12.2f %12.2f %11.5f %9lld %8.2f %8.1f %9.2f  %s\n",
+			e.vessel, e.tgt_base[0] ? e.tgt_base : "-", e.t_start, e.t_end, e.mjd_start, e.samples,
+			e.vmax[CAT_ALT], e.vlast[CAT_FUEL], e.vlast[CAT_DIST], e.path);
+	}
+	if (verbose)
+		fprintf (stderr, "%d of %d sessions; load %.1f us, filter %.1f us\n", (int)hit.size(), (int)cat.size(),
+			std::chrono::duration<double, std::micro> (t1-t0).count(),
+			std::chrono::duration<double, std::micro> (t2-t1).count());
+	return 0;
+}
@@ -0,0 +1,180 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fddiff.cpp
+// Compares a flight against a reference flight, channel by channel.
+//
+// The two logs are aligned on a rising key: sim time, or a channel
+// such as altitude to compare the ascent of two flights that did not
+// launch at the same time. Every test sample is matched against the
+// reference interpolated at the same key value; the residuals give the
+// bias, rms and worst error of each channel and the first point where
+// the flights part ways. Logs are read through a memory mapping, as
+// text or chunked (.fdx, see fdindex).
+// ==============================================================
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "DiffKernels.h"
+#include "FlightColumns.h"
+#include "LogFormat.h"
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fddiff [options] test.log ref.log\n"
+		"  compares test.log against ref.log (.dat/.csv or .fdx)\n"
+		"  -k COL      alignment key (default sim_time); with another column,\n"
+		"              e.g. alt, only the part of each flight where the key\n"
+		"              rises to its maximum is compared\n"
+		"  -c COLS     channels to compare, comma separated, or \"all\"\n"
+		"  -t COL=TOL  divergence tolerance of a channel (default: 1%% of the\n"
+		"              channel's range in the reference); may be repeated\n"
+		"  -n N        samples the tolerance must be exceeded in a row (default 10)\n"
+		"  -d C        input delimiter (default: detected)\n"
+		"  -v          report load and compare times on stderr\n");
+}
+
+static const int defchannel[] = {
+	C_ALT, C_PITCH, C_V_RAD, C_V_TAN, C_A_G, C_DIST, C_AOA, C_MACH,
+	C_ATM_DYNP, C_FUEL_MASS, C_MAIN_T
+};
+
+// angles that wrap, compared the short way round
+static float Period (int c)
+{
+	return (c == C_ROLL || c == C_YAW || c == C_SURF_LON || c == C_SURF_HDG) ? 360.0f : 0.0f;
+}
+
+static double Seconds (std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+}
+
+int main (int argc, char *argv[])
+{
+	std::vector<int> chan;
+	float tol[NCOL];
+	const char *path[2] = {0, 0};
+	int key = C_SIM_TIME, persist = 10, i;
+	char delim = 0;
+	bool verbose = false;
+
+	for (i = 0; i < NCOL; i++) tol[i] = 0;
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-k") && i+1 < argc) {
+			if ((key = FindColumn (argv[++i])) < 0) {
+				fprintf (stderr, "fddiff: unknown column %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (!strcmp (a, "-c") && i+1 < argc) {
+			char *list = argv[++i], *tok;
+			if (!strcmp (list, "all")) {
+				for (int c = C_SIM_TIME; c < NCOL; c++) if (c != C_SMP_Q) chan.push_back (c);
+				continue;
+			}
+			for (tok = strtok (list, ","); tok; tok = strtok (0, ",")) {
+				int c = FindColumn (tok);
+				if (c < 0) {
+					fprintf (stderr, "fddiff: unknown column %s\n", tok);
+					return 1;
+				}
+				chan.push_back (c);
+			}
+		}
+		else if (!strcmp (a, "-t") && i+1 < argc) {
+			char *s = argv[++i], *eq = strchr (s, '='), *end;
+			int c = -1;
+			if (eq) *eq = '\0', c = FindColumn (s);
+			if (c < 0 || (tol[c] = strtof (eq+1, &end)) <= 0 || *end) {
+				fprintf (stderr, "fddiff: bad tolerance %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (!strcmp (a, "-n") && i+1 < argc) persist = atoi (argv[++i]);
+		else if (!strcmp (a, "-d") && i+1 < argc) delim = argv[++i][0];
+		else if (!strcmp (a, "-v")) verbose = true;
+		else if (a[0] == '-') { Usage(); return 1; }
+		else if (!path[0]) path[0] = a;
+		else if (!path[1]) path[1] = a;
+		else { Usage(); return 1; }
+	}
+	if (!path[1]) { Usage(); return 1; }
+	if (chan.empty()) chan.assign (defchannel, defchannel + sizeof(defchannel)/sizeof(int));
+
+	// the key itself always matches; sim time is loaded to place events
+	std::vector<int> load (1, key), cmp;
+	if (key != C_SIM_TIME) load.push_back (C_SIM_TIME);
+	for (i = 0; i < (int)chan.size(); i++) {
+		if (chan[i] == key) continue;
+		cmp.push_back (chan[i]);
+		if (chan[i] != C_SIM_TIME) load.push_back (chan[i]);
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	FlightColumns fc[2];
+	for (i = 0; i < 2; i++) {
+		if (!fc[i].Load (path[i], load, delim)) {
+			fprintf (stderr, "fddiff: cannot read %s\n", path[i]);
+			return 1;
+		}
+		if (verbose) fprintf (stderr, "%s: %lld rows, ", path[i], fc[i].Rows());
+		fc[i].KeepRising (key);
+		if (verbose) fprintf (stderr, "%lld with rising %s\n", fc[i].Rows(), logcol[key].name);
+	}
+	double tload = Seconds (t0);
+
+	t0 = std::chrono::steady_clock::now();
+	long long na = fc[0].Rows(), nb = fc[1].Rows(), i0, i1;
+	std::vector<int> j (na);
+	std::vector<float> f (na), err (na);
+	if (!AlignKeys (fc[0].Col (key), na, fc[1].Col (key), nb, j.data(), f.data(), i0, i1)) {
+		fprintf (stderr, "fddiff: the logs do not overlap in %s\n", logcol[key].name);
+		return 1;
+	}
+
+	const float *ka = fc[0].Col (key), *ta = fc[0].Col (C_SIM_TIME);
+	bool bytime = (key == C_SIM_TIME);
+	printf ("%lld of %lld test samples aligned on %s %g .. %g %s\n\n", i1-i0, na,
+		logcol[key].name, ka[i0], ka[i1-1], logcol[key].unit);
+	int atw = bytime ? 11 : 22;
+	printf ("%-13s %11s %11s %11s %*s %11s  %s\n", "channel", "mean", "rms", "max|err|",
+		atw, bytime ? "at" : "at (t)", "tol", "diverges at");
+
+	int ndiv = 0;
+	for (size_t c = 0; c < cmp.size(); c++) {
+		int ch = cmp[c];
+		ErrStats s;
+		float mn, mx;
+		Residual (fc[0].Col (ch), fc[1].Col (ch), j.data(), f.data(), i0, i1, Period (ch), err.data());
+		ErrorStatistics (err.data(), i0, i1, s);
+		if (!s.n) {
+			printf ("%-13s %11s\n", logcol[ch].name, "no data");
+			continue;
+		}
+		float t = tol[ch];
+		if (t <= 0) {
+			long long b0 = j[i0], b1 = j[i1-1]+2;
+			t = ValueRange (fc[1].Col (ch), b0, b1, mn, mx) && mx > mn ? 0.01f*(mx-mn) : 1e-6f;
+		}
+		long long d = FirstDivergence (err.data(), i0, i1, t, persist);
+		char at[32], dv[48];
+		if (bytime) snprintf (at, sizeof(at), "%.6g", ka[s.imax]);
+		else snprintf (at, sizeof(at), "%.6g (%.5g)", ka[s.imax], ta[s.imax]);
+		if (d < 0) snprintf (dv, sizeof(dv), "-");
+		else if (bytime) snprintf (dv, sizeof(dv), "%s %.6g", logcol[key].name, ka[d]);
+		else snprintf (dv, sizeof(dv), "%s %.6g (t %.6g)", logcol[key].name, ka[d], ta[d]);
+		if (d >= 0) ndiv++;
+		printf ("%-13s %11.4g %11.4g %11.4g %*s %11.4g  %s\n", logcol[ch].name,
+			s.mean, s.rms, s.maxabs, atw, at, t, dv);
+	}
+	if (verbose) fprintf (stderr, "load %.3f s, compare %.3f s\n", tload, Seconds (t0));
+	return ndiv ? 2 : 0;
+}
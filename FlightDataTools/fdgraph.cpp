@@ -0,0 +1,242 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdgraph.cpp
+// Headless rendering of the CFD data graphs.
+//
+// Draws the graphs of the FlightData dialog (FlightDataRecCFD/Graph.cpp)
+// into a RasterSurface, so their output can be checked and timed without
+// a window. A few fixed scenes cover one and three plots, a ring that has
+// wrapped and a graph narrower than its data (the min/max reduction).
+// --check renders every scene with the layer cache on and off and
+// compares it pixel by pixel to the golden images in a directory;
+// --bench times a canvas of graphs fed one point per frame, as the
+// dialog repaints them.
+// ==============================================================
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "..//FlightDataCommon//ImageIO.h"
+#include "..//FlightDataCommon//RasterSurface.h"
+#include "..//FlightDataRecCFD//Graph.h"
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdgraph --check DIR      compare the scenes to DIR/<scene>.ppm\n"
+		"       fdgraph --update DIR     write the scenes as DIR/<scene>.ppm\n"
+		"       fdgraph --render SCENE FILE   render one scene to FILE (.ppm or .png)\n"
+		"       fdgraph --bench [options]\n"
+		"  scenes: single, triple, narrow\n"
+		"  --bench times repaints of a canvas of graphs, each fed a point per frame:\n"
+		"    -g N      graphs (default 22)\n"
+		"    -w W      canvas width (default 600)\n"
+		"    -h H      height per graph (default 100)\n"
+		"    -f N      frames (default 500)\n");
+}
+
+static double Seconds (std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+}
+
+struct Scene {
+	const char *name;
+	int w, h;
+	int nplot;
+	int npoint;   // points appended; more than NDATA wraps the ring
+};
+
+static const Scene scene[] = {
+	{"single", 240, 120, 1, 150},
+	{"triple", 240, 160, 3, 350},
+	{"narrow", 120, 100, 2, 200},
+};
+static const int NSCENE = sizeof(scene)/sizeof(scene[0]);
+
+// point k of plot p: smooth curves with an edge, the same on every platform
+// up to the float rounding of sin
+static float Sample (int p, long k)
+{
+	double t = k*0.05;
+	switch (p) {
+	case 0:  return (float)(100.0*t + 20.0*sin (3.0*t));
+	case 1:  return (float)(400.0*sin (t) + (k % 40 < 20 ? 50.0 : -50.0));
+	default: return (float)(250.0*cos (0.7*t));
+	}
+}
+
+static Graph *MakeGraph (const Scene &sc)
+{
+	static const char *legend[3] = {"alt", "alt&vel", "alt&vel&acc"};
+	Graph *g = new Graph (sc.nplot);
+	g->SetTitle (sc.name);
+	g->SetYLabel ("value");
+	g->SetLegend (legend[sc.nplot-1]);
+	float v[MAXPLOT];
+	for (long k = 0; k < sc.npoint; k++) {
+		for (int p = 0; p < sc.nplot; p++) v[p] = Sample (p, k);
+		g->AppendDataPoints (v);
+	}
+	return g;
+}
+
+// render a scene; with the layer cache the second frame is the one taken,
+// so the blit of the cached layer is what gets compared
+static void Render (const Scene &sc, bool cache, RasterSurface &s)
+{
+	Graph::SetLayerCache (cache);
+	Graph *g = MakeGraph (sc);
+	s.Fill (0, 0, s.Width(), s.Height(), 0xffffff);
+	g->Refresh (s, sc.w, sc.h);
+	if (cache) g->Refresh (s, sc.w, sc.h);
+	delete g;
+}
+
+static const Scene *FindScene (const char *name)
+{
+	for (int i = 0; i < NSCENE; i++)
+		if (!strcmp (scene[i].name, name)) return scene+i;
+	return 0;
+}
+
+static bool EndsWith (const std::string &s, const char *sfx)
+{
+	size_t n = strlen (sfx);
+	return s.size() >= n && !s.compare (s.size()-n, n, sfx);
+}
+
+static int Check (const char *dir, bool update)
+{
+	int fail = 0;
+	for (int i = 0; i < NSCENE; i++) {
+		const Scene &sc = scene[i];
+		std::string path = std::string (dir) + "/" + sc.name + ".ppm";
+		if (update) {
+			RasterSurface s (sc.w, sc.h);
+			Render (sc, true, s);
+			if (!s.WritePPM (path.c_str())) {
+				fprintf (stderr, "fdgraph: cannot write %s\n", path.c_str());
+				return 1;
+			}
+			printf ("%-8s written\n", sc.name);
+			continue;
+		}
+		std::vector<unsigned char> gold;
+		int gw, gh;
+		if (!ReadPPM (path.c_str(), gold, gw, gh) || gw != sc.w || gh != sc.h) {
+			printf ("%-8s FAIL: no %dx%d golden image %s\n", sc.name, sc.w, sc.h, path.c_str());
+			fail++;
+			continue;
+		}
+		for (int cache = 1; cache >= 0; cache--) {
+			RasterSurface s (sc.w, sc.h);
+			Render (sc, cache != 0, s);
+			const unsigned char *px = s.Pixels();
+			long ndiff = 0;
+			int x0 = sc.w, y0 = sc.h, x1 = -1, y1 = -1;
+			for (int y = 0; y < sc.h; y++)
+				for (int x = 0; x < sc.w; x++) {
+					size_t o = 4*((size_t)y*sc.w + x);
+					if (memcmp (px+o, gold.data()+o, 3)) {
+						ndiff++;
+						if (x < x0) x0 = x;
+						if (x > x1) x1 = x;
+						if (y < y0) y0 = y;
+						if (y > y1) y1 = y;
+					}
+				}
+			const char *mode = (cache ? "cached" : "direct");
+			if (!ndiff) {
+				printf ("%-8s %s ok\n", sc.name, mode);
+				continue;
+			}
+			std::string out = std::string (sc.name) + "." + mode + ".ppm";
+			s.WritePPM (out.c_str());
+			printf ("%-8s %s FAIL: %ld pixels differ in (%d,%d)-(%d,%d), see %s\n",
+				sc.name, mode, ndiff, x0, y0, x1, y1, out.c_str());
+			fail++;
+		}
+	}
+	return fail ? 1 : 0;
+}
+
+// ngraph graphs of two plots stacked on one canvas; every frame appends a
+// point to each and repaints them all. With steady data the range of the
+// graphs stays put and the cached layer is reused; a climbing plot moves
+// the range, and with it the grid, on most frames.
+static int Bench (int ngraph, int w, int h, int nframe)
+{
+	Scene sc = {"bench", w, h, 2, 0};
+	RasterSurface s (w, h*ngraph);
+	float v[2];
+	for (int run = 0; run < 4; run++) {
+		int cache = !(run & 1), p0 = (run < 2 ? 2 : 0);   // steady, then climbing
+		Graph::SetLayerCache (cache != 0);
+		std::vector<Graph*> g (ngraph);
+		int i;
+		long k;
+		for (i = 0; i < ngraph; i++) g[i] = MakeGraph (sc);
+		for (k = 0; k < NDATA; k++)   // start from a full ring
+			for (i = 0; i < ngraph; i++) {
+				v[0] = Sample (p0, k+i), v[1] = Sample (1, k+i);
+				g[i]->AppendDataPoints (v);
+			}
+		auto t0 = std::chrono::steady_clock::now();
+		for (int f = 0; f < nframe; f++, k++) {
+			for (i = 0; i < ngraph; i++) {
+				v[0] = Sample (p0, k+i), v[1] = Sample (1, k+i);
+				g[i]->AppendDataPoints (v);
+			}
+			// without the layer the window erases the canvas first
+			s.SetOrigin (0, 0);
+			if (!cache) s.Fill (0, 0, w, h*ngraph, 0xffffff);
+			for (i = 0; i < ngraph; i++) {
+				s.SetOrigin (0, i*h);
+				g[i]->Refresh (s, w, h);
+			}
+		}
+		double t = Seconds (t0);
+		printf ("%d graphs %dx%d, %-8s data, %-6s layer: %8.3f ms/frame\n", ngraph, w, h,
+			p0 ? "steady" : "climbing", cache ? "cached" : "direct", t*1e3/nframe);
+		for (i = 0; i < ngraph; i++) delete g[i];
+	}
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	int ngraph = 22, w = 600, h = 100, nframe = 500;
+	int i;
+
+	if (argc < 2) { Usage(); return 1; }
+	if ((!strcmp (argv[1], "--check") || !strcmp (argv[1], "--update")) && argc == 3)
+		return Check (argv[2], !strcmp (argv[1], "--update"));
+	if (!strcmp (argv[1], "--render") && argc == 4) {
+		const Scene *sc = FindScene (argv[2]);
+		if (!sc) { Usage(); return 1; }
+		RasterSurface s (sc->w, sc->h);
+		Render (*sc, true, s);
+		std::string out = argv[3];
+		bool ok = (EndsWith (out, ".png") ? s.WritePNG (out.c_str()) : s.WritePPM (out.c_str()));
+		if (!ok) fprintf (stderr, "fdgraph: cannot write %s\n", out.c_str());
+		return ok ? 0 : 1;
+	}
+	if (strcmp (argv[1], "--bench")) { Usage(); return 1; }
+	for (i = 2; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-g") && i+1 < argc) ngraph = atoi (argv[++i]);
+		else if (!strcmp (a, "-w") && i+1 < argc) w = atoi (argv[++i]);
+		else if (!strcmp (a, "-h") && i+1 < argc) h = atoi (argv[++i]);
+		else if (!strcmp (a, "-f") && i+1 < argc) nframe = atoi (argv[++i]);
+		else { Usage(); return 1; }
+	}
+	if (ngraph < 1 || w < 20 || h < 20 || nframe < 1) { Usage(); return 1; }
+	return Bench (ngraph, w, h, nframe);
+}
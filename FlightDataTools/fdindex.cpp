@@ -0,0 +1,85 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdindex.cpp
+// Converts a text flight log into a chunked columnar log (.fdx) with
+// per-chunk min/max of every channel, for fdquery.
+// ==============================================================
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "LogFormat.h"
+#include "LogReader.h"
+#include "ChunkLog.h"
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdindex [options] flight-log.dat [out.fdx]\n"
+		"  -r N        rows per chunk (default 4096)\n"
+		"  -d C        field delimiter (default: any of space tab , ; |)\n");
+}
+
+int main (int argc, char *argv[])
+{
+	const char *in = 0, *out = 0;
+	int chunkrows = 4096, i, n;
+	char delim = 0;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-r") && i+1 < argc) chunkrows = atoi (argv[++i]);
+		else if (!strcmp (a, "-d") && i+1 < argc) delim = argv[++i][0];
+		else if (a[0] == '-') { Usage(); return 1; }
+		else if (!in) in = a;
+		else out = a;
+	}
+	if (!in || chunkrows < 1) { Usage(); return 1; }
+	std::string outpath;
+	if (out) outpath = out;
+	else {
+		outpath = in;
+		size_t dot = outpath.find_last_of ('.');
+		if (dot != std::string::npos && outpath.find_first_of ("/\\", dot) == std::string::npos)
+			outpath.erase (dot);
+		outpath += ".fdx";
+	}
+
+	LogReader rd;
+	ChunkLogWriter wr;
+	if (!rd.Open (in)) {
+		fprintf (stderr, "fdindex: cannot open %s\n", in);
+		return 1;
+	}
+	rd.SetDelim (delim);
+	if (!wr.Open (outpath.c_str(), NCOL, chunkrows)) {
+		fprintf (stderr, "fdindex: cannot write %s\n", outpath.c_str());
+		return 1;
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	double row[NCOL];
+	float frow[NCOL];
+	long long rows = 0;
+	bool ok = true;
+	while (ok && (n = rd.Next (row, NCOL)) >= 0) {
+		if (!n) continue;              // blank line
+		for (i = 0; i < NCOL; i++) frow[i] = (i < n ? (float)row[i] : NAN);
+		ok = wr.Add (frow);
+		rows++;
+	}
+	ok = wr.Close() && ok;
+	double sec = std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+	if (!ok) {
+		fprintf (stderr, "fdindex: write error on %s\n", outpath.c_str());
+		return 1;
+	}
+	printf ("%s: %lld rows, %lld chunks of %d, %.1f MB in %.2f s\n", outpath.c_str(), rows,
+		(rows+chunkrows-1)/chunkrows, chunkrows, LogReader::FileSize (outpath.c_str())/1048576.0, sec);
+	return 0;
+}
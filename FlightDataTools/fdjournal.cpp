@@ -0,0 +1,156 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdjournal.cpp
+// Checks flight logs against their journals and repairs torn tails.
+//
+// The recorder repairs the logs of a crashed session when it starts;
+// this does the same offline, and measures what each durability level
+// of the journal costs.
+// ==============================================================
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "..//FlightDataCommon//Journal.h"
+#include "LogFormat.h"
+#include "LogReader.h"
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdjournal [options] flight-log.dat...\n"
+		"  -r          repair: cut a torn tail, frame the salvaged samples and\n"
+		"              close the journal\n"
+		"  -d C        field delimiter (default: detected)\n"
+		"       fdjournal --bench [-n N] [-b ROWS] [-o DIR]\n"
+		"  writes N samples (default 200000) in blocks of ROWS (default 32) at\n"
+		"  each durability level into DIR (default: temp directory)\n"
+		"exit status 1 if a log was not closed cleanly and was not repaired\n");
+}
+
+static double Seconds (std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+}
+
+// one synthetic sample line in the recorder's format
+static int SampleText (long long k, char *buf)
+{
+	int n = sprintf (buf, "%d", (int)(k % 600));
+	double t = k*0.01;
+	for (int c = 1; c < NCOL; c++)
+		if (c == C_SMP_Q) n += sprintf (buf+n, " %d", (int)(k & 1));
+		else n += sprintf (buf+n, " %g", (float)(c*1000.0 + 100.0*sin (t*0.01*c)));
+	n += sprintf (buf+n, "\n");
+	return n;
+}
+
+static int Bench (long long n, int rows, const char *dir)
+{
+	static const struct {
+		const char *name;
+		int sync_blocks, sync_ms;   // -1: one open/append/close per sample
+	} level[] = {
+		{"per-sample append", -1, -1},
+		{"journal, no sync", 0, 0},
+		{"journal, sync 100 ms", 0, 100},
+		{"journal, sync 64 blocks", 64, 0},
+		{"journal, sync every block", 1, 0}
+	};
+	std::filesystem::path d = (dir ? std::filesystem::path (dir) : std::filesystem::temp_directory_path());
+	// format the lines up front, so only writing is timed
+	const int NLINE = 1024;
+	std::vector<std::string> text (NLINE);
+	char line[1024];
+	for (int i = 0; i < NLINE; i++) text[i].assign (line, SampleText (i, line));
+	printf ("%lld samples, %d per block, in %s\n", n, rows, d.string().c_str());
+	printf ("%-28s %12s %10s %10s %8s\n", "level", "samples/s", "MB/s", "us/sample", "syncs");
+	for (const auto &lv : level) {
+		std::filesystem::path p = d / "fdjournal-bench.dat";
+		std::error_code ec;
+		std::filesystem::remove (p, ec);
+		std::filesystem::remove (JournalPath (p.string().c_str()), ec);
+		long long k, bytes = 0, syncs = 0;
+		auto t0 = std::chrono::steady_clock::now();
+		if (lv.sync_blocks < 0) {
+			// what the recorder does without a journal
+			for (k = 0; k < n; k++) {
+				const std::string &t = text[k % NLINE];
+				std::ofstream out (p, std::ios::app);
+				out.write (t.data(), t.size());
+				bytes += t.size();
+			}
+		} else {
+			JournalWriter jw;
+			if (!jw.Open (p.string().c_str(), rows, 0, lv.sync_blocks, lv.sync_ms)) {
+				fprintf (stderr, "fdjournal: cannot write %s\n", p.string().c_str());
+				return 1;
+			}
+			for (k = 0; k < n; k++) {
+				const std::string &t = text[k % NLINE];
+				jw.Append (t.data(), (int)t.size());
+				jw.Poll();
+				bytes += t.size();
+			}
+			jw.Close();
+			syncs = jw.Syncs();
+		}
+		double s = Seconds (t0);
+		printf ("%-28s %12.0f %10.1f %10.2f %8lld\n", lv.name, n/s, bytes/s/1e6, s*1e6/n, syncs);
+		std::filesystem::remove (p, ec);
+		std::filesystem::remove (JournalPath (p.string().c_str()), ec);
+	}
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	bool repair = false, bench = false;
+	char delim = 0;
+	long long nbench = 200000;
+	int rows = 32;
+	const char *dir = 0;
+	std::vector<const char*> logs;
+	for (int i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-r")) repair = true;
+		else if (!strcmp (a, "-d") && i+1 < argc) delim = argv[++i][0];
+		else if (!strcmp (a, "--bench")) bench = true;
+		else if (!strcmp (a, "-n") && i+1 < argc) nbench = atoll (argv[++i]);
+		else if (!strcmp (a, "-b") && i+1 < argc) rows = atoi (argv[++i]);
+		else if (!strcmp (a, "-o") && i+1 < argc) dir = argv[++i];
+		else if (a[0] == '-') { Usage(); return 2; }
+		else logs.push_back (a);
+	}
+	if (bench) return Bench (nbench > 0 ? nbench : 1, rows > 0 ? rows : 1, dir);
+	if (logs.empty()) { Usage(); return 2; }
+
+	int status = 0;
+	for (const char *path : logs) {
+		JournalReport r;
+		char d = (delim ? delim : LogReader::DetectDelim (path));
+		bool ok = RecoverJournal (path, NCOL, d, repair, r);
+		if (!r.journal) {
+			printf ("%s: no journal\n", path);
+			continue;
+		}
+		if (!ok) {
+			fprintf (stderr, "fdjournal: cannot %s %s\n", repair ? "repair" : "check", path);
+			status = 1;
+			continue;
+		}
+		printf ("%s: %s  verified %lld  salvaged %lld  bad blocks %lld  torn frames %lld  %s %lld bytes\n",
+			path, r.clean ? "clean" : (repair ? "repaired" : "NOT CLOSED"), r.verified, r.salvaged,
+			r.bad_blocks, r.bad_frames, repair && !r.clean ? "cut" : "torn tail", r.dropped);
+		if (!r.clean && !repair) status = 1;
+	}
+	return status;
+}
@@ -0,0 +1,220 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdlive.cpp
+// Reads the live telemetry ring of a running recorder.
+//
+// Prints the samples the recorder publishes (SHMRING in FDRMFD.cfg)
+// as log lines while the flight goes on, straight from the shared
+// memory. --bench sets up a private ring instead and measures how fast
+// one writer can publish while a number of readers follow it.
+// ==============================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "..//FlightDataCommon//TelemetryRing.h"
+#include "LogFormat.h"
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdlive [options] NAME\n"
+		"  NAME is the SHMRING setting of the recorder: a shared-memory name,\n"
+		"  or the path of a mapped file (e.g. /dev/shm/flightdata.ring)\n"
+		"  -c COLS     channels to print, comma separated (default: all)\n"
+		"  -l N        start with the newest N samples (default: new ones only)\n"
+		"  -n N        stop after N samples\n"
+		"  -d C        output delimiter (default: space)\n"
+		"  -q          print a rate and loss summary every second instead\n"
+		"  --bench     throughput test on a private ring NAME:\n"
+		"    -r N      readers (default 2)\n"
+		"    -s N      samples to publish (default 10000000)\n"
+		"    -k N      ring slots (default 4096)\n"
+		"    -p HZ     publish rate (default: as fast as possible)\n");
+}
+
+static double Seconds (std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+}
+
+// the channels the recorder publishes: every log column after sim_time
+static std::vector<TelemetryChannel> LogChannels ()
+{
+	std::vector<TelemetryChannel> ch;
+	for (int c = C_SIM_TIME+1; c < NCOL; c++) {
+		TelemetryChannel t;
+		memset (&t, 0, sizeof(t));
+		strncpy (t.name, logcol[c].name, TELEMETRY_NAMELEN-1);
+		strncpy (t.unit, logcol[c].unit, TELEMETRY_UNITLEN-1);
+		ch.push_back (t);
+	}
+	return ch;
+}
+
+struct ReaderResult {
+	unsigned long long read, lost, disorder;
+	double sec;
+};
+
+static int Bench (const char *name, int nreader, long long nsample, int slots, double hz)
+{
+	std::vector<TelemetryChannel> ch = LogChannels();
+	int nch = (int)ch.size();
+	TelemetryWriter w;
+	if (!w.Create (name, ch.data(), nch, slots)) {
+		fprintf (stderr, "fdlive: cannot create %s\n", name);
+		return 1;
+	}
+
+	// every reader maps the ring on its own, as a separate process would
+	std::vector<ReaderResult> res (nreader);
+	std::vector<std::thread> th;
+	std::atomic<int> ready (0);
+	std::atomic<bool> done (false);
+	for (int r = 0; r < nreader; r++)
+		th.emplace_back ([&, r]() {
+			TelemetryReader rd;
+			ReaderResult &x = res[r];
+			memset (&x, 0, sizeof(x));
+			if (!rd.Open (name)) { ready++; return; }
+			std::vector<float> v (rd.Channels());
+			double t, tlast = -1.0;
+			ready++;
+			auto t0 = std::chrono::steady_clock::now();
+			for (;;) {
+				if (rd.Next (t, v.data())) {
+					x.read++;
+					if (t <= tlast || v[0] != (float)t) x.disorder++;
+					tlast = t;
+				} else if (done.load (std::memory_order_acquire) && rd.Cursor() >= rd.Head()) break;
+				else std::this_thread::yield();
+			}
+			x.sec = Seconds (t0);
+			x.lost = rd.Lost();
+		});
+	while (ready.load() < nreader) std::this_thread::yield();
+
+	// channel 0 (altitude) carries the sample time so the readers can
+	// check every sample they get is whole
+	std::vector<float> v (nch);
+	for (int c = 0; c < nch; c++) v[c] = (float)c;
+	auto t0 = std::chrono::steady_clock::now();
+	for (long long n = 0; n < nsample; n++) {
+		double t = (double)n;
+		if (hz > 0.0) {
+			t = n/hz;
+			while (Seconds (t0) < t) std::this_thread::yield();
+		}
+		v[0] = (float)t;
+		w.Publish (t, v.data());
+	}
+	double wsec = Seconds (t0);
+	done.store (true, std::memory_order_release);
+	for (size_t r = 0; r < th.size(); r++) th[r].join();
+
+	printf ("writer: %lld samples of %d channels in %.3f s, %.2f M samples/s, %.0f ns each\n",
+		nsample, nch, wsec, nsample/wsec*1e-6, wsec/nsample*1e9);
+	int bad = 0;
+	for (int r = 0; r < nreader; r++) {
+		const ReaderResult &x = res[r];
+		printf ("reader %d: %llu read, %llu lost (%.2f%%), %.2f M samples/s%s\n", r, x.read, x.lost,
+			nsample ? 100.0*x.lost/nsample : 0.0, x.sec > 0 ? x.read/x.sec*1e-6 : 0.0,
+			x.disorder ? ", TORN OR OUT OF ORDER SAMPLES" : "");
+		if (x.disorder || x.read + x.lost != (unsigned long long)nsample) bad++;
+	}
+	w.Close();
+	TelemetryWriter::Remove (name);
+	return bad ? 1 : 0;
+}
+
+int main (int argc, char *argv[])
+{
+	std::vector<std::string> cols;
+	const char *name = 0;
+	long long count = -1, nsample = 10000000;
+	int back = 0, nreader = 2, slots = 4096, i;
+	char delim = ' ';
+	bool quiet = false, bench = false;
+	double hz = 0.0;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-c") && i+1 < argc) {
+			char *tok;
+			for (tok = strtok (argv[++i], ","); tok; tok = strtok (0, ",")) {
+				int c = FindColumn (tok);
+				cols.push_back (c >= 0 ? logcol[c].name : tok);
+			}
+		}
+		else if (!strcmp (a, "-l") && i+1 < argc) back = atoi (argv[++i]);
+		else if (!strcmp (a, "-n") && i+1 < argc) count = atoll (argv[++i]);
+		else if (!strcmp (a, "-d") && i+1 < argc) delim = argv[++i][0];
+		else if (!strcmp (a, "-q")) quiet = true;
+		else if (!strcmp (a, "--bench")) bench = true;
+		else if (!strcmp (a, "-r") && i+1 < argc) nreader = atoi (argv[++i]);
+		else if (!strcmp (a, "-s") && i+1 < argc) nsample = atoll (argv[++i]);
+		else if (!strcmp (a, "-k") && i+1 < argc) slots = atoi (argv[++i]);
+		else if (!strcmp (a, "-p") && i+1 < argc) hz = atof (argv[++i]);
+		else if (a[0] == '-') { Usage(); return 1; }
+		else if (!name) name = a;
+		else { Usage(); return 1; }
+	}
+	if (!name || !delim) { Usage(); return 1; }
+	if (bench) return Bench (name, nreader, nsample, slots, hz);
+
+	TelemetryReader rd;
+	if (!rd.Open (name)) {
+		fprintf (stderr, "fdlive: no telemetry ring %s\n", name);
+		return 1;
+	}
+	std::vector<int> out;
+	if (cols.empty()) for (i = 0; i < rd.Channels(); i++) out.push_back (i);
+	for (i = 0; i < (int)cols.size(); i++) {
+		int c = rd.FindChannel (cols[i].c_str());
+		if (c < 0) {
+			fprintf (stderr, "fdlive: channel %s is not published\n", cols[i].c_str());
+			return 1;
+		}
+		out.push_back (c);
+	}
+	fprintf (stderr, "%s: %d channels, %u slots, epoch %u, writer %s\n", name, rd.Channels(),
+		rd.Slots(), rd.Epoch(), rd.WriterAlive() ? "attached" : "gone");
+	if (back) rd.SeekLatest (back);
+
+	std::vector<float> v (rd.Channels());
+	double t;
+	long long got = 0, last = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	while (count < 0 || got < count) {
+		if (!rd.Next (t, v.data())) {
+			if (!rd.Active()) {                  // set up anew with another layout
+				if (!rd.Open (name)) break;
+				v.resize (rd.Channels());
+				continue;
+			}
+			if (!rd.WriterAlive() && rd.Cursor() >= rd.Head()) break;
+			std::this_thread::sleep_for (std::chrono::milliseconds (2));
+		} else if (!quiet) {
+			printf ("%g", t);
+			for (size_t k = 0; k < out.size(); k++) printf ("%c%g", delim, v[out[k]]);
+			putchar ('\n');
+			got++;
+		} else got++;
+		if (quiet && Seconds (t0) >= 1.0) {
+			fprintf (stderr, "%lld samples/s, %llu lost, sim time %g\n", got-last, rd.Lost(), t);
+			last = got;
+			t0 = std::chrono::steady_clock::now();
+		}
+	}
+	fflush (stdout);
+	if (rd.Lost()) fprintf (stderr, "fdlive: %llu samples lost (reader too slow)\n", rd.Lost());
+	return 0;
+}
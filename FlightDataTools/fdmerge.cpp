@@ -0,0 +1,234 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdmerge.cpp
+// Merges flight logs by sim time into one ordered log.
+//
+// Joins the segments of a flight split by auto increment, and parallel
+// logs of the same flight (MFD and CFD recorders), in one streaming
+// k-way merge: only the current row of every input is held, in a heap
+// ordered by sim time. Each input keeps its own delimiter, detected
+// from its first line; the output uses one delimiter throughout.
+// ==============================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <queue>
+#include <string>
+#include <vector>
+#include "LogFormat.h"
+#include "LogReader.h"
+
+namespace fs = std::filesystem;
+
+struct Input {
+	std::string path;
+	LogReader *rd;
+	double row[NCOL];
+	int n;                     // fields in row, -1 at the end
+	double t;                  // sim time of row
+	long long rows, skipped, backwards;
+};
+
+static struct {
+	char outdelim;
+	char indelim;              // forced input delimiter, 0 = detect
+	bool dedup;
+	int bufsize;
+	const char *out;
+} opt;
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdmerge [options] LOG|DIR...\n"
+		"  merges the logs (and the flight-log-*.dat/.csv files of each DIR)\n"
+		"  by sim_time; every input must be in time order itself\n"
+		"  -o FILE     output file (default: stdout)\n"
+		"  -d C        output delimiter (default: space)\n"
+		"  -i C        input delimiter (default: detected per file)\n"
+		"  -u          drop rows identical to one already written for the same\n"
+		"              sim_time; the sample index and quality columns are ignored,\n"
+		"              so parallel MFD and CFD logs of a flight collapse\n"
+		"  -b KB       read buffer per input (default 64)\n");
+}
+
+static bool IsFlightLog (const fs::path &p)
+{
+	std::string n = p.filename().string(), ext = p.extension().string();
+	return !n.compare (0, 11, "flight-log-") && (ext == ".dat" || ext == ".csv");
+}
+
+// read the next row with a valid sim time
+static void Advance (Input &in)
+{
+	double t0 = in.t;
+	for (;;) {
+		in.n = in.rd->Next (in.row, NCOL);
+		if (in.n < 0) return;
+		if (in.n > C_SIM_TIME && !std::isnan (in.row[C_SIM_TIME])) break;
+		in.skipped++;
+	}
+	in.t = in.row[C_SIM_TIME];
+	if (in.rows && in.t < t0) in.backwards++;
+	in.rows++;
+}
+
+// write the current line of 'in' with its fields joined by the output
+// delimiter; the field text is kept as logged
+static void Emit (FILE *f, const Input &in)
+{
+	int len, i = 0, k = 0;
+	const char *s = in.rd->Line (len);
+	char d = in.rd->Delim();
+	auto isdelim = [d](char c) {
+		return d ? c == d : (c == ' ' || c == '\t' || c == ',' || c == ';' || c == '|');
+	};
+	while (i < len) {
+		while (i < len && isdelim (s[i])) i++;
+		if (i == len) break;
+		int j = i;
+		while (j < len && !isdelim (s[j])) j++;
+		if (k++) putc (opt.outdelim, f);
+		fwrite (s+i, 1, j-i, f);
+		i = j;
+	}
+	putc ('\n', f);
+}
+
+// rows written for the current sim time, for -u
+struct Written {
+	double t;
+	std::vector<double> row;   // NCOL per row
+	std::vector<int> n;
+
+	bool Seen (const Input &in)
+	{
+		int last = (in.n < C_HOVER_T+1 ? in.n : C_HOVER_T+1);
+		for (size_t r = 0; r < n.size(); r++) {
+			const double *w = &row[r*NCOL];
+			int m = (n[r] < last ? n[r] : last), c;
+			if (m != last) continue;
+			for (c = C_SIM_TIME; c < m; c++)
+				if (w[c] != in.row[c] && !(std::isnan (w[c]) && std::isnan (in.row[c]))) break;
+			if (c == m) return true;
+		}
+		return false;
+	}
+	void Add (const Input &in)
+	{
+		if (in.t != t) row.clear(), n.clear(), t = in.t;
+		row.insert (row.end(), in.row, in.row+NCOL);
+		n.push_back (in.n);
+	}
+};
+
+int main (int argc, char *argv[])
+{
+	std::vector<Input> in;
+	std::vector<std::string> path;
+	int i;
+
+	opt.outdelim = ' ';
+	opt.indelim = 0;
+	opt.dedup = false;
+	opt.bufsize = 64;
+	opt.out = 0;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-o") && i+1 < argc) opt.out = argv[++i];
+		else if (!strcmp (a, "-d") && i+1 < argc) opt.outdelim = argv[++i][0];
+		else if (!strcmp (a, "-i") && i+1 < argc) opt.indelim = argv[++i][0];
+		else if (!strcmp (a, "-u")) opt.dedup = true;
+		else if (!strcmp (a, "-b") && i+1 < argc) opt.bufsize = atoi (argv[++i]);
+		else if (a[0] == '-') { Usage(); return 1; }
+		else {
+			std::error_code ec;
+			if (!fs::is_directory (a, ec)) {
+				path.push_back (a);
+				continue;
+			}
+			std::vector<std::string> dir;
+			for (fs::directory_iterator it (a, ec), end; !ec && it != end; it.increment (ec))
+				if (it->is_regular_file (ec) && IsFlightLog (it->path())) dir.push_back (it->path().string());
+			if (ec) fprintf (stderr, "fdmerge: %s: %s\n", a, ec.message().c_str());
+			std::sort (dir.begin(), dir.end());
+			path.insert (path.end(), dir.begin(), dir.end());
+		}
+	}
+	if (path.empty() || !opt.outdelim) { Usage(); return 1; }
+	if (opt.out) for (i = 0; i < (int)path.size(); i++)
+		if (path[i] == opt.out) {
+			fprintf (stderr, "fdmerge: output %s is also an input\n", opt.out);
+			return 1;
+		}
+
+	in.resize (path.size());
+	for (i = 0; i < (int)in.size(); i++) {
+		Input &x = in[i];
+		x.path = path[i];
+		x.rd = new LogReader (opt.bufsize*1024);
+		x.rows = x.skipped = x.backwards = 0;
+		x.t = -HUGE_VAL;
+		if (!x.rd->Open (x.path.c_str())) {
+			fprintf (stderr, "fdmerge: cannot open %s\n", x.path.c_str());
+			return 1;
+		}
+		x.rd->SetDelim (opt.indelim ? opt.indelim : LogReader::DetectDelim (x.path.c_str()));
+	}
+
+	FILE *f = (opt.out ? fopen (opt.out, "wb") : stdout);
+	if (!f) {
+		fprintf (stderr, "fdmerge: cannot write %s\n", opt.out);
+		return 1;
+	}
+	static char obuf[1 << 20];
+	setvbuf (f, obuf, _IOFBF, sizeof(obuf));
+
+	// min-heap on (sim time, input): rows of equal time keep input order
+	auto later = [&in](int a, int b) { return in[a].t > in[b].t || (in[a].t == in[b].t && a > b); };
+	std::priority_queue<int, std::vector<int>, decltype(later)> heap (later);
+	for (i = 0; i < (int)in.size(); i++) {
+		Advance (in[i]);
+		if (in[i].n >= 0) heap.push (i);
+	}
+
+	Written w;
+	w.t = NAN;
+	long long written = 0, dropped = 0;
+	while (!heap.empty()) {
+		int j = heap.top();
+		heap.pop();
+		Input &x = in[j];
+		if (opt.dedup && x.t == w.t && w.Seen (x)) dropped++;
+		else {
+			Emit (f, x);
+			written++;
+			if (opt.dedup) w.Add (x);
+		}
+		Advance (x);
+		if (x.n >= 0) heap.push (j);
+	}
+
+	bool ok = !ferror (f);
+	if (opt.out) ok = (fclose (f) == 0) && ok;
+	else fflush (f);
+	if (!ok) fprintf (stderr, "fdmerge: write error\n");
+
+	fprintf (stderr, "%lld rows from %d logs, %lld written, %lld duplicates dropped\n",
+		written+dropped, (int)in.size(), written, dropped);
+	for (i = 0; i < (int)in.size(); i++) {
+		Input &x = in[i];
+		if (x.skipped || x.backwards)
+			fprintf (stderr, "  %s: %lld rows without sim_time skipped, %lld steps back in time\n",
+				x.path.c_str(), x.skipped, x.backwards);
+		delete x.rd;
+	}
+	return ok ? 0 : 1;
+}
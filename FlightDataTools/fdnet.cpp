@@ -0,0 +1,350 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdnet.cpp
+// Receives the network telemetry stream of a running recorder.
+//
+// Connects to the recorder's TCP port (or listens for its UDP frames,
+// NETSTREAM in FDRMFD.cfg) and prints the samples, or a rate and loss
+// summary. --bench streams to local clients from an in-process sender,
+// one of them deliberately slow, and reports how long the sampler's
+// Push() took and what every client received.
+// ==============================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "..//FlightDataCommon//TelemetryStream.h"
+#include "LogFormat.h"
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdnet [options] tcp:HOST:PORT | udp:PORT\n"
+		"  -c COLS     channels to print, comma separated (default: all)\n"
+		"  -n N        stop after N samples\n"
+		"  -q          print a rate and loss summary every second instead\n"
+		"  --bench     stream from an in-process sender on tcp:PORT:\n"
+		"    -r N      fast clients (default 2), plus one that reads slowly\n"
+		"    -s N      samples to push (default 2000000)\n"
+		"    -b N      samples per frame (default 10)\n"
+		"    -t MS     flush interval (default 100)\n"
+		"    -k N      frames queued per client (default 64)\n"
+		"    -p HZ     push rate (default: as fast as possible)\n");
+}
+
+static double Seconds (std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+}
+
+static int Connect (const char *spec)
+{
+	std::string s (spec);
+	int fd = -1;
+	if (!s.compare (0, 4, "tcp:")) {
+		size_t colon = s.rfind (':');
+		std::string host = s.substr (4, colon-4), port = s.substr (colon+1);
+		addrinfo hint, *ai = 0;
+		memset (&hint, 0, sizeof(hint));
+		hint.ai_family = AF_INET;
+		hint.ai_socktype = SOCK_STREAM;
+		if (colon <= 4 || getaddrinfo (host.c_str(), port.c_str(), &hint, &ai) || !ai) return -1;
+		fd = socket (AF_INET, SOCK_STREAM, 0);
+		if (fd >= 0 && connect (fd, ai->ai_addr, ai->ai_addrlen)) close (fd), fd = -1;
+		freeaddrinfo (ai);
+	} else if (!s.compare (0, 4, "udp:")) {
+		sockaddr_in a;
+		memset (&a, 0, sizeof(a));
+		a.sin_family = AF_INET;
+		a.sin_addr.s_addr = htonl (INADDR_ANY);
+		a.sin_port = htons ((unsigned short)atoi (spec+4));
+		fd = socket (AF_INET, SOCK_DGRAM, 0);
+		if (fd >= 0 && bind (fd, (sockaddr*)&a, sizeof(a))) close (fd), fd = -1;
+	}
+	return fd;
+}
+
+// Decodes the frames of one stream. Frames arrive whole over UDP and
+// in pieces over TCP; Feed() takes either.
+struct Decoder {
+	std::vector<char> buf;
+	std::vector<std::string> name;
+	unsigned long long samples, frames, lost, expect;
+	unsigned nchan;
+	bool text, schema;
+
+	Decoder (): samples (0), frames (0), lost (0), expect (0), nchan (0), text (false), schema (false) {}
+
+	// calls fn(simt, v) for every sample; false on a malformed stream
+	template<class F> bool Feed (const char *p, size_t n, F fn)
+	{
+		buf.insert (buf.end(), p, p+n);
+		size_t ofs = 0;
+		if (!schema && !text && buf.size() >= 2 && buf[0] == '#') text = true;
+		while (text) {
+			char *b = buf.data() + ofs, *e = (char*)memchr (b, '\n', buf.size()-ofs);
+			if (!e) break;
+			*e = '\0';
+			if (*b == '#') {
+				name.clear();
+				for (char *tok = strtok (b+1, " "); tok; tok = strtok (0, " ")) name.push_back (tok);
+				if (!name.empty()) name.erase (name.begin());
+				nchan = (unsigned)name.size();
+				schema = true;
+			} else {
+				std::vector<float> v (nchan);
+				char *q = b;
+				double t = strtod (q, &q);
+				for (unsigned c = 0; c < nchan; c++) v[c] = strtof (q, &q);
+				samples++;
+				fn (t, v.data());
+			}
+			ofs = e+1 - buf.data();
+		}
+		while (!text && buf.size()-ofs >= sizeof(StreamFrameHeader)) {
+			StreamFrameHeader fh;
+			memcpy (&fh, buf.data()+ofs, sizeof(fh));
+			if (memcmp (fh.magic, STREAM_MAGIC, 4) || fh.version != STREAM_VERSION) return false;
+			if (buf.size()-ofs < sizeof(fh) + fh.size) break;
+			const char *pl = buf.data() + ofs + sizeof(fh);
+			if (fh.type == SF_SCHEMA && fh.size == fh.nchan*sizeof(TelemetryChannel)) {
+				name.clear();
+				for (unsigned c = 0; c < fh.nchan; c++) {
+					TelemetryChannel tc;
+					memcpy (&tc, pl + c*sizeof(tc), sizeof(tc));
+					name.push_back (std::string (tc.name, strnlen (tc.name, TELEMETRY_NAMELEN)));
+				}
+				nchan = fh.nchan;
+				schema = true;
+			} else if (fh.type == SF_SAMPLES && schema && fh.nchan == nchan
+				&& fh.size == fh.nsample*(sizeof(double) + nchan*sizeof(float))) {
+				if (frames && fh.first > expect) lost += fh.first - expect;
+				expect = fh.first + fh.nsample;
+				frames++;
+				std::vector<float> v (nchan);
+				for (unsigned k = 0; k < fh.nsample; k++) {
+					double t;
+					const char *r = pl + k*(sizeof(double) + nchan*sizeof(float));
+					memcpy (&t, r, sizeof(double));
+					memcpy (v.data(), r + sizeof(double), nchan*sizeof(float));
+					samples++;
+					fn (t, v.data());
+				}
+			}
+			ofs += sizeof(fh) + fh.size;
+		}
+		buf.erase (buf.begin(), buf.begin()+ofs);
+		return true;
+	}
+};
+
+static std::vector<TelemetryChannel> LogChannels ()
+{
+	std::vector<TelemetryChannel> ch;
+	for (int c = C_SIM_TIME+1; c < NCOL; c++) {
+		TelemetryChannel t;
+		memset (&t, 0, sizeof(t));
+		strncpy (t.name, logcol[c].name, TELEMETRY_NAMELEN-1);
+		strncpy (t.unit, logcol[c].unit, TELEMETRY_UNITLEN-1);
+		ch.push_back (t);
+	}
+	return ch;
+}
+
+struct ClientResult {
+	unsigned long long samples, lost, frames, disorder;
+};
+
+static int Bench (int port, int nfast, long long nsample, int batch, double flush_ms, int queue, double hz)
+{
+	std::vector<TelemetryChannel> ch = LogChannels();
+	int nch = (int)ch.size();
+	TelemetryStream ts;
+	char spec[32];
+	snprintf (spec, sizeof(spec), "tcp:%d", port);
+	if (!ts.Start (spec, ch.data(), nch, false, batch, flush_ms, queue)) {
+		fprintf (stderr, "fdnet: cannot listen on %s\n", spec);
+		return 1;
+	}
+
+	// clients 0..nfast-1 read as fast as they can, the last one 16 kB
+	// every 50 ms (320 kB/s)
+	int ncl = nfast+1;
+	std::vector<ClientResult> res (ncl);
+	std::vector<std::thread> th;
+	std::atomic<int> ready (0);
+	std::atomic<bool> done (false);
+	snprintf (spec, sizeof(spec), "tcp:127.0.0.1:%d", port);
+	for (int k = 0; k < ncl; k++)
+		th.emplace_back ([&, k]() {
+			ClientResult &r = res[k];
+			memset (&r, 0, sizeof(r));
+			int fd = Connect (spec);
+			ready++;
+			if (fd < 0) return;
+			timeval tv = {0, 200000};
+			setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+			bool slow = (k == ncl-1);
+			Decoder d;
+			double tlast = -1.0;
+			char b[65536];
+			for (;;) {
+				ssize_t n = recv (fd, b, slow ? 16384 : sizeof(b), 0);
+				if (n <= 0) {
+					if (done.load()) break;
+					continue;
+				}
+				d.Feed (b, n, [&](double t, const float *v) {
+					if (t <= tlast || v[0] != (float)t) r.disorder++;
+					tlast = t;
+				});
+				if (slow) std::this_thread::sleep_for (std::chrono::milliseconds (50));
+			}
+			close (fd);
+			r.samples = d.samples;
+			r.lost = d.lost;
+			r.frames = d.frames;
+		});
+	while (ready.load() < ncl) std::this_thread::yield();
+	StreamStats st;
+	do {                               // wait for the sender to accept them all
+		std::this_thread::sleep_for (std::chrono::milliseconds (10));
+		ts.GetStats (st);
+	} while (st.clients < ncl);
+
+	std::vector<float> v (nch);
+	for (int c = 0; c < nch; c++) v[c] = (float)c;
+	double tmax = 0.0, tsum = 0.0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (long long n = 0; n < nsample; n++) {
+		if (hz > 0.0)
+			while (Seconds (t0) < n/hz) std::this_thread::yield();
+		v[0] = (float)n;
+		auto p0 = std::chrono::steady_clock::now();
+		ts.Push ((double)n, v.data());
+		double dt = Seconds (p0);
+		tsum += dt;
+		if (dt > tmax) tmax = dt;
+	}
+	double sec = Seconds (t0);
+	std::this_thread::sleep_for (std::chrono::milliseconds ((int)flush_ms + 50));
+	ts.Poll();
+	std::this_thread::sleep_for (std::chrono::milliseconds (500));
+	ts.GetStats (st);
+	done.store (true);
+	ts.Stop();
+	for (size_t k = 0; k < th.size(); k++) th[k].join();
+
+	printf ("sender: %lld samples in %.3f s, Push %.0f ns mean, %.1f us max\n",
+		nsample, sec, tsum/nsample*1e9, tmax*1e6);
+	printf ("        %llu frames, %llu samples dropped at hand-off, %llu frames dropped from client queues, %.1f MB sent\n",
+		st.frames, st.handoff_drops, st.client_drops, st.bytes/1048576.0);
+	int bad = 0;
+	for (int k = 0; k < ncl; k++) {
+		const ClientResult &r = res[k];
+		printf ("client %d%s: %llu samples in %llu frames, %llu lost in gaps%s\n", k,
+			k == ncl-1 ? " (slow)" : "", r.samples, r.frames, r.lost,
+			r.disorder ? ", OUT OF ORDER OR TORN SAMPLES" : "");
+		if (r.disorder) bad++;
+	}
+	return bad ? 1 : 0;
+}
+
+int main (int argc, char *argv[])
+{
+	std::vector<std::string> cols;
+	const char *spec = 0;
+	long long count = -1, nsample = 2000000;
+	int nfast = 2, batch = 10, queue = 64, i;
+	double flush_ms = 100.0, hz = 0.0;
+	bool quiet = false, bench = false;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-c") && i+1 < argc) {
+			char *tok;
+			for (tok = strtok (argv[++i], ","); tok; tok = strtok (0, ",")) {
+				int c = FindColumn (tok);
+				cols.push_back (c >= 0 ? logcol[c].name : tok);
+			}
+		}
+		else if (!strcmp (a, "-n") && i+1 < argc) count = atoll (argv[++i]);
+		else if (!strcmp (a, "-q")) quiet = true;
+		else if (!strcmp (a, "--bench")) bench = true;
+		else if (!strcmp (a, "-r") && i+1 < argc) nfast = atoi (argv[++i]);
+		else if (!strcmp (a, "-s") && i+1 < argc) nsample = atoll (argv[++i]);
+		else if (!strcmp (a, "-b") && i+1 < argc) batch = atoi (argv[++i]);
+		else if (!strcmp (a, "-t") && i+1 < argc) flush_ms = atof (argv[++i]);
+		else if (!strcmp (a, "-k") && i+1 < argc) queue = atoi (argv[++i]);
+		else if (!strcmp (a, "-p") && i+1 < argc) hz = atof (argv[++i]);
+		else if (a[0] == '-') { Usage(); return 1; }
+		else if (!spec) spec = a;
+		else { Usage(); return 1; }
+	}
+	if (!spec) { Usage(); return 1; }
+	if (bench) return Bench (atoi (strrchr (spec, ':') ? strrchr (spec, ':')+1 : spec), nfast, nsample, batch, flush_ms, queue, hz);
+
+	int fd = Connect (spec);
+	if (fd < 0) {
+		fprintf (stderr, "fdnet: cannot connect to %s\n", spec);
+		return 1;
+	}
+	Decoder d;
+	std::vector<int> out;
+	bool mapped = false;
+	long long last = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	static char b[65536];
+	for (;;) {
+		ssize_t n = recv (fd, b, sizeof(b), 0);
+		if (n <= 0) break;
+		bool stop = false;
+		bool ok = d.Feed (b, n, [&](double t, const float *v) {
+			if (stop) return;
+			if (!mapped) {
+				out.clear();
+				if (cols.empty()) for (unsigned c = 0; c < d.nchan; c++) out.push_back (c);
+				for (size_t k = 0; k < cols.size(); k++) {
+					auto it = std::find (d.name.begin(), d.name.end(), cols[k]);
+					if (it != d.name.end()) out.push_back ((int)(it - d.name.begin()));
+					else fprintf (stderr, "fdnet: channel %s is not streamed\n", cols[k].c_str());
+				}
+				mapped = true;
+			}
+			if (!quiet) {
+				printf ("%.10g", t);
+				for (size_t k = 0; k < out.size(); k++) printf (" %g", v[out[k]]);
+				putchar ('\n');
+			}
+			if (count >= 0 && (long long)d.samples >= count) stop = true;
+		});
+		if (!ok) {
+			fprintf (stderr, "fdnet: not a telemetry stream\n");
+			break;
+		}
+		if (quiet && Seconds (t0) >= 1.0) {
+			fprintf (stderr, "%lld samples/s, %llu frames, %llu samples lost\n",
+				(long long)d.samples-last, d.frames, d.lost);
+			last = d.samples;
+			t0 = std::chrono::steady_clock::now();
+		}
+		if (stop) break;
+	}
+	fflush (stdout);
+	close (fd);
+	if (d.lost) fprintf (stderr, "fdnet: %llu samples lost\n", d.lost);
+	return 0;
+}
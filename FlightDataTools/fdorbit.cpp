@@ -0,0 +1,153 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdorbit.cpp
+// Orbital elements of state vectors, as the recorder logs them.
+//
+// Reads lines of "t x y z vx vy vz" (position and velocity relative to
+// the reference body, Orbiter's frame) and prints the orbit channels of
+// each. --bench times the element kernel one vector at a time, as the
+// recorder calls it for each capture, and in batches.
+// ==============================================================
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "..//FlightDataCommon//OrbitElements.h"
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdorbit [options] [file]\n"
+		"  reads \"t x y z vx vy vz\" lines (m, m/s) from file or stdin and prints\n"
+		"  t orb_apo orb_peri orb_ecc orb_inc orb_t_apo orb_energy\n"
+		"  -g GM       gravitational parameter (default Earth, 3.986004e14 m^3/s^2)\n"
+		"  -r R        body radius for the altitudes (default 6371010 m)\n"
+		"  -p X,Y,Z    rotation axis of the body (default 0,1,0: equatorial frame)\n"
+		"  -d C        output delimiter (default: space)\n"
+		"  --bench     time the kernel on random state vectors:\n"
+		"    -n N      vectors (default 1000000)\n");
+}
+
+static double Seconds (std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+}
+
+static void Print (double t, const double *e, char delim)
+{
+	printf ("%g%c%g%c%g%c%g%c%g%c%g%c%g\n", t, delim, e[OE_APO], delim, e[OE_PERI], delim,
+		e[OE_ECC], delim, e[OE_INC], delim, TimeToApoapsis (e[OE_MANOM], e[OE_PERIOD]), delim,
+		e[OE_ENERGY]);
+}
+
+// elements of random orbits from 200 km circular to escape, at random
+// inclinations and phases, one vector at a time and in one batch
+static int Bench (const OrbitBody &b, long n)
+{
+	std::vector<double> sv[6], res[2][NORBIT];
+	double *out[2][NORBIT];
+	int k;
+	for (k = 0; k < 6; k++) sv[k].resize (n);
+	for (k = 0; k < NORBIT; k++) {
+		res[0][k].resize (n), res[1][k].resize (n);
+		out[0][k] = res[0][k].data(), out[1][k] = res[1][k].data();
+	}
+	srand (1);
+	for (long i = 0; i < n; i++) {
+		double r = b.radius + 2e5 + 4e7*rand()/RAND_MAX;
+		double v = sqrt (b.gm/r)*(0.8 + 0.65*rand()/RAND_MAX);
+		double ph = 6.283185307179586*rand()/RAND_MAX, inc = 3.141592653589793*rand()/RAND_MAX;
+		double fpa = 0.3*(2.0*rand()/RAND_MAX - 1.0);
+		sv[0][i] = r*cos (ph), sv[1][i] = 0.0, sv[2][i] = r*sin (ph);
+		sv[3][i] = v*(sin (fpa)*cos (ph) - cos (fpa)*sin (ph)*cos (inc));
+		sv[4][i] = v*cos (fpa)*sin (inc);
+		sv[5][i] = v*(sin (fpa)*sin (ph) + cos (fpa)*cos (ph)*cos (inc));
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (long i = 0; i < n; i++) {
+		StateVectors s = {&sv[0][i], &sv[1][i], &sv[2][i], &sv[3][i], &sv[4][i], &sv[5][i]};
+		double *o[NORBIT];
+		for (k = 0; k < NORBIT; k++) o[k] = out[0][k]+i;
+		OrbitElements (b, s, 1, o);
+	}
+	double t1 = Seconds (t0);
+
+	t0 = std::chrono::steady_clock::now();
+	StateVectors s = {sv[0].data(), sv[1].data(), sv[2].data(), sv[3].data(), sv[4].data(), sv[5].data()};
+	OrbitElements (b, s, (int)n, out[1]);
+	double tn = Seconds (t0);
+
+	long differ = 0, unbound = 0;
+	for (long i = 0; i < n; i++) {
+		for (k = 0; k < NORBIT; k++)
+			if (res[0][k][i] != res[1][k][i]) { differ++; break; }
+		if (res[1][OE_PERIOD][i] == 0.0) unbound++;
+	}
+	fprintf (stderr, "%ld vectors (%ld unbound)\n", n, unbound);
+	fprintf (stderr, "one at a time  %8.1f ns/vector\n", t1*1e9/n);
+	fprintf (stderr, "batch          %8.1f ns/vector\n", tn*1e9/n);
+	fprintf (stderr, "per capture at 100 Hz: %.4f%% of the sim time\n", t1/n*100.0*100.0);
+	fprintf (stderr, "%s\n", differ ? "RESULTS DIFFER" : "same results");
+	return differ ? 1 : 0;
+}
+
+int main (int argc, char *argv[])
+{
+	OrbitBody b = {3.986004418e14, 6.37101e6, {0.0, 1.0, 0.0}};
+	const char *path = 0;
+	char delim = ' ';
+	bool bench = false;
+	long n = 1000000;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-g") && i+1 < argc) b.gm = atof (argv[++i]);
+		else if (!strcmp (a, "-r") && i+1 < argc) b.radius = atof (argv[++i]);
+		else if (!strcmp (a, "-p") && i+1 < argc) {
+			double p[3];
+			if (sscanf (argv[++i], "%lf,%lf,%lf", p, p+1, p+2) != 3) { Usage(); return 1; }
+			double l = sqrt (p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+			if (l <= 0.0) { Usage(); return 1; }
+			for (int k = 0; k < 3; k++) b.pole[k] = p[k]/l;
+		}
+		else if (!strcmp (a, "-d") && i+1 < argc) delim = argv[++i][0];
+		else if (!strcmp (a, "--bench")) bench = true;
+		else if (!strcmp (a, "-n") && i+1 < argc) n = atol (argv[++i]);
+		else if (a[0] == '-') { Usage(); return 1; }
+		else if (!path) path = a;
+		else { Usage(); return 1; }
+	}
+	if (b.gm <= 0.0 || !delim) { Usage(); return 1; }
+	if (bench) return (n > 0 ? Bench (b, n) : 1);
+
+	FILE *f = (path ? fopen (path, "r") : stdin);
+	if (!f) {
+		fprintf (stderr, "fdorbit: cannot open %s\n", path);
+		return 1;
+	}
+	char line[1024];
+	while (fgets (line, sizeof(line), f)) {
+		double v[7], e[NORBIT], *o[NORBIT];
+		char *s = line, *end;
+		int m;
+		for (m = 0; m < 7; m++, s = end) {
+			while (*s == ',' || *s == ';') s++;
+			v[m] = strtod (s, &end);
+			if (end == s) break;
+		}
+		if (m < 7) continue;                     // header or comment
+		StateVectors sv = {v+1, v+2, v+3, v+4, v+5, v+6};
+		for (m = 0; m < NORBIT; m++) o[m] = e+m;
+		OrbitElements (b, sv, 1, o);
+		Print (v[0], e, delim);
+	}
+	if (path) fclose (f);
+	return 0;
+}
@@ -0,0 +1,390 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdplot.cpp
+// Renders channel pairs of a whole flight log to PNG/PPM images.
+//
+// The log is streamed twice (ranges, then drawing) in line-aligned
+// byte ranges by parallel workers. Each plot is reduced per pixel column
+// to the min/max of every run of consecutive samples that fall into the
+// same column, so the drawn path keeps its order and memory does not
+// depend on the log size. No display is needed.
+// ==============================================================
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LogFormat.h"
+#include "LogReader.h"
+#include "..//FlightDataCommon//RasterSurface.h"
+
+struct PlotSpec {
+	int cx, cy;           // abscissa and ordinate columns
+	std::string title;
+};
+
+// the plots of the FlightDataRec MFD pages
+static const struct {
+	const char *title;
+	int cx, cy;
+} mfdplot[] = {
+	{"Vtan/Alt",   C_V_TAN,    C_ALT},
+	{"Vrad/Alt",   C_V_RAD,    C_ALT},
+	{"Vert acc",   C_SIM_TIME, C_A_RAD},
+	{"Alt/Range",  C_DIST,     C_ALT},
+	{"Vtan/Range", C_DIST,     C_V_TAN},
+	{"Tan acc",    C_SIM_TIME, C_A_TAN}
+};
+const int NMFDPLOT = sizeof(mfdplot)/sizeof(mfdplot[0]);
+
+static struct {
+	int w, h;             // image size
+	int nthread;
+	char delim;
+	bool ppm;
+	std::string prefix;   // output file prefix
+} opt;
+
+// plot area inside the image
+static int px0, py0, pw, ph;
+
+// per-plot coverage plane of the plot area, shared by the workers
+struct Plane {
+	std::atomic<unsigned char> *px;
+	double xmin, xmax, ymin, ymax;
+
+	void Mark (int x, int y)
+	{
+		if ((unsigned)x < (unsigned)pw && (unsigned)y < (unsigned)ph)
+			px[y*pw+x].store (1, std::memory_order_relaxed);
+	}
+	void Span (int x, int y0, int y1)
+	{
+		if ((unsigned)x >= (unsigned)pw) return;
+		if (y0 < 0) y0 = 0;
+		if (y1 >= ph) y1 = ph-1;
+		for (int y = y0; y <= y1; y++) px[y*pw+x].store (1, std::memory_order_relaxed);
+	}
+	void Line (int x0, int y0, int x1, int y1)
+	{
+		double fx0 = x0, fy0 = y0, fx1 = x1, fy1 = y1;
+		if (!ClipSegment (fx0, fy0, fx1, fy1, pw, ph)) return;
+		x0 = (int)(fx0+0.5), y0 = (int)(fy0+0.5), x1 = (int)(fx1+0.5), y1 = (int)(fy1+0.5);
+		int dx = abs (x1-x0), sx = (x0 < x1 ? 1 : -1);
+		int dy = -abs (y1-y0), sy = (y0 < y1 ? 1 : -1);
+		int err = dx+dy;
+		for (;;) {
+			Mark (x0, y0);
+			if (x0 == x1 && y0 == y1) break;
+			int e2 = 2*err;
+			if (e2 >= dy) err += dy, x0 += sx;
+			if (e2 <= dx) err += dx, y0 += sy;
+		}
+	}
+	int X (double v) const { return (int)floor ((v-xmin)/(xmax-xmin)*(pw-1)+0.5); }
+	int Y (double v) const { return ph-1-(int)floor ((v-ymin)/(ymax-ymin)*(ph-1)+0.5); }
+};
+
+// streaming per-column min/max of a plot path
+struct Run {
+	bool valid;
+	int x, ymin, ymax, ylast;   // current column and its extent
+	bool first;
+	int fx, fy;                 // first point of the worker's range
+
+	void Reset () { valid = false; first = true; }
+	void Flush (Plane &pl)
+	{
+		if (valid) pl.Span (x, ymin, ymax);
+	}
+	void Add (Plane &pl, int px, int py)
+	{
+		if (first) fx = px, fy = py, first = false;
+		if (valid && px == x) {
+			if (py < ymin) ymin = py;
+			if (py > ymax) ymax = py;
+		} else {
+			if (valid) {
+				pl.Span (x, ymin, ymax);
+				pl.Line (x, ylast, px, py);
+			}
+			x = px, ymin = ymax = py;
+			valid = true;
+		}
+		ylast = py;
+	}
+	void Gap (Plane &pl)
+	{
+		Flush (pl);
+		valid = false;
+	}
+};
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdplot [options] flight-log.dat\n"
+		"  -p X,Y      plot column Y against column X (names as in Column_list.txt,\n"
+		"              without ves_ prefix, or MFD labels such as Vtan, Alt, RTT)\n"
+		"  -m          the six MFD plots (default if no -p is given)\n"
+		"  -s WxH      image size (default 640x480)\n"
+		"  -o PREFIX   output file prefix (default: log file name)\n"
+		"  -d C        field delimiter (default: any of space tab , ; |)\n"
+		"  -j N        worker threads (default: number of cores)\n"
+		"  --ppm       write PPM instead of PNG\n");
+}
+
+// ---------------------------------------------------------------------
+// pass 1: value range of every column
+
+struct Range {
+	double mn[NCOL], mx[NCOL];
+	long long n;
+};
+
+static void RangeWorker (const char *path, long long b, long long e, Range *r)
+{
+	LogReader rd;
+	double row[NCOL];
+	for (int c = 0; c < NCOL; c++) r->mn[c] = HUGE_VAL, r->mx[c] = -HUGE_VAL;
+	r->n = 0;
+	if (!rd.Open (path, b, e)) return;
+	rd.SetDelim (opt.delim);
+	int n;
+	while ((n = rd.Next (row, NCOL)) >= 0) {
+		if (n > NCOL) n = NCOL;
+		for (int c = 0; c < n; c++) {
+			if (row[c] < r->mn[c]) r->mn[c] = row[c];
+			if (row[c] > r->mx[c]) r->mx[c] = row[c];
+		}
+		r->n++;
+	}
+}
+
+// ---------------------------------------------------------------------
+// pass 2: draw the paths into the coverage planes
+
+struct Ends {
+	std::vector<Run> run;   // per plot
+};
+
+static void DrawWorker (const char *path, long long b, long long e,
+	std::vector<PlotSpec> *spec, std::vector<Plane> *plane, Ends *ends)
+{
+	LogReader rd;
+	double row[NCOL];
+	size_t np = spec->size(), k;
+	ends->run.resize (np);
+	for (k = 0; k < np; k++) ends->run[k].Reset();
+	if (!rd.Open (path, b, e)) return;
+	rd.SetDelim (opt.delim);
+	int n;
+	while ((n = rd.Next (row, NCOL)) >= 0) {
+		for (k = 0; k < np; k++) {
+			const PlotSpec &s = (*spec)[k];
+			Plane &pl = (*plane)[k];
+			Run &r = ends->run[k];
+			if (s.cx >= n || s.cy >= n || std::isnan (row[s.cx]) || std::isnan (row[s.cy])) {
+				r.Gap (pl);
+				continue;
+			}
+			r.Add (pl, pl.X (row[s.cx]), pl.Y (row[s.cy]));
+		}
+	}
+	for (k = 0; k < np; k++) ends->run[k].Flush ((*plane)[k]);
+}
+
+// ---------------------------------------------------------------------
+// image output, in the style of the MFD graphs
+
+static double NiceStep (double range, int nmax)
+{
+	double raw = range/nmax, mag = pow (10.0, floor (log10 (raw)));
+	double f = raw/mag;
+	return (f <= 1.0 ? 1.0 : f <= 2.0 ? 2.0 : f <= 5.0 ? 5.0 : 10.0)*mag;
+}
+
+static void AxisTitle (char *buf, int c)
+{
+	if (logcol[c].unit[0]) sprintf (buf, "%s: %s", logcol[c].label, logcol[c].unit);
+	else strcpy (buf, logcol[c].label);
+}
+
+static bool WriteImage (const PlotSpec &s, const Plane &pl, long long nsample)
+{
+	const SurfColor bg = 0x000000, grid = 0x303030, axis = 0x00c000, text = 0xc0c0c0, trace = 0x00ffff;
+	RasterSurface img (opt.w, opt.h);
+	char cbuf[256];
+	double v, step;
+	int x, y;
+
+	img.Fill (0, 0, opt.w, opt.h, bg);
+
+	// grid and tick labels
+	step = NiceStep (pl.xmax-pl.xmin, 8);
+	for (v = ceil (pl.xmin/step)*step; v <= pl.xmax+step*1e-6; v += step) {
+		x = px0 + pl.X (v);
+		img.Line (x, py0, x, py0+ph, grid);
+		sprintf (cbuf, "%g", fabs (v) < step*1e-6 ? 0.0 : v);
+		img.Text (x, py0+ph+4, cbuf, text, TXT_CENTER);
+	}
+	step = NiceStep (pl.ymax-pl.ymin, 8);
+	for (v = ceil (pl.ymin/step)*step; v <= pl.ymax+step*1e-6; v += step) {
+		y = py0 + pl.Y (v);
+		img.Line (px0, y, px0+pw, y, grid);
+		sprintf (cbuf, "%g", fabs (v) < step*1e-6 ? 0.0 : v);
+		img.Text (px0-4, y-4, cbuf, text, TXT_RIGHT);
+	}
+	SurfPoint frame[5] = {{px0, py0}, {px0, py0+ph}, {px0+pw, py0+ph}, {px0+pw, py0}, {px0, py0}};
+	img.Polyline (frame, 5, axis);
+
+	// trace
+	for (y = 0; y < ph; y++)
+		for (x = 0; x < pw; x++)
+			if (pl.px[y*pw+x].load (std::memory_order_relaxed))
+				img.Fill (px0+x, py0+y, 1, 1, trace);
+
+	// titles
+	sprintf (cbuf, "%s  (%lld samples)", s.title.c_str(), nsample);
+	img.Text (opt.w/2, 4, cbuf, text, TXT_CENTER);
+	AxisTitle (cbuf, s.cx);
+	img.Text (px0+pw/2, opt.h-RasterSurface::CHAR_H-2, cbuf, text, TXT_CENTER);
+	AxisTitle (cbuf, s.cy);
+	img.Text (2, py0+ph/2, cbuf, text, TXT_CENTER, true);
+
+	std::string name = opt.prefix + "-";
+	for (size_t i = 0; i < s.title.size(); i++) {
+		char c = s.title[i];
+		name += (isalnum ((unsigned char)c) ? c : '_');
+	}
+	name += (opt.ppm ? ".ppm" : ".png");
+	bool ok = (opt.ppm ? img.WritePPM (name.c_str()) : img.WritePNG (name.c_str()));
+	if (ok) printf ("%s\n", name.c_str());
+	else fprintf (stderr, "fdplot: cannot write %s\n", name.c_str());
+	return ok;
+}
+
+int main (int argc, char *argv[])
+{
+	std::vector<PlotSpec> spec;
+	const char *path = 0;
+	bool mfd = false;
+	int i, k;
+
+	opt.w = 640, opt.h = 480;
+	opt.nthread = (int)std::thread::hardware_concurrency();
+	opt.delim = 0;
+	opt.ppm = false;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-p") && i+1 < argc) {
+			char x[64], y[64];
+			if (sscanf (argv[++i], "%63[^,],%63s", x, y) != 2) { Usage(); return 1; }
+			PlotSpec s;
+			s.cx = FindColumn (x);
+			s.cy = FindColumn (y);
+			if (s.cx < 0 || s.cy < 0) {
+				fprintf (stderr, "fdplot: unknown column in %s\n", argv[i]);
+				return 1;
+			}
+			s.title = std::string (logcol[s.cy].label) + "/" + logcol[s.cx].label;
+			spec.push_back (s);
+		} else if (!strcmp (a, "-m")) mfd = true;
+		else if (!strcmp (a, "-s") && i+1 < argc) {
+			if (sscanf (argv[++i], "%dx%d", &opt.w, &opt.h) != 2 || opt.w < 100 || opt.h < 80) { Usage(); return 1; }
+		}
+		else if (!strcmp (a, "-o") && i+1 < argc) opt.prefix = argv[++i];
+		else if (!strcmp (a, "-d") && i+1 < argc) opt.delim = argv[++i][0];
+		else if (!strcmp (a, "-j") && i+1 < argc) opt.nthread = atoi (argv[++i]);
+		else if (!strcmp (a, "--ppm")) opt.ppm = true;
+		else if (a[0] == '-') { Usage(); return 1; }
+		else path = a;
+	}
+	if (!path) { Usage(); return 1; }
+	if (mfd || spec.empty()) {
+		for (k = 0; k < NMFDPLOT; k++) {
+			PlotSpec s = {mfdplot[k].cx, mfdplot[k].cy, mfdplot[k].title};
+			spec.push_back (s);
+		}
+	}
+	if (opt.nthread < 1) opt.nthread = 1;
+	if (opt.prefix.empty()) {
+		opt.prefix = path;
+		size_t dot = opt.prefix.find_last_of ('.');
+		if (dot != std::string::npos && opt.prefix.find_first_of ("/\\", dot) == std::string::npos)
+			opt.prefix.erase (dot);
+	}
+
+	std::vector<long long> off;
+	if (!LogReader::Split (path, opt.nthread, off)) {
+		fprintf (stderr, "fdplot: cannot open %s\n", path);
+		return 1;
+	}
+	int nseg = (int)off.size()-1;
+	std::vector<std::thread> th;
+
+	// pass 1
+	std::vector<Range> rng(nseg);
+	for (k = 0; k < nseg; k++) th.emplace_back (RangeWorker, path, off[k], off[k+1], &rng[k]);
+	for (k = 0; k < nseg; k++) th[k].join();
+	th.clear();
+	Range all = rng[0];
+	for (all.n = 0, k = 0; k < nseg; k++) {
+		for (i = 0; i < NCOL; i++) {
+			if (rng[k].mn[i] < all.mn[i]) all.mn[i] = rng[k].mn[i];
+			if (rng[k].mx[i] > all.mx[i]) all.mx[i] = rng[k].mx[i];
+		}
+		all.n += rng[k].n;
+	}
+	if (!all.n) {
+		fprintf (stderr, "fdplot: no samples in %s\n", path);
+		return 1;
+	}
+
+	// plot area and planes
+	px0 = 8*RasterSurface::CHAR_W+14;
+	py0 = RasterSurface::CHAR_H+10;
+	pw  = opt.w-px0-12;
+	ph  = opt.h-py0-2*RasterSurface::CHAR_H-12;
+	std::vector<Plane> plane(spec.size());
+	for (k = 0; k < (int)spec.size(); k++) {
+		Plane &pl = plane[k];
+		pl.px = new std::atomic<unsigned char>[(size_t)pw*ph];
+		for (i = 0; i < pw*ph; i++) pl.px[i].store (0, std::memory_order_relaxed);
+		pl.xmin = all.mn[spec[k].cx], pl.xmax = all.mx[spec[k].cx];
+		pl.ymin = all.mn[spec[k].cy], pl.ymax = all.mx[spec[k].cy];
+		if (!(pl.xmax > pl.xmin)) pl.xmin -= 0.5, pl.xmax += 0.5;
+		if (!(pl.ymax > pl.ymin)) pl.ymin -= 0.5, pl.ymax += 0.5;
+	}
+
+	// pass 2, then join the paths across the range boundaries
+	std::vector<Ends> ends(nseg);
+	for (k = 0; k < nseg; k++) th.emplace_back (DrawWorker, path, off[k], off[k+1], &spec, &plane, &ends[k]);
+	for (k = 0; k < nseg; k++) th[k].join();
+	th.clear();
+	for (k = 1; k < nseg; k++)
+		for (i = 0; i < (int)spec.size(); i++) {
+			const Run &a = ends[k-1].run[i], &b = ends[k].run[i];
+			if (a.valid && !b.first) plane[i].Line (a.x, a.ylast, b.fx, b.fy);
+		}
+
+	// images, one worker per plot
+	std::vector<char> ok(spec.size());
+	for (k = 0; k < (int)spec.size(); k++)
+		th.emplace_back ([&, k] { ok[k] = WriteImage (spec[k], plane[k], all.n); });
+	for (auto &t: th) t.join();
+
+	int fail = 0;
+	for (k = 0; k < (int)spec.size(); k++) {
+		if (!ok[k]) fail++;
+		delete []plane[k].px;
+	}
+	return fail ? 1 : 0;
+}
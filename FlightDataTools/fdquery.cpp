@@ -0,0 +1,139 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdquery.cpp
+// Selects the samples of a chunked log (see fdindex) that satisfy all
+// of a set of column predicates.
+//
+// Chunks whose min/max rule out a predicate are skipped without reading
+// their data; the others are filtered column by column. --bench runs
+// the query with and without pruning and compares the two.
+// ==============================================================
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "LogFormat.h"
+#include "ChunkLog.h"
+#include "Query.h"
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdquery [options] log.fdx PREDICATE...\n"
+		"  PREDICATE is COLUMN OP VALUE with OP one of < <= > >= = !=, e.g.\n"
+		"  \"mach>5\" \"atm_dynp>20000\"; all predicates must hold\n"
+		"  -c COLS     output columns, comma separated (default: all)\n"
+		"  -n          print the number of matching samples only\n"
+		"  --noskip    do not use the chunk min/max (full scan)\n"
+		"  --bench     time the query with and without chunk skipping\n"
+		"  -v          report chunk and I/O statistics on stderr\n");
+}
+
+struct Result {
+	long long rows, skipped, scanned, bytes;
+	double sec;
+};
+
+static bool RunQuery (const char *path, const std::vector<Predicate> &pred, bool prune,
+	const std::vector<int> *out, Result &r)
+{
+	ChunkLogReader rd;
+	if (!rd.Open (path)) {
+		fprintf (stderr, "fdquery: cannot open %s\n", path);
+		return false;
+	}
+	ChunkQuery q (rd);
+	for (size_t j = 0; j < pred.size(); j++) q.Add (pred[j]);
+	q.SetPruning (prune);
+
+	auto t0 = std::chrono::steady_clock::now();
+	std::vector<const float*> oc(out ? out->size() : 0);
+	r.rows = 0;
+	for (int k = 0; k < rd.Chunks(); k++) {
+		int m = q.Run (k);
+		if (m < 0) {
+			fprintf (stderr, "fdquery: read error in chunk %d\n", k);
+			return false;
+		}
+		r.rows += m;
+		if (!m || !out) continue;
+		size_t j;
+		for (j = 0; j < out->size(); j++)
+			if (!(oc[j] = q.Column (k, (*out)[j]))) return false;
+		const unsigned char *mask = q.Mask();
+		for (int i = 0; i < rd.Rows (k); i++) {
+			if (!mask[i]) continue;
+			for (j = 0; j < oc.size(); j++) printf (j ? " %g" : "%g", oc[j][i]);
+			putchar ('\n');
+		}
+	}
+	r.sec = std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+	r.skipped = q.Skipped();
+	r.scanned = q.Scanned();
+	r.bytes = rd.BytesRead();
+	return true;
+}
+
+static void Report (const char *what, const Result &r)
+{
+	fprintf (stderr, "%-9s %lld matches, %lld chunks scanned, %lld skipped, %.1f MB read, %.3f s\n",
+		what, r.rows, r.scanned, r.skipped, r.bytes/1048576.0, r.sec);
+}
+
+int main (int argc, char *argv[])
+{
+	std::vector<Predicate> pred;
+	std::vector<int> out;
+	const char *path = 0;
+	bool count = false, prune = true, bench = false, verbose = false;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-c") && i+1 < argc) {
+			char *list = argv[++i], *tok;
+			for (tok = strtok (list, ","); tok; tok = strtok (0, ",")) {
+				int c = FindColumn (tok);
+				if (c < 0) {
+					fprintf (stderr, "fdquery: unknown column %s\n", tok);
+					return 1;
+				}
+				out.push_back (c);
+			}
+		}
+		else if (!strcmp (a, "-n")) count = true;
+		else if (!strcmp (a, "--noskip")) prune = false;
+		else if (!strcmp (a, "--bench")) bench = true;
+		else if (!strcmp (a, "-v")) verbose = true;
+		else if (a[0] == '-' && !strpbrk (a, "<>=")) { Usage(); return 1; }
+		else if (!path) path = a;
+		else {
+			Predicate p;
+			if (!ParsePredicate (a, p)) {
+				fprintf (stderr, "fdquery: bad predicate %s\n", a);
+				return 1;
+			}
+			pred.push_back (p);
+		}
+	}
+	if (!path) { Usage(); return 1; }
+	if (out.empty()) for (i = 0; i < NCOL; i++) out.push_back (i);
+
+	Result r, f;
+	if (bench) {
+		if (!RunQuery (path, pred, false, 0, f) || !RunQuery (path, pred, true, 0, r)) return 1;
+		Report ("full scan", f);
+		Report ("pruned", r);
+		fprintf (stderr, "speedup %.1fx, %s\n", f.sec/r.sec, f.rows == r.rows ? "same result" : "RESULTS DIFFER");
+		return f.rows == r.rows ? 0 : 1;
+	}
+	if (!RunQuery (path, pred, prune, count ? 0 : &out, r)) return 1;
+	if (count) printf ("%lld\n", r.rows);
+	if (verbose) Report (prune ? "pruned" : "full scan", r);
+	return 0;
+}
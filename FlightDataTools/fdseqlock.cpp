@@ -0,0 +1,213 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdseqlock.cpp
+// Stress test of the sequence lock between the sampler and the renderers.
+//
+// One writer stores samples into a ring laid out like the recorder's,
+// purging it now and then, under SeqLock as the sampler does; a number
+// of readers take snapshots of it as the MFD and the CFD graphs do, and
+// check every snapshot against what the writer can have stored. A read
+// overlaps a write when the sequence moves while the snapshot is copied;
+// only those can tear, so the writer runs until the readers have seen
+// enough of them. Exits with 1 on a torn snapshot, 2 if too few reads
+// overlapped a write to tell. With -x (and -u) the test is reversed: it
+// passes when a torn snapshot is caught, and exits with 77 (skipped)
+// when none could be.
+// ==============================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "..//FlightDataCommon//SeqLock.h"
+
+static const int NDATA = 2048;  // ring slots, as the recorder's
+static const int NCH = 6;       // channels (the MFD snapshot copies six)
+static const long MOD = 1000003;  // sample numbers are stored modulo this, exact in a float
+
+// the protected data: a sample ring and its header
+static struct {
+	int sample;   // slot of the next sample
+	int count;    // valid samples
+	long total;   // samples stored since the last purge
+	float ch[NCH][NDATA];
+} g_Ring;
+static SeqLock g_Lock;
+static bool g_Unlocked = false;  // readers skip the retry
+static bool g_Yield = false;     // readers yield halfway through their first copy
+static std::atomic<long> g_Overlaps (0);  // reads the writer moved the sequence under
+static std::atomic<long> g_Torn (0);
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdseqlock [options]\n"
+		"  -r N        readers (default 6)\n"
+		"  -n N        samples to store at least (default 20000000)\n"
+		"  -p N        purge the ring every N samples (default 1000000, 0: never)\n"
+		"  -m N        go on until N reads overlapped a write (default 0)\n"
+		"  -t SEC      stop after SEC seconds in any case (default 60)\n"
+		"  -y          readers yield halfway through a copy, so writes land in\n"
+		"              reads even on a single CPU\n"
+		"  -u          readers ignore the lock, to see the check catch torn reads\n"
+		"  -x          expect torn reads: with -u, pass once one is caught\n");
+}
+
+static double Seconds (std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+}
+
+// value of channel c for sample number n
+static inline float Value (long n, int c)
+{
+	return (float)(n % MOD + c);
+}
+
+// store samples until at least nsample are stored and minover reads
+// overlapped a write, or tmax seconds passed; returns the samples stored.
+// Looking for a torn read, stop at the first one instead
+static long Writer (long nsample, long purge, long minover, double tmax, bool expect)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	long n, k;
+	for (n = 0, k = 0; ; n++) {
+		if (!expect && n >= nsample && g_Overlaps.load (std::memory_order_relaxed) >= minover) break;
+		if (!(n & 4095)) {
+			if (Seconds (t0) >= tmax) break;
+			if (expect && g_Torn.load (std::memory_order_relaxed)) break;
+		}
+		g_Lock.WriteBegin();
+		if (purge && n && n % purge == 0) {
+			g_Ring.sample = g_Ring.count = 0;
+			g_Ring.total = 0;
+			memset (g_Ring.ch, 0, sizeof(g_Ring.ch));
+			k = 0;
+		}
+		int i = g_Ring.sample;
+		for (int c = 0; c < NCH; c++) g_Ring.ch[c][i] = Value (k, c);
+		g_Ring.sample = (i+1) % NDATA;
+		if (g_Ring.count < NDATA) g_Ring.count++;
+		g_Ring.total = ++k;
+		g_Lock.WriteEnd();
+	}
+	return n;
+}
+
+struct ReaderStats {
+	long snaps, retries, overlaps, torn;
+};
+
+// a snapshot is whole if the header agrees with itself and every valid
+// slot holds the sample the header says it must, in every channel
+static bool Check (int sample, int count, long total, const float (*ch)[NDATA])
+{
+	if (total < count || sample != total % NDATA || count != (total < NDATA ? total : NDATA))
+		return false;
+	for (int j = 0; j < count; j++) {
+		int i = (sample - 1 - j + NDATA) % NDATA;
+		long n = total - 1 - j;
+		for (int c = 0; c < NCH; c++)
+			if (ch[c][i] != Value (n, c)) return false;
+	}
+	return true;
+}
+
+static void Reader (const std::atomic<bool> *done, ReaderStats *st)
+{
+	static thread_local float ch[NCH][NDATA];
+	int sample, count;
+	long total;
+	unsigned s;
+	bool moved;
+	st->snaps = st->retries = st->overlaps = st->torn = 0;
+	while (!done->load (std::memory_order_relaxed)) {
+		int tries = 0;
+		do {
+			if (tries++) st->retries++;
+			s = g_Lock.ReadBegin();
+			sample = g_Ring.sample, count = g_Ring.count, total = g_Ring.total;
+			if (g_Yield && tries == 1) {
+				// no yield on a retry: a reader that always lets the writer
+				// in would never get a clean copy on one CPU
+				memcpy (ch, g_Ring.ch, sizeof(ch)/2);
+				std::this_thread::yield();
+				memcpy (ch[NCH/2], g_Ring.ch[NCH/2], sizeof(ch)/2);
+			} else memcpy (ch, g_Ring.ch, sizeof(ch));
+			if ((moved = g_Lock.ReadRetry (s))) {
+				st->overlaps++;
+				g_Overlaps.fetch_add (1, std::memory_order_relaxed);
+			}
+		} while (!g_Unlocked && moved);
+		st->snaps++;
+		if (!Check (sample, count, total, ch)) {
+			st->torn++;
+			g_Torn.fetch_add (1, std::memory_order_relaxed);
+		}
+	}
+}
+
+int main (int argc, char *argv[])
+{
+	int nreader = 6;
+	long nsample = 20000000, purge = 1000000, minover = 0;
+	double tmax = 60.0;
+	bool expect = false;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-r") && i+1 < argc) nreader = atoi (argv[++i]);
+		else if (!strcmp (a, "-n") && i+1 < argc) nsample = atol (argv[++i]);
+		else if (!strcmp (a, "-p") && i+1 < argc) purge = atol (argv[++i]);
+		else if (!strcmp (a, "-m") && i+1 < argc) minover = atol (argv[++i]);
+		else if (!strcmp (a, "-t") && i+1 < argc) tmax = atof (argv[++i]);
+		else if (!strcmp (a, "-y")) g_Yield = true;
+		else if (!strcmp (a, "-u")) g_Unlocked = true;
+		else if (!strcmp (a, "-x")) expect = true;
+		else { Usage(); return 1; }
+	}
+	if (nreader < 1 || nsample < 1 || purge < 0 || minover < 0 || tmax <= 0.0 || (expect && !g_Unlocked)) {
+		Usage();
+		return 1;
+	}
+
+	std::atomic<bool> done (false);
+	std::vector<ReaderStats> st (nreader);
+	std::vector<std::thread> rd;
+	for (i = 0; i < nreader; i++) rd.emplace_back (Reader, &done, &st[i]);
+
+	auto t0 = std::chrono::steady_clock::now();
+	long nstored = Writer (nsample, purge, minover, tmax, expect);
+	double tw = Seconds (t0);
+	done.store (true);
+	for (i = 0; i < nreader; i++) rd[i].join();
+
+	long snaps = 0, retries = 0, overlaps = 0, torn = 0;
+	for (i = 0; i < nreader; i++) {
+		snaps += st[i].snaps, retries += st[i].retries;
+		overlaps += st[i].overlaps, torn += st[i].torn;
+	}
+	fprintf (stderr, "%ld samples, %d readers, %.2f s\n", nstored, nreader, tw);
+	fprintf (stderr, "writer         %8.1f ns/sample\n", tw*1e9/nstored);
+	fprintf (stderr, "snapshots      %ld (%ld retries)\n", snaps, retries);
+	fprintf (stderr, "overlapping    %ld reads\n", overlaps);
+	fprintf (stderr, "%s\n", torn ? "TORN SNAPSHOTS" : "no torn snapshots");
+	if (torn) fprintf (stderr, "%ld torn\n", torn);
+	if (expect) {
+		if (torn) return 0;
+		fprintf (stderr, "no torn read caught in %ld overlapping reads: skipped\n", overlaps);
+		return 77;
+	}
+	if (torn) return 1;
+	if (overlaps < minover) {
+		fprintf (stderr, "only %ld of %ld overlapping reads: nothing shown\n", overlaps, minover);
+		return 2;
+	}
+	return 0;
+}
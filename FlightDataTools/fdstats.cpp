@@ -0,0 +1,206 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData (tools)
+//                  Part of the ORBITER SDK
+//
+// fdstats.cpp
+// Summarises every flight log of a directory into one table.
+//
+// Each log is one task of a work-stealing pool and is read in a single
+// streaming pass. The tasks are ordered by file size, largest first, so
+// the long logs start early and the short ones fill the gaps at the end.
+// The table is written as CSV or as a binary file of SummaryRecords.
+// ==============================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LogFormat.h"
+#include "LogReader.h"
+#include "FlightSummary.h"
+#include "WorkPool.h"
+
+namespace fs = std::filesystem;
+
+static struct {
+	int nthread;
+	char delim;
+	bool binary;
+	bool verbose;
+	double airborne, tdalt;
+	const char *out;
+} opt;
+
+struct LogTask {
+	std::string path, name;
+	long long size;
+	bool ok;
+	FlightSummary s;
+};
+
+static void Usage ()
+{
+	fprintf (stderr,
+		"usage: fdstats [options] DIR|FILE...\n"
+		"  summarises the flight-log-*.dat/.csv files of each DIR and each FILE\n"
+		"  -o FILE     output file (default: stdout)\n"
+		"  -b          binary table instead of CSV (needs -o)\n"
+		"  -j N        worker threads (default: number of cores)\n"
+		"  -d C        field delimiter (default: any of space tab , ; |)\n"
+		"  -a KM       altitude above which the vessel counts as airborne (default 1)\n"
+		"  -t KM       touchdown must happen below this altitude (default 0.5)\n"
+		"  -v          report throughput on stderr\n");
+}
+
+static bool IsFlightLog (const fs::path &p)
+{
+	std::string n = p.filename().string(), ext = p.extension().string();
+	return !n.compare (0, 11, "flight-log-") && (ext == ".dat" || ext == ".csv");
+}
+
+static void Analyse (LogTask &task)
+{
+	LogReader rd;
+	FlightAnalyzer fa;
+	double row[NCOL];
+	int n;
+
+	task.ok = rd.Open (task.path.c_str());
+	if (!task.ok) return;
+	rd.SetDelim (opt.delim);
+	fa.SetTouchdown (opt.airborne, opt.tdalt);
+	while ((n = rd.Next (row, NCOL)) >= 0) fa.Add (row, n);
+	fa.Finish (task.s);
+}
+
+static void Field (FILE *f, double v)
+{
+	if (std::isnan (v)) fputs (",", f);
+	else fprintf (f, ",%.10g", v);
+}
+
+static bool WriteCSV (FILE *f, const std::vector<LogTask> &task)
+{
+	fputs ("file,samples,t_start,t_end,max_q,max_q_t,max_g,max_g_t,apo_alt,apo_t,"
+		"burns,burn_time,burn_max,hover_time,fuel_used,landed,td_t,td_vrad,td_range\n", f);
+	for (size_t i = 0; i < task.size(); i++) {
+		const FlightSummary &s = task[i].s;
+		if (!task[i].ok) continue;
+		fprintf (f, "%s,%lld", task[i].name.c_str(), s.samples);
+		Field (f, s.t_start);   Field (f, s.t_end);
+		Field (f, s.max_q);     Field (f, s.max_q_t);
+		Field (f, s.max_g);     Field (f, s.max_g_t);
+		Field (f, s.apo_alt);   Field (f, s.apo_t);
+		fprintf (f, ",%d", s.burns);
+		Field (f, s.burn_time); Field (f, s.burn_max);
+		Field (f, s.hover_time);
+		Field (f, s.fuel_used);
+		fprintf (f, ",%d", s.landed);
+		Field (f, s.td_t);      Field (f, s.td_vrad);
+		Field (f, s.td_range);
+		fputc ('\n', f);
+	}
+	return !ferror (f);
+}
+
+static bool WriteBinary (FILE *f, const std::vector<LogTask> &task)
+{
+	SummaryFileHeader h;
+	memcpy (h.magic, "FDSM", 4);
+	h.version = SUMMARY_VERSION;
+	h.count = 0;
+	h.recsize = sizeof(SummaryRecord);
+	for (size_t i = 0; i < task.size(); i++) if (task[i].ok) h.count++;
+	fwrite (&h, sizeof(h), 1, f);
+	for (size_t i = 0; i < task.size(); i++) {
+		if (!task[i].ok) continue;
+		SummaryRecord r;
+		memset (&r, 0, sizeof(r));
+		strncpy (r.file, task[i].name.c_str(), sizeof(r.file)-1);
+		r.s = task[i].s;
+		fwrite (&r, sizeof(r), 1, f);
+	}
+	return !ferror (f);
+}
+
+int main (int argc, char *argv[])
+{
+	std::vector<LogTask> task;
+	int i;
+
+	opt.nthread = (int)std::thread::hardware_concurrency();
+	opt.delim = 0;
+	opt.binary = opt.verbose = false;
+	opt.airborne = 1.0, opt.tdalt = 0.5;
+	opt.out = 0;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strcmp (a, "-o") && i+1 < argc) opt.out = argv[++i];
+		else if (!strcmp (a, "-b")) opt.binary = true;
+		else if (!strcmp (a, "-j") && i+1 < argc) opt.nthread = atoi (argv[++i]);
+		else if (!strcmp (a, "-d") && i+1 < argc) opt.delim = argv[++i][0];
+		else if (!strcmp (a, "-a") && i+1 < argc) opt.airborne = atof (argv[++i]);
+		else if (!strcmp (a, "-t") && i+1 < argc) opt.tdalt = atof (argv[++i]);
+		else if (!strcmp (a, "-v")) opt.verbose = true;
+		else if (a[0] == '-') { Usage(); return 1; }
+		else {
+			std::error_code ec;
+			fs::path p (a);
+			if (!fs::is_directory (p, ec)) {
+				task.push_back ({p.string(), p.filename().string(), 0, false, {}});
+				continue;
+			}
+			for (fs::directory_iterator it (p, ec), end; !ec && it != end; it.increment (ec))
+				if (it->is_regular_file (ec) && IsFlightLog (it->path()))
+					task.push_back ({it->path().string(), it->path().filename().string(), 0, false, {}});
+			if (ec) fprintf (stderr, "fdstats: %s: %s\n", a, ec.message().c_str());
+		}
+	}
+	if (task.empty()) { Usage(); return 1; }
+	if (opt.binary && !opt.out) { Usage(); return 1; }
+
+	// table in name order, tasks largest first
+	std::sort (task.begin(), task.end(), [](const LogTask &a, const LogTask &b) { return a.name < b.name; });
+	long long bytes = 0;
+	std::vector<int> order(task.size());
+	for (i = 0; i < (int)task.size(); i++) {
+		task[i].size = LogReader::FileSize (task[i].path.c_str());
+		if (task[i].size > 0) bytes += task[i].size;
+		order[i] = i;
+	}
+	std::stable_sort (order.begin(), order.end(), [&](int a, int b) { return task[a].size > task[b].size; });
+
+	auto t0 = std::chrono::steady_clock::now();
+	WorkPool pool (std::min (opt.nthread, (int)task.size()));
+	pool.Run ((int)order.size(), [&](int k, int) { Analyse (task[order[k]]); });
+	double sec = std::chrono::duration<double> (std::chrono::steady_clock::now()-t0).count();
+
+	int fail = 0;
+	long long rows = 0;
+	for (i = 0; i < (int)task.size(); i++) {
+		if (!task[i].ok) fprintf (stderr, "fdstats: cannot open %s\n", task[i].path.c_str()), fail++;
+		else rows += task[i].s.samples;
+	}
+
+	FILE *f = (opt.out ? fopen (opt.out, opt.binary ? "wb" : "w") : stdout);
+	if (!f) {
+		fprintf (stderr, "fdstats: cannot write %s\n", opt.out);
+		return 1;
+	}
+	bool ok = (opt.binary ? WriteBinary (f, task) : WriteCSV (f, task));
+	if (opt.out) ok = (fclose (f) == 0) && ok;
+	if (!ok) fprintf (stderr, "fdstats: write error\n");
+
+	if (opt.verbose)
+		fprintf (stderr, "%d logs, %lld rows, %.1f MB in %.3f s (%.1f MB/s, %.2f Mrows/s), %d threads, %lld steals\n",
+			(int)task.size()-fail, rows, bytes/1048576.0, sec, bytes/1048576.0/sec, rows*1e-6/sec,
+			pool.Threads(), pool.Steals());
+	return (ok && !fail) ? 0 : 1;
+}